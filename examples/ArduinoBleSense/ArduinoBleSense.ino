@@ -12,16 +12,16 @@ qrtone_t* qrtone = NULL;
 
 #define SAMPLE_RATE 41667
 
-// audio circular buffer size
+// audio circular buffer size, a power of two
 #define MAX_AUDIO_WINDOW_SIZE 512
 
 // buffer to read samples into, each sample is 16-bits
 short sampleBuffer[256];
 
-// Audio circular buffer provided to QRTone.
-static int64_t scaled_input_buffer_feed_cursor = 0;
-static int64_t scaled_input_buffer_consume_cursor = 0;
+// Audio circular buffer filled by the PDM interrupt and drained into QRTone.
 static float scaled_input_buffer[MAX_AUDIO_WINDOW_SIZE];
+static qrtone_ring_t input_ring;
+static uint32_t reported_overruns = 0;
 
 // number of samples read
 volatile int samplesRead;
@@ -41,6 +41,9 @@ void setup() {
   // Init internal state
   qrtone_init(qrtone, SAMPLE_RATE);
 
+  // Init the audio circular buffer before starting the microphone
+  qrtone_ring_init(&input_ring, scaled_input_buffer, MAX_AUDIO_WINDOW_SIZE);
+
   // Init callback method for displaying noise level for gate frequencies
   // qrtone_set_level_callback(qrtone, NULL, debug_serial);
 
@@ -112,28 +115,18 @@ void debug_serial(void *ptr, int64_t location, float first_tone_level, float sec
 }
 
 void loop() {
-  //Once the recording buffer is full, we process it.
-  if (scaled_input_buffer_feed_cursor > scaled_input_buffer_consume_cursor)
-  {
-    if(scaled_input_buffer_feed_cursor - scaled_input_buffer_consume_cursor > MAX_AUDIO_WINDOW_SIZE) {
-      // overflow
-      Serial.println("Buffer overflow");
-    }
-    int sample_to_read = scaled_input_buffer_feed_cursor - scaled_input_buffer_consume_cursor;
-    int max_window_length = qrtone_get_maximum_length(qrtone);
-    int sample_index = 0;
-    while(sample_index < sample_to_read) {
-      int32_t position_in_buffer = ((scaled_input_buffer_consume_cursor + sample_index) % MAX_AUDIO_WINDOW_SIZE);
-      int32_t window_length = min(max_window_length, min(sample_to_read - sample_index, MAX_AUDIO_WINDOW_SIZE - position_in_buffer % MAX_AUDIO_WINDOW_SIZE));
-      if(qrtone_push_samples(qrtone, scaled_input_buffer + position_in_buffer, window_length)) {
-        // Got a message
-        process_message();
-      }
-      sample_index += window_length;
-      max_window_length = qrtone_get_maximum_length(qrtone);      
-    }
-    scaled_input_buffer_consume_cursor += sample_index;
-  }  
+  // Push the recorded samples to QRTone, without copy
+  if(qrtone_ring_drain(&input_ring, qrtone)) {
+    // Got a message
+    process_message();
+  }
+  qrtone_ring_stats_t stats;
+  qrtone_ring_get_stats(&input_ring, &stats);
+  if(stats.overruns != reported_overruns) {
+    // overflow, samples have been dropped by the PDM interrupt
+    reported_overruns = stats.overruns;
+    Serial.println("Buffer overflow");
+  }
 }
 
 void onPDMdata() {
@@ -146,8 +139,5 @@ void onPDMdata() {
   // 16-bit, 2 bytes per sample
   samplesRead = bytesAvailable / 2;
 
-  for(int sample_id = 0; sample_id < samplesRead; sample_id++) {
-    scaled_input_buffer[(scaled_input_buffer_feed_cursor+sample_id) % MAX_AUDIO_WINDOW_SIZE] = (float)sampleBuffer[sample_id] / 32768.0f;
-  }
-  scaled_input_buffer_feed_cursor += samplesRead;
+  qrtone_ring_write_s16(&input_ring, sampleBuffer, samplesRead, 1);
 }
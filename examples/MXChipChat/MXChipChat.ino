@@ -33,7 +33,7 @@
 
 #define SAMPLE_SIZE 16
 
-// audio circular buffer size
+// audio circular buffer size, a power of two
 #define MAX_AUDIO_WINDOW_SIZE 512
 
 #define AUDIO_SAMPLE_SIZE 256 // AUDIO_CHUNK_SIZE / 2
@@ -56,9 +56,8 @@ static int raw_output_audio_buffer_length = 0;
 static int audio_to_play = 0; // how many samples to play
 static int cursor_audio_to_play = 0; // Total played samples
 
-// Audio circular buffer provided to QRTone.
-static int64_t scaled_input_buffer_feed_cursor = 0;
-static int64_t scaled_input_buffer_consume_cursor = 0;
+// Audio circular buffer filled by the record callback and drained into QRTone.
+static qrtone_ring_t input_ring;
 
 // Buttons state vars
 int lastButtonAState;
@@ -113,17 +112,8 @@ void process_message(void) {
 void recordCallback(void)
 {
     int32_t record_buffer_length = Audio.readFromRecordBuffer(raw_audio_buffer, AUDIO_CHUNK_SIZE);
-    char* cur_reader = &raw_audio_buffer[0];
-    char* end_reader = &raw_audio_buffer[record_buffer_length];
     const int offset = 4; // short samples size + skip right channel
-    int sample_index = 0;
-    while(cur_reader < end_reader) {
-      int16_t sample = *((int16_t *)cur_reader);
-      scaled_input_buffer[(scaled_input_buffer_feed_cursor+sample_index) % MAX_AUDIO_WINDOW_SIZE] = (float)sample / 32768.0f;
-      sample_index += 1;
-      cur_reader += offset;
-    }
-    scaled_input_buffer_feed_cursor += sample_index;
+    qrtone_ring_write_s16(&input_ring, (int16_t *)raw_audio_buffer, record_buffer_length / offset, 2);
 }
 
 void setup(void)
@@ -149,6 +139,9 @@ void setup(void)
   // Init internal state
   qrtone_init(qrtone, SAMPLE_RATE);
 
+  // Init the audio circular buffer before starting the record
+  qrtone_ring_init(&input_ring, scaled_input_buffer, MAX_AUDIO_WINDOW_SIZE);
+
   // Init callback method
   // qrtone_set_level_callback(qrtone, NULL, debug_serial);
 
@@ -167,22 +160,10 @@ void loop(void)
 
   // Processing of audio input
   // Once the recording buffer is full, we process it.
-  if (audio_to_play == 0 && scaled_input_buffer_feed_cursor > scaled_input_buffer_consume_cursor)
+  if (audio_to_play == 0 && qrtone_ring_drain(&input_ring, qrtone))
   {
-    int sample_to_read = scaled_input_buffer_feed_cursor - scaled_input_buffer_consume_cursor;
-    int max_window_length = qrtone_get_maximum_length(qrtone);
-    int sample_index = 0;
-    while(sample_index < sample_to_read) {
-      int32_t position_in_buffer = ((scaled_input_buffer_consume_cursor + sample_index) % MAX_AUDIO_WINDOW_SIZE);
-      int32_t window_length = min(max_window_length, min(sample_to_read - sample_index, MAX_AUDIO_WINDOW_SIZE - position_in_buffer % MAX_AUDIO_WINDOW_SIZE));
-      if(qrtone_push_samples(qrtone, scaled_input_buffer + position_in_buffer, window_length)) {
-        // Got a message
-        process_message();
-      }
-      sample_index += window_length;
-      max_window_length = qrtone_get_maximum_length(qrtone);      
-    }
-    scaled_input_buffer_consume_cursor += sample_index;
+    // Got a message
+    process_message();
   }
 
   // Check button actions
@@ -0,0 +1,157 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) Unité Mixte de Recherche en Acoustique Environnementale (univ-gustave-eiffel)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *  Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ *  Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/**
+ * @file ecc_gf16_bench.c
+ * @brief Decoding time of a GF(16) Reed-Solomon block with the generic and the GF(16) decoders
+ * Usage: ecc_gf16_bench [-l block_length] [-e ec_bytes] [-n passes]
+ * For each number of errors up to the capacity the same random blocks are decoded by
+ * ecc_reed_solomon_decoder_decode_bounded, ecc_reed_solomon_gf16_decode and ecc_reed_solomon_gf16_decode_batch.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "reed_solomon.h"
+
+#define BENCH_BLOCKS 1024
+#define BENCH_GENERATOR_BASE 1
+
+static void usage(void) {
+    fprintf(stderr, "Usage: ecc_gf16_bench [-l block_length] [-e ec_bytes] [-n passes]\n"
+        "  -l  symbols per block, default 12\n"
+        "  -e  ecc symbols per block, default 6\n"
+        "  -n  passes over the %d blocks, default 2000\n", BENCH_BLOCKS);
+}
+
+static double bench_now(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char** argv) {
+    int32_t block_length = 12;
+    int32_t ec_bytes = 6;
+    int32_t passes = 2000;
+    int i;
+    for (i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-l") == 0) {
+            block_length = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-e") == 0) {
+            ec_bytes = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+            passes = atoi(argv[++i]);
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (block_length > ECC_GF16_MAX_LENGTH || ec_bytes < 1 || ec_bytes >= block_length || passes < 1) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    ecc_reed_solomon_encoder_t encoder;
+    ecc_reed_solomon_encoder_init(&encoder, ECC_GF16_PRIMITIVE, 16, BENCH_GENERATOR_BASE);
+    int32_t* codewords = malloc(sizeof(int32_t) * BENCH_BLOCKS * block_length);
+    int32_t* received = malloc(sizeof(int32_t) * BENCH_BLOCKS * block_length);
+    uint8_t* batch = malloc((size_t)BENCH_BLOCKS * block_length);
+    int32_t work[ECC_GF16_MAX_LENGTH];
+    int32_t block_id;
+    int32_t j;
+    srand(1);
+    for (block_id = 0; block_id < BENCH_BLOCKS; block_id++) {
+        int32_t* codeword = codewords + block_id * block_length;
+        for (j = 0; j < block_length - ec_bytes; j++) {
+            codeword[j] = rand() % 16;
+        }
+        ecc_reed_solomon_encoder_encode(&encoder, codeword, block_length, ec_bytes);
+    }
+    printf("%d symbols, %d ecc symbols, ns per block\n", block_length, ec_bytes);
+    printf("errors  generic euclid  gf16 BM  gf16 batch\n");
+    int32_t number_of_errors;
+    int32_t failures = 0;
+    for (number_of_errors = 0; number_of_errors <= ec_bytes / 2; number_of_errors++) {
+        memcpy(received, codewords, sizeof(int32_t) * BENCH_BLOCKS * block_length);
+        for (block_id = 0; block_id < BENCH_BLOCKS; block_id++) {
+            int32_t* block = received + block_id * block_length;
+            int32_t* codeword = codewords + block_id * block_length;
+            int32_t e;
+            for (e = 0; e < number_of_errors; e++) {
+                int32_t position = rand() % block_length;
+                while (block[position] != codeword[position]) {
+                    position = (position + 1) % block_length;
+                }
+                block[position] ^= 1 + rand() % 15;
+            }
+        }
+        double timings[3];
+        int32_t method;
+        for (method = 0; method < 3; method++) {
+            int32_t pass;
+            double start = bench_now();
+            for (pass = 0; pass < passes; pass++) {
+                if (method == 2) {
+                    // The transposition into the batch layout is part of the timing
+                    for (block_id = 0; block_id < BENCH_BLOCKS; block_id++) {
+                        for (j = 0; j < block_length; j++) {
+                            batch[j * BENCH_BLOCKS + block_id] = (uint8_t)received[block_id * block_length + j];
+                        }
+                    }
+                    failures += ecc_reed_solomon_gf16_decode_batch(BENCH_GENERATOR_BASE, batch, BENCH_BLOCKS, block_length, ec_bytes, NULL, NULL);
+                    continue;
+                }
+                for (block_id = 0; block_id < BENCH_BLOCKS; block_id++) {
+                    memcpy(work, received + block_id * block_length, sizeof(int32_t) * block_length);
+                    int32_t ret = method == 0 ? ecc_reed_solomon_decoder_decode_bounded(&(encoder.field), work, block_length, ec_bytes, NULL) :
+                        ecc_reed_solomon_gf16_decode(BENCH_GENERATOR_BASE, work, block_length, ec_bytes, NULL);
+                    if (ret != ECC_NO_ERRORS || memcmp(work, codewords + block_id * block_length, sizeof(int32_t) * block_length) != 0) {
+                        failures++;
+                    }
+                }
+            }
+            timings[method] = (bench_now() - start) * 1e9 / ((double)passes * BENCH_BLOCKS);
+        }
+        printf("%6d  %14.0f  %7.0f  %10.0f\n", number_of_errors, timings[0], timings[1], timings[2]);
+    }
+    free(codewords);
+    free(received);
+    free(batch);
+    ecc_reed_solomon_encoder_free(&encoder);
+    if (failures > 0) {
+        fprintf(stderr, "%d blocks not decoded\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,559 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) Unité Mixte de Recherche en Acoustique Environnementale (univ-gustave-eiffel)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *  Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ *  Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "qrtone_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define QRTONE_POOL_CACHE_LINE 64
+#define QRTONE_POOL_DEFAULT_BLOCK_LENGTH 1024
+#define QRTONE_POOL_DEFAULT_QUEUE_BLOCKS 16
+// Blocks decoded before a busy stream goes back to the end of the run queue
+#define QRTONE_POOL_BATCH 4
+
+// Lock-free queues use the GCC and Clang __atomic builtins, the library is built as C99
+
+/**
+ * Bounded multi-producer multi-consumer queue of D. Vyukov. The cell of position p is free for a push when its
+ * sequence is p, and holds the element pushed at position p when its sequence is p + 1.
+ */
+typedef struct _qrtone_pool_queue_t {
+    int64_t enqueue_position;
+    char enqueue_padding[QRTONE_POOL_CACHE_LINE];
+    int64_t dequeue_position;
+    char dequeue_padding[QRTONE_POOL_CACHE_LINE];
+    int64_t* sequences;
+    int64_t mask;
+} qrtone_pool_queue_t;
+
+/**
+ * Samples queue and decoder of a stream
+ */
+typedef struct _qrtone_pool_stream_t {
+    qrtone_pool_queue_t queue;
+    int32_t scheduled; // 1 while the stream is in a run queue or decoded by a worker
+    char scheduled_padding[QRTONE_POOL_CACHE_LINE];
+    int32_t* lengths;
+    float* blocks;
+    int32_t index;
+    int64_t messages;
+    qrtone_t* qrtone;
+    qrtone_pool_t* pool;
+    char padding[QRTONE_POOL_CACHE_LINE];
+} qrtone_pool_stream_t;
+
+/**
+ * Worker thread and its run queue of streams, the other workers steal from it
+ */
+typedef struct _qrtone_pool_worker_t {
+    qrtone_pool_queue_t run_queue;
+    int32_t* run_streams;
+    qrtone_pool_t* pool;
+    pthread_t thread;
+    uint32_t random;
+    int64_t blocks;
+    int64_t samples;
+    int64_t steals;
+    char padding[QRTONE_POOL_CACHE_LINE];
+} qrtone_pool_worker_t;
+
+struct _qrtone_pool_t {
+    qrtone_profile_t* profile;
+    qrtone_pool_stream_t* streams;
+    int32_t streams_length;
+    qrtone_pool_worker_t* workers;
+    int32_t workers_length;
+    int32_t workers_started;
+    int32_t block_length;
+    void* callback_data;
+    qrtone_pool_callback_t callback;
+    pthread_mutex_t lock; // only taken to sleep and to wake up
+    pthread_cond_t wake;
+    pthread_cond_t flushed;
+    char padding[QRTONE_POOL_CACHE_LINE];
+    int64_t pending_blocks; // pushed blocks not decoded yet
+    char pending_padding[QRTONE_POOL_CACHE_LINE];
+    int32_t sleepers;
+    int32_t stop;
+};
+
+void qrtone_pool_options_init(qrtone_pool_options_t* options) {
+    options->threads = 0;
+    options->block_length = QRTONE_POOL_DEFAULT_BLOCK_LENGTH;
+    options->queue_blocks = QRTONE_POOL_DEFAULT_QUEUE_BLOCKS;
+    options->config = NULL;
+}
+
+static int8_t qrtone_pool_queue_init(qrtone_pool_queue_t* self, int64_t capacity) {
+    int64_t size = 1;
+    while (size < capacity) {
+        size *= 2;
+    }
+    self->enqueue_position = 0;
+    self->dequeue_position = 0;
+    self->mask = size - 1;
+    self->sequences = malloc(sizeof(int64_t) * (size_t)size);
+    if (self->sequences == NULL) {
+        return 0;
+    }
+    int64_t i;
+    for (i = 0; i < size; i++) {
+        self->sequences[i] = i;
+    }
+    return 1;
+}
+
+/**
+ * Claim the cell of the next push, the element is written in the cell then published with qrtone_pool_queue_publish
+ * @return Position of the cell, -1 if the queue is full
+ */
+static int64_t qrtone_pool_queue_claim(qrtone_pool_queue_t* self) {
+    int64_t position = __atomic_load_n(&(self->enqueue_position), __ATOMIC_RELAXED);
+    for (;;) {
+        const int64_t sequence = __atomic_load_n(&(self->sequences[position & self->mask]), __ATOMIC_ACQUIRE);
+        if (sequence == position) {
+            // position is reloaded when another producer claimed the cell first
+            if (__atomic_compare_exchange_n(&(self->enqueue_position), &position, position + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                return position;
+            }
+        } else if (sequence < position) {
+            return -1;
+        } else {
+            position = __atomic_load_n(&(self->enqueue_position), __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void qrtone_pool_queue_publish(qrtone_pool_queue_t* self, int64_t position) {
+    __atomic_store_n(&(self->sequences[position & self->mask]), position + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Take the oldest cell, its element is read then the cell is freed with qrtone_pool_queue_release
+ * @return Position of the cell, -1 if the queue is empty
+ */
+static int64_t qrtone_pool_queue_take(qrtone_pool_queue_t* self) {
+    int64_t position = __atomic_load_n(&(self->dequeue_position), __ATOMIC_RELAXED);
+    for (;;) {
+        const int64_t sequence = __atomic_load_n(&(self->sequences[position & self->mask]), __ATOMIC_ACQUIRE);
+        if (sequence == position + 1) {
+            if (__atomic_compare_exchange_n(&(self->dequeue_position), &position, position + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                return position;
+            }
+        } else if (sequence < position + 1) {
+            return -1;
+        } else {
+            position = __atomic_load_n(&(self->dequeue_position), __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void qrtone_pool_queue_release(qrtone_pool_queue_t* self, int64_t position) {
+    __atomic_store_n(&(self->sequences[position & self->mask]), position + self->mask + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @return 1 if an element is published at the dequeue position
+ */
+static int8_t qrtone_pool_queue_ready(qrtone_pool_queue_t* self) {
+    const int64_t position = __atomic_load_n(&(self->dequeue_position), __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&(self->sequences[position & self->mask]), __ATOMIC_SEQ_CST) == position + 1;
+}
+
+static void qrtone_pool_wake(qrtone_pool_t* self) {
+    // pairs with the fence of a worker going to sleep, one of the two sees the other
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&(self->sleepers), __ATOMIC_RELAXED) > 0) {
+        pthread_mutex_lock(&(self->lock));
+        pthread_cond_signal(&(self->wake));
+        pthread_mutex_unlock(&(self->lock));
+    }
+}
+
+/**
+ * Add a scheduled stream to a run queue. A stream is in one run queue at most, so run queues are never full.
+ */
+static void qrtone_pool_schedule(qrtone_pool_t* self, qrtone_pool_worker_t* worker, int32_t stream) {
+    int64_t position;
+    while ((position = qrtone_pool_queue_claim(&(worker->run_queue))) < 0) {
+        sched_yield();
+    }
+    worker->run_streams[position & worker->run_queue.mask] = stream;
+    qrtone_pool_queue_publish(&(worker->run_queue), position);
+    qrtone_pool_wake(self);
+}
+
+static int32_t qrtone_pool_push_buffer(qrtone_pool_t* self, int32_t stream, const float* samples, const int16_t* samples_s16, int32_t samples_length) {
+    if (stream < 0 || stream >= self->streams_length) {
+        return 0;
+    }
+    qrtone_pool_stream_t* pool_stream = &(self->streams[stream]);
+    int32_t pushed = 0;
+    while (pushed < samples_length) {
+        const int64_t position = qrtone_pool_queue_claim(&(pool_stream->queue));
+        if (position < 0) {
+            break;
+        }
+        const int64_t cell = position & pool_stream->queue.mask;
+        const int32_t length = samples_length - pushed < self->block_length ? samples_length - pushed : self->block_length;
+        float* block = pool_stream->blocks + cell * self->block_length;
+        if (samples != NULL) {
+            memcpy(block, samples + pushed, sizeof(float) * (size_t)length);
+        } else {
+            int32_t i;
+            for (i = 0; i < length; i++) {
+                block[i] = samples_s16[pushed + i] / 32768.0f;
+            }
+        }
+        pool_stream->lengths[cell] = length;
+        // counted before the block can be decoded
+        __atomic_add_fetch(&(self->pending_blocks), 1, __ATOMIC_RELAXED);
+        qrtone_pool_queue_publish(&(pool_stream->queue), position);
+        pushed += length;
+    }
+    // The worker that unschedules the stream checks the queue after, one of the two sees the other
+    if (pushed > 0 && __atomic_exchange_n(&(pool_stream->scheduled), 1, __ATOMIC_SEQ_CST) == 0) {
+        qrtone_pool_schedule(self, &(self->workers[stream % self->workers_length]), stream);
+    }
+    return pushed;
+}
+
+int32_t qrtone_pool_push(qrtone_pool_t* pool, int32_t stream, const float* samples, int32_t samples_length) {
+    return qrtone_pool_push_buffer(pool, stream, samples, NULL, samples_length);
+}
+
+int32_t qrtone_pool_push_s16(qrtone_pool_t* pool, int32_t stream, const int16_t* samples, int32_t samples_length) {
+    return qrtone_pool_push_buffer(pool, stream, NULL, samples, samples_length);
+}
+
+static void qrtone_pool_on_payload(void* ptr, const qrtone_message_t* message) {
+    qrtone_pool_stream_t* stream = (qrtone_pool_stream_t*)ptr;
+    __atomic_add_fetch(&(stream->messages), 1, __ATOMIC_RELAXED);
+    stream->pool->callback(stream->pool->callback_data, stream->index, message);
+}
+
+/**
+ * Decode the queued blocks of a stream, only one worker runs a stream at a time
+ */
+static void qrtone_pool_run(qrtone_pool_worker_t* worker, int32_t stream) {
+    qrtone_pool_t* self = worker->pool;
+    qrtone_pool_stream_t* pool_stream = &(self->streams[stream]);
+    int32_t decoded;
+    for (decoded = 0; decoded < QRTONE_POOL_BATCH; decoded++) {
+        const int64_t position = qrtone_pool_queue_take(&(pool_stream->queue));
+        if (position < 0) {
+            break;
+        }
+        const int64_t cell = position & pool_stream->queue.mask;
+        const int32_t length = pool_stream->lengths[cell];
+        qrtone_push_samples(pool_stream->qrtone, pool_stream->blocks + cell * self->block_length, length);
+        qrtone_pool_queue_release(&(pool_stream->queue), position);
+        __atomic_add_fetch(&(worker->blocks), 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&(worker->samples), length, __ATOMIC_RELAXED);
+        if (__atomic_sub_fetch(&(self->pending_blocks), 1, __ATOMIC_ACQ_REL) == 0) {
+            pthread_mutex_lock(&(self->lock));
+            pthread_cond_broadcast(&(self->flushed));
+            pthread_mutex_unlock(&(self->lock));
+        }
+    }
+    if (decoded == QRTONE_POOL_BATCH) {
+        // Still scheduled, the streams queued on this worker are decoded first
+        qrtone_pool_schedule(self, worker, stream);
+        return;
+    }
+    __atomic_store_n(&(pool_stream->scheduled), 0, __ATOMIC_SEQ_CST);
+    // A block published before the store was not followed by a schedule from its producer
+    if (qrtone_pool_queue_ready(&(pool_stream->queue)) && __atomic_exchange_n(&(pool_stream->scheduled), 1, __ATOMIC_SEQ_CST) == 0) {
+        qrtone_pool_schedule(self, worker, stream);
+    }
+}
+
+static int32_t qrtone_pool_take_stream(qrtone_pool_worker_t* worker, qrtone_pool_worker_t* victim) {
+    const int64_t position = qrtone_pool_queue_take(&(victim->run_queue));
+    if (position < 0) {
+        return -1;
+    }
+    const int32_t stream = victim->run_streams[position & victim->run_queue.mask];
+    qrtone_pool_queue_release(&(victim->run_queue), position);
+    if (victim != worker) {
+        __atomic_add_fetch(&(worker->steals), 1, __ATOMIC_RELAXED);
+    }
+    return stream;
+}
+
+/**
+ * @return A stream of the run queue of the worker, otherwise a stream stolen from another worker, -1 if all run queues are empty
+ */
+static int32_t qrtone_pool_find_stream(qrtone_pool_worker_t* worker) {
+    qrtone_pool_t* self = worker->pool;
+    int32_t stream = qrtone_pool_take_stream(worker, worker);
+    if (stream >= 0) {
+        return stream;
+    }
+    // xorshift, thieves start at a different victim
+    worker->random ^= worker->random << 13;
+    worker->random ^= worker->random >> 17;
+    worker->random ^= worker->random << 5;
+    const int32_t first = (int32_t)(worker->random % (uint32_t)self->workers_length);
+    int32_t i;
+    for (i = 0; i < self->workers_length; i++) {
+        qrtone_pool_worker_t* victim = &(self->workers[(first + i) % self->workers_length]);
+        if (victim != worker && (stream = qrtone_pool_take_stream(worker, victim)) >= 0) {
+            return stream;
+        }
+    }
+    return -1;
+}
+
+static int8_t qrtone_pool_has_work(qrtone_pool_t* self) {
+    int32_t i;
+    for (i = 0; i < self->workers_length; i++) {
+        if (qrtone_pool_queue_ready(&(self->workers[i].run_queue))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void* qrtone_pool_worker(void* data) {
+    qrtone_pool_worker_t* worker = (qrtone_pool_worker_t*)data;
+    qrtone_pool_t* self = worker->pool;
+    for (;;) {
+        const int32_t stream = qrtone_pool_find_stream(worker);
+        if (stream >= 0) {
+            qrtone_pool_run(worker, stream);
+            continue;
+        }
+        pthread_mutex_lock(&(self->lock));
+        __atomic_add_fetch(&(self->sleepers), 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        const int8_t stop = __atomic_load_n(&(self->stop), __ATOMIC_SEQ_CST) != 0;
+        if (!stop && !qrtone_pool_has_work(self)) {
+            pthread_cond_wait(&(self->wake), &(self->lock));
+        }
+        __atomic_sub_fetch(&(self->sleepers), 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&(self->lock));
+        if (stop) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void qrtone_pool_release(qrtone_pool_t* self) {
+    int32_t i;
+    if (self->streams != NULL) {
+        for (i = 0; i < self->streams_length; i++) {
+            qrtone_pool_stream_t* stream = &(self->streams[i]);
+            if (stream->qrtone != NULL) {
+                qrtone_free(stream->qrtone);
+                free(stream->qrtone);
+            }
+            free(stream->queue.sequences);
+            free(stream->lengths);
+            free(stream->blocks);
+        }
+        free(self->streams);
+    }
+    if (self->workers != NULL) {
+        for (i = 0; i < self->workers_length; i++) {
+            free(self->workers[i].run_queue.sequences);
+            free(self->workers[i].run_streams);
+        }
+        free(self->workers);
+    }
+    if (self->profile != NULL) {
+        qrtone_profile_free(self->profile);
+        free(self->profile);
+    }
+    free(self);
+}
+
+static void qrtone_pool_stop(qrtone_pool_t* self) {
+    __atomic_store_n(&(self->stop), 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&(self->lock));
+    pthread_cond_broadcast(&(self->wake));
+    pthread_mutex_unlock(&(self->lock));
+    int32_t i;
+    for (i = 0; i < self->workers_started; i++) {
+        pthread_join(self->workers[i].thread, NULL);
+    }
+    pthread_cond_destroy(&(self->flushed));
+    pthread_cond_destroy(&(self->wake));
+    pthread_mutex_destroy(&(self->lock));
+}
+
+static int8_t qrtone_pool_init_streams(qrtone_pool_t* self, int32_t queue_blocks) {
+    int32_t i;
+    for (i = 0; i < self->streams_length; i++) {
+        qrtone_pool_stream_t* stream = &(self->streams[i]);
+        stream->index = i;
+        stream->pool = self;
+        if (!qrtone_pool_queue_init(&(stream->queue), queue_blocks)) {
+            return 0;
+        }
+        const size_t cells = (size_t)(stream->queue.mask + 1);
+        stream->lengths = malloc(sizeof(int32_t) * cells);
+        stream->blocks = malloc(sizeof(float) * cells * (size_t)self->block_length);
+        if (stream->lengths == NULL || stream->blocks == NULL) {
+            return 0;
+        }
+        // Only an initialized decoder is released with qrtone_free
+        qrtone_t* qrtone = qrtone_new();
+        if (qrtone == NULL) {
+            return 0;
+        }
+        stream->qrtone = qrtone;
+        if (!qrtone_init_profile(stream->qrtone, self->profile, NULL)) {
+            return 0;
+        }
+        // The decoder keeps listening after each message
+        qrtone_set_payload_callback(stream->qrtone, stream, qrtone_pool_on_payload);
+    }
+    for (i = 0; i < self->workers_length; i++) {
+        qrtone_pool_worker_t* worker = &(self->workers[i]);
+        worker->pool = self;
+        worker->random = 2463534242u + (uint32_t)i * 2654435761u;
+        if (!qrtone_pool_queue_init(&(worker->run_queue), self->streams_length)) {
+            return 0;
+        }
+        worker->run_streams = malloc(sizeof(int32_t) * (size_t)(worker->run_queue.mask + 1));
+        if (worker->run_streams == NULL) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+qrtone_pool_t* qrtone_pool_new(int32_t streams, float sample_rate, const qrtone_pool_options_t* options, void* ptr, qrtone_pool_callback_t callback) {
+    qrtone_pool_options_t default_options;
+    if (options == NULL) {
+        qrtone_pool_options_init(&default_options);
+        options = &default_options;
+    }
+    if (streams < 1 || options->block_length < 1 || options->queue_blocks < 1 || callback == NULL) {
+        return NULL;
+    }
+    qrtone_pool_t* self = calloc(1, sizeof(qrtone_pool_t));
+    if (self == NULL) {
+        return NULL;
+    }
+    self->streams_length = streams;
+    self->block_length = options->block_length;
+    self->callback_data = ptr;
+    self->callback = callback;
+    int32_t threads = options->threads;
+    if (threads <= 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+        threads = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (threads <= 0) {
+            threads = 1;
+        }
+    }
+    self->workers_length = threads;
+    qrtone_config_t config;
+    if (options->config != NULL) {
+        config = *(options->config);
+        config.sample_rate = sample_rate;
+    } else {
+        qrtone_config_audible(&config, sample_rate);
+    }
+    self->profile = qrtone_profile_new();
+    self->streams = calloc((size_t)streams, sizeof(qrtone_pool_stream_t));
+    self->workers = calloc((size_t)threads, sizeof(qrtone_pool_worker_t));
+    if (self->profile == NULL || self->streams == NULL || self->workers == NULL) {
+        qrtone_pool_release(self);
+        return NULL;
+    }
+    if (!qrtone_profile_init_config(self->profile, &config) || !qrtone_pool_init_streams(self, options->queue_blocks)) {
+        qrtone_pool_release(self);
+        return NULL;
+    }
+    if (pthread_mutex_init(&(self->lock), NULL) != 0) {
+        qrtone_pool_release(self);
+        return NULL;
+    }
+    if (pthread_cond_init(&(self->wake), NULL) != 0) {
+        pthread_mutex_destroy(&(self->lock));
+        qrtone_pool_release(self);
+        return NULL;
+    }
+    if (pthread_cond_init(&(self->flushed), NULL) != 0) {
+        pthread_cond_destroy(&(self->wake));
+        pthread_mutex_destroy(&(self->lock));
+        qrtone_pool_release(self);
+        return NULL;
+    }
+    for (self->workers_started = 0; self->workers_started < threads; self->workers_started++) {
+        if (pthread_create(&(self->workers[self->workers_started].thread), NULL, qrtone_pool_worker, &(self->workers[self->workers_started])) != 0) {
+            qrtone_pool_stop(self);
+            qrtone_pool_release(self);
+            return NULL;
+        }
+    }
+    return self;
+}
+
+void qrtone_pool_flush(qrtone_pool_t* pool) {
+    pthread_mutex_lock(&(pool->lock));
+    while (__atomic_load_n(&(pool->pending_blocks), __ATOMIC_ACQUIRE) > 0) {
+        pthread_cond_wait(&(pool->flushed), &(pool->lock));
+    }
+    pthread_mutex_unlock(&(pool->lock));
+}
+
+void qrtone_pool_get_stats(qrtone_pool_t* pool, qrtone_pool_stats_t* stats) {
+    memset(stats, 0, sizeof(qrtone_pool_stats_t));
+    int32_t i;
+    for (i = 0; i < pool->workers_length; i++) {
+        stats->blocks += __atomic_load_n(&(pool->workers[i].blocks), __ATOMIC_RELAXED);
+        stats->samples += __atomic_load_n(&(pool->workers[i].samples), __ATOMIC_RELAXED);
+        stats->steals += __atomic_load_n(&(pool->workers[i].steals), __ATOMIC_RELAXED);
+    }
+    for (i = 0; i < pool->streams_length; i++) {
+        stats->messages += __atomic_load_n(&(pool->streams[i].messages), __ATOMIC_RELAXED);
+    }
+}
+
+void qrtone_pool_free(qrtone_pool_t* pool) {
+    qrtone_pool_flush(pool);
+    qrtone_pool_stop(pool);
+    qrtone_pool_release(pool);
+}
@@ -0,0 +1,149 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) Unité Mixte de Recherche en Acoustique Environnementale (univ-gustave-eiffel)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *  Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ *  Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file qrtone_pool.h
+ * @brief Decoding of many audio streams on a pool of worker threads (host only, POSIX threads)
+ * Usage
+ * 1. Create the pool with qrtone_pool_new, one decoder per stream
+ * 2. Push the samples of each stream with qrtone_pool_push from any thread
+ * 3. Payloads are given to the callback from the worker threads
+ * 4. Call qrtone_pool_flush to wait for the pushed samples, and qrtone_pool_free to stop the workers
+ * Pushed samples are copied into blocks queued on their stream, without lock. A stream with queued blocks is
+ * scheduled on a worker, an idle worker steals the streams scheduled on the other workers. A stream is decoded
+ * by one worker at a time, its blocks are decoded in the order of the pushes.
+ */
+
+#ifndef QRTONE_POOL_H
+#define QRTONE_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "qrtone.h"
+
+/**
+ * @brief Pool parameters
+ */
+typedef struct _qrtone_pool_options_t {
+    int32_t threads;                      /**< Number of worker threads, 0 for one per online processor */
+    int32_t block_length;                 /**< Maximum number of samples of a queued block */
+    int32_t queue_blocks;                 /**< Capacity of the queue of each stream in blocks, rounded up to a power of two */
+    const qrtone_config_t* config;        /**< Modulation parameters, NULL for qrtone_config_audible. The sample rate field is ignored */
+} qrtone_pool_options_t;
+
+/**
+ * @brief Counters of a pool
+ */
+typedef struct _qrtone_pool_stats_t {
+    int64_t blocks;                       /**< Decoded blocks */
+    int64_t samples;                      /**< Decoded samples */
+    int64_t messages;                     /**< Payloads given to the callback */
+    int64_t steals;                       /**< Streams taken from the queue of another worker */
+} qrtone_pool_stats_t;
+
+/**
+ * Called from a worker thread when a payload is received on a stream. Calls of a stream are ordered, calls of
+ * different streams may be concurrent. The message is valid only during the call.
+ * @param ptr Pointer provided to qrtone_pool_new
+ * @param stream Stream index
+ * @param message Received payload, sample_index is the index of the message in the samples of the stream
+ */
+typedef void (*qrtone_pool_callback_t)(void* ptr, int32_t stream, const qrtone_message_t* message);
+
+typedef struct _qrtone_pool_t qrtone_pool_t;
+
+/**
+ * Set default pool options: one thread per processor and 16 blocks of 1024 samples per stream.
+ * @param options A pointer to the options structure.
+ */
+void qrtone_pool_options_init(qrtone_pool_options_t* options);
+
+/**
+ * Allocate the decoders and start the worker threads.
+ * @param streams Number of streams, pushed samples are tagged with a stream index from 0 to streams - 1
+ * @param sample_rate Sample rate of all streams in Hz
+ * @param options Pool options, NULL for defaults
+ * @param ptr Pointer given to the callback
+ * @param callback Function called with each received payload
+ * @return The pool, NULL if the configuration is not valid, or if an allocation or a thread creation failed.
+ */
+qrtone_pool_t* qrtone_pool_new(int32_t streams, float sample_rate, const qrtone_pool_options_t* options, void* ptr, qrtone_pool_callback_t callback);
+
+/**
+ * Queue samples of a stream. Never blocks, the samples are copied.
+ * Several threads can push at the same time, the pushes of a stream must not be concurrent to keep their order.
+ * @param pool A pointer to the pool.
+ * @param stream Stream index
+ * @param samples Audio samples, 1.0 is full scale
+ * @param samples_length Number of samples, any size
+ * @return Number of queued samples, less than samples_length if the queue of the stream is full.
+ * Push the remaining samples later, or drop them.
+ */
+int32_t qrtone_pool_push(qrtone_pool_t* pool, int32_t stream, const float* samples, int32_t samples_length);
+
+/**
+ * Queue int16 samples of a stream, converted to float.
+ * @see qrtone_pool_push
+ * @param samples Audio samples, 32767 is full scale
+ */
+int32_t qrtone_pool_push_s16(qrtone_pool_t* pool, int32_t stream, const int16_t* samples, int32_t samples_length);
+
+/**
+ * Wait until all queued samples are decoded. Samples pushed during the call may not be decoded on return.
+ * @param pool A pointer to the pool.
+ */
+void qrtone_pool_flush(qrtone_pool_t* pool);
+
+/**
+ * Read the counters of the pool, they are updated by the workers during the call.
+ * @param pool A pointer to the pool.
+ * @param stats Counters summed over the workers
+ */
+void qrtone_pool_get_stats(qrtone_pool_t* pool, qrtone_pool_stats_t* stats);
+
+/**
+ * Decode the queued samples, stop the workers and free the pool. No push must happen during the call.
+ * @param pool A pointer to the pool.
+ */
+void qrtone_pool_free(qrtone_pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
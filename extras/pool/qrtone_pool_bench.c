@@ -0,0 +1,234 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) Unité Mixte de Recherche en Acoustique Environnementale (univ-gustave-eiffel)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *  Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ *  Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/**
+ * @file qrtone_pool_bench.c
+ * @brief Decoding throughput of a pool of worker threads fed by producer threads
+ * Usage: qrtone_pool_bench [-j threads] [-s streams] [-p producers] [-d seconds] [-r sample_rate]
+ * Each stream is a synthetic recording with one message in low noise. The same streams are first decoded
+ * sequentially on the calling thread, then through the pool.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "qrtone_pool.h"
+
+#define BENCH_RECORDINGS 8
+#define BENCH_BLOCK 441
+
+typedef struct _bench_producer_t {
+    qrtone_pool_t* pool;
+    float** recordings;
+    int32_t recording_length;
+    int32_t streams;
+    int32_t producers;
+    int32_t first_stream;
+} bench_producer_t;
+
+static void usage(void) {
+    fprintf(stderr, "Usage: qrtone_pool_bench [-j threads] [-s streams] [-p producers] [-d seconds] [-r sample_rate]\n"
+        "  -j  worker threads, default one per processor\n"
+        "  -s  decoded streams, default 64\n"
+        "  -p  producer threads pushing the streams, default 2\n"
+        "  -d  duration of each stream in seconds, default 20\n"
+        "  -r  sample rate, default 44100\n");
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float* bench_recording(int32_t index, float sample_rate, int32_t length) {
+    float* samples = calloc((size_t)length, sizeof(float));
+    if (samples == NULL) {
+        return NULL;
+    }
+    int8_t payload[] = { (int8_t)index, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77 };
+    qrtone_t* qrtone = qrtone_new();
+    qrtone_init(qrtone, sample_rate);
+    int32_t message_length = qrtone_set_payload(qrtone, payload, sizeof(payload));
+    int32_t offset = (int32_t)(sample_rate * (0.5f + 0.25f * index));
+    if (offset + message_length <= length) {
+        qrtone_get_samples(qrtone, samples + offset, message_length, 0.1f);
+    }
+    qrtone_free(qrtone);
+    free(qrtone);
+    uint32_t state = (uint32_t)index + 1;
+    int32_t i;
+    for (i = 0; i < length; i++) {
+        state = state * 1664525u + 1013904223u;
+        samples[i] += ((int32_t)(state >> 8) - (1 << 23)) / (float)(1 << 23) * 0.001f;
+    }
+    return samples;
+}
+
+static void bench_on_message(void* ptr, const qrtone_message_t* message) {
+    (*(int64_t*)ptr)++;
+}
+
+static void bench_on_pool_message(void* ptr, int32_t stream, const qrtone_message_t* message) {
+    __atomic_add_fetch((int64_t*)ptr, 1, __ATOMIC_RELAXED);
+}
+
+static void* bench_producer(void* data) {
+    bench_producer_t* producer = (bench_producer_t*)data;
+    int32_t streams = (producer->streams - producer->first_stream + producer->producers - 1) / producer->producers;
+    int32_t* cursors = calloc((size_t)streams, sizeof(int32_t));
+    int32_t remaining = 1;
+    while (remaining) {
+        remaining = 0;
+        int32_t i;
+        for (i = 0; i < streams; i++) {
+            int32_t stream = producer->first_stream + i * producer->producers;
+            int32_t length = producer->recording_length - cursors[i];
+            if (length > BENCH_BLOCK) {
+                length = BENCH_BLOCK;
+            }
+            cursors[i] += qrtone_pool_push(producer->pool, stream, producer->recordings[stream % BENCH_RECORDINGS] + cursors[i], length);
+            if (cursors[i] < producer->recording_length) {
+                remaining = 1;
+            }
+        }
+        // Queues of all streams are full
+        sched_yield();
+    }
+    free(cursors);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    qrtone_pool_options_t options;
+    qrtone_pool_options_init(&options);
+    int32_t streams = 64;
+    int32_t producers = 2;
+    float seconds = 20;
+    float sample_rate = 44100;
+    int i;
+    for (i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-j") == 0) {
+            options.threads = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            streams = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-p") == 0) {
+            producers = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-d") == 0) {
+            seconds = (float)atof(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-r") == 0) {
+            sample_rate = (float)atof(argv[++i]);
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (streams < 1 || producers < 1 || seconds <= 0) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    const int32_t recording_length = (int32_t)(seconds * sample_rate);
+    float* recordings[BENCH_RECORDINGS];
+    for (i = 0; i < BENCH_RECORDINGS; i++) {
+        recordings[i] = bench_recording(i, sample_rate, recording_length);
+        if (recordings[i] == NULL) {
+            fprintf(stderr, "Not enough memory\n");
+            return EXIT_FAILURE;
+        }
+    }
+    const double audio_seconds = (double)streams * recording_length / sample_rate;
+    // Reference: one decoder at a time on this thread
+    int64_t sequential_messages = 0;
+    double start = bench_now();
+    for (i = 0; i < streams; i++) {
+        qrtone_t* qrtone = qrtone_new();
+        qrtone_init(qrtone, sample_rate);
+        qrtone_set_payload_callback(qrtone, &sequential_messages, bench_on_message);
+        int32_t cursor;
+        for (cursor = 0; cursor < recording_length; cursor += BENCH_BLOCK) {
+            int32_t length = recording_length - cursor < BENCH_BLOCK ? recording_length - cursor : BENCH_BLOCK;
+            qrtone_push_samples(qrtone, recordings[i % BENCH_RECORDINGS] + cursor, length);
+        }
+        qrtone_free(qrtone);
+        free(qrtone);
+    }
+    const double sequential_time = bench_now() - start;
+    printf("sequential: %d streams, %.1f s of audio in %.3f s, %.0fx realtime, %lld messages\n", streams, audio_seconds,
+        sequential_time, audio_seconds / sequential_time, (long long)sequential_messages);
+    int64_t pool_messages = 0;
+    qrtone_pool_t* pool = qrtone_pool_new(streams, sample_rate, &options, &pool_messages, bench_on_pool_message);
+    if (pool == NULL) {
+        fprintf(stderr, "Could not create the pool\n");
+        return EXIT_FAILURE;
+    }
+    bench_producer_t* producer_args = malloc(sizeof(bench_producer_t) * (size_t)producers);
+    pthread_t* producer_threads = malloc(sizeof(pthread_t) * (size_t)producers);
+    start = bench_now();
+    for (i = 0; i < producers; i++) {
+        producer_args[i].pool = pool;
+        producer_args[i].recordings = recordings;
+        producer_args[i].recording_length = recording_length;
+        producer_args[i].streams = streams;
+        producer_args[i].producers = producers;
+        producer_args[i].first_stream = i;
+        if (pthread_create(&(producer_threads[i]), NULL, bench_producer, &(producer_args[i])) != 0) {
+            fprintf(stderr, "Could not start the producers\n");
+            return EXIT_FAILURE;
+        }
+    }
+    for (i = 0; i < producers; i++) {
+        pthread_join(producer_threads[i], NULL);
+    }
+    qrtone_pool_flush(pool);
+    const double pool_time = bench_now() - start;
+    qrtone_pool_stats_t stats;
+    qrtone_pool_get_stats(pool, &stats);
+    printf("pool:       %d streams, %.1f s of audio in %.3f s, %.0fx realtime, %lld messages, %lld blocks, %lld steals\n",
+        streams, audio_seconds, pool_time, audio_seconds / pool_time, (long long)stats.messages, (long long)stats.blocks,
+        (long long)stats.steals);
+    printf("speedup:    %.2f\n", sequential_time / pool_time);
+    qrtone_pool_free(pool);
+    free(producer_args);
+    free(producer_threads);
+    for (i = 0; i < BENCH_RECORDINGS; i++) {
+        free(recordings[i]);
+    }
+    return stats.messages == sequential_messages ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,119 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) Unité Mixte de Recherche en Acoustique Environnementale (univ-gustave-eiffel)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *  Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ *  Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file qrtone_scan.c
+ * @brief Command line tool printing all QRTone messages of a recording
+ * Usage: qrtone_scan [-j threads] [-r raw_sample_rate] [-l max_payload_length] [-f|-i] recording
+ * Each message is printed on one line: sample index, time in seconds, fixed errors, payload in hexadecimal.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrtone_scanner.h"
+
+static void usage(void) {
+    fprintf(stderr, "Usage: qrtone_scan [-j threads] [-r raw_sample_rate] [-l max_payload_length] [-f|-i] recording\n"
+        "  -j  decoding threads, default one per processor\n"
+        "  -r  sample rate of raw int16 mono files, default 44100\n"
+        "  -l  longest expected payload in bytes, default 255\n"
+        "  -f  messages sent with the fast configuration\n"
+        "  -i  messages sent with the inaudible configuration\n");
+}
+
+int main(int argc, char** argv) {
+    qrtone_scan_options_t options;
+    qrtone_scan_options_init(&options);
+    qrtone_config_t config;
+    float raw_sample_rate = 44100;
+    // 'f' fast, 'i' inaudible, applied once the sample rate is known
+    char preset = 0;
+    const char* path = NULL;
+    int i;
+    for (i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-j") == 0) {
+            options.threads = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-r") == 0) {
+            raw_sample_rate = (float)atof(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "-l") == 0) {
+            int length = atoi(argv[++i]);
+            options.max_payload_length = (uint8_t)(length < 0 ? 0 : length > 255 ? 255 : length);
+        } else if (strcmp(argv[i], "-f") == 0) {
+            preset = 'f';
+        } else if (strcmp(argv[i], "-i") == 0) {
+            preset = 'i';
+        } else if (path == NULL && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (path == NULL || raw_sample_rate <= 0) {
+        usage();
+        return 2;
+    }
+    if (preset == 'f') {
+        qrtone_config_fast(&config, raw_sample_rate);
+        options.config = &config;
+    } else if (preset == 'i') {
+        qrtone_config_inaudible(&config, raw_sample_rate);
+        options.config = &config;
+    }
+    qrtone_scan_file_t file;
+    if (!qrtone_scan_file_open(&file, path, raw_sample_rate)) {
+        fprintf(stderr, "Cannot read %s, WAV files must be 16 bits PCM\n", path);
+        return 1;
+    }
+    qrtone_scan_message_t* messages;
+    int32_t messages_length = qrtone_scan_samples(file.samples, file.samples_length, file.channels, file.sample_rate, &options, &messages);
+    if (messages_length < 0) {
+        fprintf(stderr, "Cannot scan %s at %.0f Hz\n", path, file.sample_rate);
+        qrtone_scan_file_close(&file);
+        return 1;
+    }
+    int32_t m;
+    for (m = 0; m < messages_length; m++) {
+        printf("%lld\t%.3f\t%d\t", (long long)messages[m].sample_index, messages[m].sample_index / file.sample_rate, messages[m].fixed_errors);
+        int32_t b;
+        for (b = 0; b < messages[m].payload_length; b++) {
+            printf("%02x", (uint8_t)messages[m].payload[b]);
+        }
+        printf("\n");
+    }
+    free(messages);
+    qrtone_scan_file_close(&file);
+    return 0;
+}
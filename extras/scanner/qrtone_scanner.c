@@ -0,0 +1,392 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) Unité Mixte de Recherche en Acoustique Environnementale (univ-gustave-eiffel)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *  Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ *  Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "qrtone_scanner.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define QRTONE_SCAN_CHUNK_OVERLAP_FACTOR 4
+#define QRTONE_SCAN_WINDOW 4096
+
+typedef struct _qrtone_scan_job_t {
+    const int16_t* samples;
+    int64_t samples_length;
+    int32_t channels;
+    int64_t chunk_length;
+    int64_t chunk_step;
+    int64_t chunks;
+    qrtone_profile_t* profile;
+    pthread_mutex_t lock;
+    int64_t next_chunk;
+    int8_t failed;
+    qrtone_scan_message_t* messages;
+    int32_t messages_length;
+    int32_t messages_capacity;
+} qrtone_scan_job_t;
+
+void qrtone_scan_options_init(qrtone_scan_options_t* options) {
+    options->threads = 0;
+    options->max_payload_length = 255;
+    options->chunk_length = 0;
+    options->config = NULL;
+}
+
+static uint32_t qrtone_scan_read_u32(const uint8_t* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint16_t qrtone_scan_read_u16(const uint8_t* data) {
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+/**
+ * Locate the samples of a RIFF WAVE file. Return 0 if the format is not 16 bits PCM.
+ */
+static int8_t qrtone_scan_parse_wav(qrtone_scan_file_t* file, const uint8_t* data, size_t data_length) {
+    size_t offset = 12;
+    int8_t has_format = 0;
+    while (offset + 8 <= data_length) {
+        const uint8_t* chunk = data + offset;
+        size_t chunk_length = qrtone_scan_read_u32(chunk + 4);
+        offset += 8;
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunk_length < 16 || offset + 16 > data_length) {
+                return 0;
+            }
+            uint16_t format = qrtone_scan_read_u16(chunk + 8);
+            // 1 is PCM, 0xFFFE is WAVE_FORMAT_EXTENSIBLE
+            if ((format != 1 && format != 0xFFFE) || qrtone_scan_read_u16(chunk + 22) != 16) {
+                return 0;
+            }
+            file->channels = qrtone_scan_read_u16(chunk + 10);
+            file->sample_rate = (float)qrtone_scan_read_u32(chunk + 12);
+            has_format = file->channels > 0;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!has_format) {
+                return 0;
+            }
+            // Recorders that were interrupted leave a wrong data length
+            if (chunk_length > data_length - offset) {
+                chunk_length = data_length - offset;
+            }
+            file->samples = (const int16_t*)(data + offset);
+            file->samples_length = (int64_t)(chunk_length / (sizeof(int16_t) * file->channels));
+            return 1;
+        }
+        // chunks are word aligned
+        offset += chunk_length + (chunk_length & 1);
+    }
+    return 0;
+}
+
+int8_t qrtone_scan_file_open(qrtone_scan_file_t* file, const char* path, float raw_sample_rate) {
+    memset(file, 0, sizeof(qrtone_scan_file_t));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return 0;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 0;
+    }
+    file->map = map;
+    file->map_length = (size_t)st.st_size;
+    const uint8_t* data = (const uint8_t*)map;
+    if (file->map_length >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WAVE", 4) == 0) {
+        if (!qrtone_scan_parse_wav(file, data, file->map_length)) {
+            qrtone_scan_file_close(file);
+            return 0;
+        }
+    } else {
+        file->samples = (const int16_t*)map;
+        file->samples_length = (int64_t)(file->map_length / sizeof(int16_t));
+        file->channels = 1;
+        file->sample_rate = raw_sample_rate;
+    }
+    return 1;
+}
+
+void qrtone_scan_file_close(qrtone_scan_file_t* file) {
+    if (file->map != NULL) {
+        munmap(file->map, file->map_length);
+    }
+    memset(file, 0, sizeof(qrtone_scan_file_t));
+}
+
+static int8_t qrtone_scan_add_message(qrtone_scan_job_t* job, const qrtone_message_t* received, int64_t chunk_start) {
+    int8_t ret = 1;
+    pthread_mutex_lock(&(job->lock));
+    if (job->messages_length == job->messages_capacity) {
+        int32_t capacity = job->messages_capacity == 0 ? 16 : job->messages_capacity * 2;
+        qrtone_scan_message_t* messages = realloc(job->messages, sizeof(qrtone_scan_message_t) * capacity);
+        if (messages == NULL) {
+            ret = 0;
+        } else {
+            job->messages = messages;
+            job->messages_capacity = capacity;
+        }
+    }
+    if (ret) {
+        qrtone_scan_message_t* message = &(job->messages[job->messages_length++]);
+        message->sample_index = chunk_start + received->sample_index;
+        message->fixed_errors = received->quality.fixed_errors;
+        message->payload_length = received->payload_length;
+        memcpy(message->payload, received->payload, (size_t)message->payload_length);
+    }
+    pthread_mutex_unlock(&(job->lock));
+    return ret;
+}
+
+typedef struct _qrtone_scan_chunk_t {
+    qrtone_scan_job_t* job;
+    int64_t chunk_start;
+    int8_t ret;
+} qrtone_scan_chunk_t;
+
+static void qrtone_scan_on_payload(void* ptr, const qrtone_message_t* message) {
+    qrtone_scan_chunk_t* chunk = (qrtone_scan_chunk_t*)ptr;
+    if (chunk->ret) {
+        chunk->ret = qrtone_scan_add_message(chunk->job, message, chunk->chunk_start);
+    }
+}
+
+/**
+ * Decode one chunk with a new decoder, the decoder keeps listening after each message.
+ */
+static int8_t qrtone_scan_chunk(qrtone_scan_job_t* job, int64_t chunk_start, float* window) {
+    qrtone_t* qrtone = qrtone_new();
+    if (qrtone == NULL) {
+        return 0;
+    }
+    qrtone_scan_chunk_t chunk = { job, chunk_start, 1 };
+    chunk.ret = qrtone_init_profile(qrtone, job->profile, NULL);
+    // A window can hold several messages, all of them are given to the callback
+    qrtone_set_payload_callback(qrtone, &chunk, qrtone_scan_on_payload);
+    const int64_t chunk_end = chunk_start + job->chunk_length < job->samples_length ? chunk_start + job->chunk_length : job->samples_length;
+    int64_t position = chunk_start;
+    while (chunk.ret && position < chunk_end) {
+        int64_t window_length = QRTONE_SCAN_WINDOW;
+        if (window_length > chunk_end - position) {
+            window_length = chunk_end - position;
+        }
+        const int16_t* samples = job->samples + position * job->channels;
+        int32_t i;
+        for (i = 0; i < (int32_t)window_length; i++) {
+            window[i] = samples[i * job->channels] / 32768.0f;
+        }
+        qrtone_push_samples(qrtone, window, (int32_t)window_length);
+        position += window_length;
+    }
+    qrtone_free(qrtone);
+    free(qrtone);
+    return chunk.ret;
+}
+
+static void* qrtone_scan_worker(void* data) {
+    qrtone_scan_job_t* job = (qrtone_scan_job_t*)data;
+    float* window = malloc(sizeof(float) * QRTONE_SCAN_WINDOW);
+    int8_t ret = window != NULL;
+    while (ret) {
+        pthread_mutex_lock(&(job->lock));
+        int64_t chunk = job->failed ? job->chunks : job->next_chunk++;
+        pthread_mutex_unlock(&(job->lock));
+        if (chunk >= job->chunks) {
+            break;
+        }
+        ret = qrtone_scan_chunk(job, chunk * job->chunk_step, window);
+    }
+    if (!ret) {
+        pthread_mutex_lock(&(job->lock));
+        job->failed = 1;
+        pthread_mutex_unlock(&(job->lock));
+    }
+    free(window);
+    return NULL;
+}
+
+static int qrtone_scan_compare(const void* a, const void* b) {
+    const qrtone_scan_message_t* ma = (const qrtone_scan_message_t*)a;
+    const qrtone_scan_message_t* mb = (const qrtone_scan_message_t*)b;
+    if (ma->sample_index != mb->sample_index) {
+        return ma->sample_index < mb->sample_index ? -1 : 1;
+    }
+    return ma->fixed_errors - mb->fixed_errors;
+}
+
+/**
+ * Remove messages found in two overlapping chunks. Messages are sorted by sample index.
+ */
+static int32_t qrtone_scan_remove_duplicates(qrtone_scan_message_t* messages, int32_t messages_length, int32_t tolerance) {
+    int32_t kept = 0;
+    int32_t i;
+    for (i = 0; i < messages_length; i++) {
+        int32_t j;
+        int8_t duplicate = 0;
+        for (j = kept - 1; j >= 0 && messages[i].sample_index - messages[j].sample_index <= tolerance; j--) {
+            if (messages[i].payload_length == messages[j].payload_length &&
+                memcmp(messages[i].payload, messages[j].payload, (size_t)messages[i].payload_length) == 0) {
+                duplicate = 1;
+                if (messages[i].fixed_errors < messages[j].fixed_errors) {
+                    messages[j] = messages[i];
+                }
+                break;
+            }
+        }
+        if (!duplicate) {
+            messages[kept++] = messages[i];
+        }
+    }
+    return kept;
+}
+
+int32_t qrtone_scan_samples(const int16_t* samples, int64_t samples_length, int32_t channels, float sample_rate, const qrtone_scan_options_t* options, qrtone_scan_message_t** messages) {
+    qrtone_scan_options_t default_options;
+    if (options == NULL) {
+        qrtone_scan_options_init(&default_options);
+        options = &default_options;
+    }
+    *messages = NULL;
+    qrtone_scan_job_t job;
+    memset(&job, 0, sizeof(qrtone_scan_job_t));
+    job.samples = samples;
+    job.samples_length = samples_length;
+    job.channels = channels;
+    job.profile = qrtone_profile_new();
+    if (job.profile == NULL) {
+        return -1;
+    }
+    qrtone_config_t config;
+    if (options->config != NULL) {
+        config = *(options->config);
+        config.sample_rate = sample_rate;
+    } else {
+        qrtone_config_audible(&config, sample_rate);
+    }
+    int32_t ret = 0;
+    qrtone_t* qrtone = NULL;
+    if (!qrtone_profile_init_config(job.profile, &config)) {
+        ret = -1;
+    } else {
+        qrtone = qrtone_new();
+        // qrtone_free must also be called when qrtone_init_profile fails
+        if (qrtone == NULL || !qrtone_init_profile(qrtone, job.profile, NULL)) {
+            ret = -1;
+        }
+    }
+    if (ret != 0) {
+        if (qrtone != NULL) {
+            qrtone_free(qrtone);
+            free(qrtone);
+        }
+        qrtone_profile_free(job.profile);
+        free(job.profile);
+        return ret;
+    }
+    // The trigger needs some background before the first gate
+    const int32_t gate_length = qrtone_get_gate_length(qrtone);
+    const int64_t overlap = (int64_t)qrtone_get_message_length(qrtone, options->max_payload_length, QRTONE_ECC_H, 1) + 2 * gate_length;
+    qrtone_free(qrtone);
+    free(qrtone);
+    job.chunk_length = options->chunk_length > 0 ? options->chunk_length : overlap * QRTONE_SCAN_CHUNK_OVERLAP_FACTOR;
+    if (job.chunk_length < 2 * overlap) {
+        job.chunk_length = 2 * overlap;
+    }
+    job.chunk_step = job.chunk_length - overlap;
+    // Last chunk is the first one that reach the end of the recording
+    job.chunks = samples_length <= job.chunk_length ? 1 : 1 + (samples_length - job.chunk_length + job.chunk_step - 1) / job.chunk_step;
+    int32_t threads = options->threads;
+    if (threads <= 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+        threads = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (threads <= 0) {
+            threads = 1;
+        }
+    }
+    if (threads > job.chunks) {
+        threads = (int32_t)job.chunks;
+    }
+    if (ret == 0) {
+        pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+        if (workers == NULL || pthread_mutex_init(&(job.lock), NULL) != 0) {
+            free(workers);
+            ret = -1;
+        } else {
+            int32_t started;
+            for (started = 0; started < threads; started++) {
+                if (pthread_create(&(workers[started]), NULL, qrtone_scan_worker, &job) != 0) {
+                    break;
+                }
+            }
+            // Remaining workers take the chunks of threads that could not be created
+            if (started == 0) {
+                job.failed = 1;
+            }
+            int32_t i;
+            for (i = 0; i < started; i++) {
+                pthread_join(workers[i], NULL);
+            }
+            pthread_mutex_destroy(&(job.lock));
+            free(workers);
+            if (job.failed) {
+                ret = -1;
+            }
+        }
+    }
+    qrtone_profile_free(job.profile);
+    free(job.profile);
+    if (ret != 0) {
+        free(job.messages);
+        return ret;
+    }
+    if (job.messages_length > 0) {
+        qsort(job.messages, (size_t)job.messages_length, sizeof(qrtone_scan_message_t), qrtone_scan_compare);
+        job.messages_length = qrtone_scan_remove_duplicates(job.messages, job.messages_length, gate_length);
+        *messages = job.messages;
+    }
+    return job.messages_length;
+}
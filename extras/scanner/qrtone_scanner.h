@@ -0,0 +1,129 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) Unité Mixte de Recherche en Acoustique Environnementale (univ-gustave-eiffel)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *  Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ *  Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file qrtone_scanner.h
+ * @brief Offline scanner of QRTone recordings (host only, POSIX threads and mmap)
+ * Usage
+ * 1. Open the recording with qrtone_scan_file_open (raw int16 or WAV), or provide an int16 array
+ * 2. Set the options with qrtone_scan_options_init
+ * 3. Call qrtone_scan_samples, messages are returned sorted by sample index
+ * 4. Free the messages with free and close the recording with qrtone_scan_file_close
+ * The recording is split into overlapping chunks decoded in parallel. The overlap is the longest
+ * expected message plus two gates, so each message lies entirely in at least one chunk.
+ * A message found in two chunks is reported once.
+ */
+
+#ifndef QRTONE_SCANNER_H
+#define QRTONE_SCANNER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "qrtone.h"
+
+/**
+ * @brief Message found in a recording
+ */
+typedef struct _qrtone_scan_message_t {
+    int64_t sample_index;                 /**< Index of the first sample of the message in the recording (per channel) */
+    int32_t fixed_errors;                 /**< Number of symbols corrected by Reed-Solomon */
+    int32_t payload_length;               /**< Payload length in bytes */
+    int8_t payload[QRTONE_MAX_PAYLOAD_LENGTH]; /**< Payload */
+} qrtone_scan_message_t;
+
+/**
+ * @brief Scan parameters
+ */
+typedef struct _qrtone_scan_options_t {
+    int32_t threads;                      /**< Number of decoding threads, 0 for one per online processor */
+    uint8_t max_payload_length;           /**< Longest expected payload, used to size the chunk overlap */
+    int64_t chunk_length;                 /**< Chunk length in samples, 0 for 4 times the overlap */
+    const qrtone_config_t* config;        /**< Modulation parameters, NULL for qrtone_config_audible. The sample rate field is ignored */
+} qrtone_scan_options_t;
+
+/**
+ * @brief Memory mapped recording
+ */
+typedef struct _qrtone_scan_file_t {
+    const int16_t* samples;               /**< First sample of the first channel */
+    int64_t samples_length;               /**< Number of samples per channel */
+    int32_t channels;                     /**< Interleaved channels, only the first one is scanned */
+    float sample_rate;                    /**< Sample rate in Hz */
+    void* map;
+    size_t map_length;
+} qrtone_scan_file_t;
+
+/**
+ * Set default scan options: one thread per processor and 255 bytes payloads.
+ * @param options A pointer to the options structure.
+ */
+void qrtone_scan_options_init(qrtone_scan_options_t* options);
+
+/**
+ * Memory map a recording. WAV files must contain 16 bits PCM samples, other files are read as
+ * raw 16 bits little endian mono samples.
+ * @param file A pointer to the file structure.
+ * @param path Path of the recording
+ * @param raw_sample_rate Sample rate of raw files, ignored for WAV files.
+ * @return 1 on success, 0 if the file cannot be read or if the WAV format is not supported.
+ */
+int8_t qrtone_scan_file_open(qrtone_scan_file_t* file, const char* path, float raw_sample_rate);
+
+/**
+ * Unmap a recording opened with qrtone_scan_file_open.
+ * @param file A pointer to the file structure.
+ */
+void qrtone_scan_file_close(qrtone_scan_file_t* file);
+
+/**
+ * Find all messages in an int16 recording.
+ * @param samples Audio samples, the first channel is scanned.
+ * @param samples_length Number of samples per channel.
+ * @param channels Number of interleaved channels.
+ * @param sample_rate Sample rate in Hz.
+ * @param options Scan options, NULL for defaults.
+ * @param messages Set to an array of messages sorted by sample index, to release with free. Set to NULL if no message is found.
+ * @return Number of messages, -1 if the configuration is not valid, or if an allocation or a thread creation failed.
+ */
+int32_t qrtone_scan_samples(const int16_t* samples, int64_t samples_length, int32_t channels, float sample_rate, const qrtone_scan_options_t* options, qrtone_scan_message_t** messages);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
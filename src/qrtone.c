@@ -46,10 +46,28 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <float.h>
 #include "qrtone.h"
 #include "reed_solomon.h"
 #include "math.h"
 
+// Vector instruction set used by the symbols Goertzel bank. Define QRTONE_NO_SIMD to force the scalar code path.
+#if !defined(QRTONE_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define QRTONE_SIMD_AVX2
+#define QRTONE_SIMD_LANES 8
+#elif !defined(QRTONE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define QRTONE_SIMD_SSE2
+#define QRTONE_SIMD_LANES 4
+#elif !defined(QRTONE_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define QRTONE_SIMD_NEON
+#define QRTONE_SIMD_LANES 4
+#else
+#define QRTONE_SIMD_LANES 1
+#endif
+
 #define QRTONE_2PI 6.283185307179586f
 #define QRTONE_PI 3.14159265358979323846f
 
@@ -80,6 +98,27 @@
 #define HEADER_SIZE 3
 #define HEADER_ECC_SYMBOLS 2
 #define HEADER_SYMBOLS HEADER_SIZE * 2 + HEADER_ECC_SYMBOLS
+// Largest Reed-Solomon block of ECC_SYMBOLS
+#define QRTONE_MAX_BLOCK_SYMBOLS 14
+// Number of least reliable symbols of a message substituted by the soft decision decoding
+#define QRTONE_SOFT_DECISION_POSITIONS 16
+// "QRTS" first bytes of a snapshot of the decoder state
+#define QRTONE_SNAPSHOT_MAGIC 0x53545251
+// Ordering of the capture ring indices. The producer publishes the samples before the write index, the consumer releases
+// the space after reading the samples. Other compilers can define these macros with the barriers of the target
+#ifndef QRTONE_RING_LOAD_ACQUIRE
+#if defined(__GNUC__) || defined(__clang__)
+#define QRTONE_RING_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define QRTONE_RING_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define QRTONE_RING_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define QRTONE_RING_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define QRTONE_RING_LOAD(p) (*(volatile uint32_t*)(p))
+#define QRTONE_RING_STORE(p, v) (*(volatile uint32_t*)(p) = (v))
+#define QRTONE_RING_LOAD_ACQUIRE(p) (*(volatile uint32_t*)(p))
+#define QRTONE_RING_STORE_RELEASE(p, v) (*(volatile uint32_t*)(p) = (v))
+#endif
+#endif
 
 #ifdef TRUE
 #undef TRUE
@@ -103,13 +142,80 @@ const int32_t ECC_SYMBOLS[][2] = { {14, 2}, {14, 4}, {12, 6}, {10, 6} };
 #define QRTONE_WORD_SILENCE_TIME 0.01f
 #define QRTONE_GATE_TIME 0.12f
 #define QRTONE_AUDIBLE_FIRST_FREQUENCY 1720
+#define QRTONE_INAUDIBLE_FIRST_FREQUENCY 18200
+#define QRTONE_INAUDIBLE_STEP 50
 #define QRTONE_DEFAULT_TRIGGER_SNR 15
+#define QRTONE_DEFAULT_ERASURE_MARGIN 6.0f
+#define QRTONE_DEFAULT_SOFT_DECISION_BUDGET 64
+#define QRTONE_DEFAULT_PARSERS 2
+#define QRTONE_MAX_PARSERS 8
+#define QRTONE_FAST_WORD_TIME 0.03f
+#define QRTONE_FAST_WORD_SILENCE_TIME 0.005f
+#define QRTONE_FAST_GATE_TIME 0.08f
+// shortest tone, in samples, that can be detected by the goertzel filters
+#define QRTONE_MIN_WORD_LENGTH 32
 #define QRTONE_DEFAULT_ECC_LEVEL QRTONE_ECC_Q
 #define QRTONE_PERCENTILE_BACKGROUND 0.5f
 #define QRTONE_TUKEY_ALPHA 0.5f
 // Frequency analysis window width is dependent of analyzed frequencies
 // Tone frequency may be not the expected one, so neighbors tone frequency values are accumulated
 #define QRTONE_WINDOW_WIDTH 0.65f
+// Sliding dft of the gate frequencies, shortest and longest hop relative to the analysis window
+#define QRTONE_MIN_TRIGGER_HOP_RATIO 0.0625f
+#define QRTONE_MAX_TRIGGER_HOP_RATIO 0.5f
+// Weight of the oldest sample of the sliding dft window. The resonators poles are moved inside the unit circle
+// so that the float rounding errors fade out instead of accumulating on long idle streams
+#define QRTONE_SLIDING_DFT_DECAY 0.9f
+// Bins k-1, k and k+1 of the two gate frequencies, the hann window is applied in the frequency domain
+#define QRTONE_SLIDING_DFT_BINS 6
+// Largest decimation factor of the receiver input
+#define QRTONE_MAX_DECIMATION 8
+// Smallest transition band of the decimation filter chosen from the band of the tones, relative to the decimated sample rate
+#define QRTONE_DECIMATION_TRANSITION 0.25f
+// Transition band of a blackman windowed sinc in bins of the filter length, about 74 dB of stop band attenuation
+#define QRTONE_DECIMATION_BLACKMAN_WIDTH 5.5f
+// Decimated samples given at once to the analysis
+#define QRTONE_DECIMATION_BLOCK 256
+
+#ifdef QRTONE_FIXED_POINT
+// Samples are Q15, hann window products are shifted into Q14 filter states to keep headroom for the resonators
+#define QRTONE_FIXED_STATE_BITS 14
+#define QRTONE_FIXED_INPUT_SHIFT (30 - QRTONE_FIXED_STATE_BITS)
+// Goertzel coefficients 2*cos(pik_term) are Q29
+#define QRTONE_FIXED_COEFFICIENT_BITS 29
+// Levels are base 2 logarithm of the squared rms in Q16
+#define QRTONE_FIXED_LEVEL_BITS 16
+#define QRTONE_FIXED_LEVEL_ZERO (-64 * (1 << QRTONE_FIXED_LEVEL_BITS))
+// 10 * log10(2), convert levels to dB
+#define QRTONE_FIXED_DB_PER_LEVEL 3.0102999566398120f
+// One period of cosine in Q15, the phase is stored on 32 bits
+#define QRTONE_FIXED_COS_SIZE 256
+#define QRTONE_FIXED_LOG2_SIZE 32
+static const int16_t QRTONE_FIXED_COS[QRTONE_FIXED_COS_SIZE + 1] = {
+    32767, 32758, 32729, 32679, 32610, 32522, 32413, 32286, 32138, 31972, 31786, 31581, 31357, 31114, 30853, 30572,
+    30274, 29957, 29622, 29269, 28899, 28511, 28106, 27684, 27246, 26791, 26320, 25833, 25330, 24812, 24279, 23732,
+    23170, 22595, 22006, 21403, 20788, 20160, 19520, 18868, 18205, 17531, 16846, 16151, 15447, 14733, 14010, 13279,
+    12540, 11793, 11039, 10279, 9512, 8740, 7962, 7180, 6393, 5602, 4808, 4011, 3212, 2411, 1608, 804,
+    0, -804, -1608, -2411, -3212, -4011, -4808, -5602, -6393, -7180, -7962, -8740, -9512, -10279, -11039, -11793,
+    -12540, -13279, -14010, -14733, -15447, -16151, -16846, -17531, -18205, -18868, -19520, -20160, -20788, -21403, -22006, -22595,
+    -23170, -23732, -24279, -24812, -25330, -25833, -26320, -26791, -27246, -27684, -28106, -28511, -28899, -29269, -29622, -29957,
+    -30274, -30572, -30853, -31114, -31357, -31581, -31786, -31972, -32138, -32286, -32413, -32522, -32610, -32679, -32729, -32758,
+    -32768, -32758, -32729, -32679, -32610, -32522, -32413, -32286, -32138, -31972, -31786, -31581, -31357, -31114, -30853, -30572,
+    -30274, -29957, -29622, -29269, -28899, -28511, -28106, -27684, -27246, -26791, -26320, -25833, -25330, -24812, -24279, -23732,
+    -23170, -22595, -22006, -21403, -20788, -20160, -19520, -18868, -18205, -17531, -16846, -16151, -15447, -14733, -14010, -13279,
+    -12540, -11793, -11039, -10279, -9512, -8740, -7962, -7180, -6393, -5602, -4808, -4011, -3212, -2411, -1608, -804,
+    0, 804, 1608, 2411, 3212, 4011, 4808, 5602, 6393, 7180, 7962, 8740, 9512, 10279, 11039, 11793,
+    12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531, 18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+    23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791, 27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+    30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972, 32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+    32767 };
+
+// log2(1 + i / 32) in Q16
+static const int32_t QRTONE_FIXED_LOG2[QRTONE_FIXED_LOG2_SIZE + 1] = {
+    0, 2909, 5732, 8473, 11136, 13727, 16248, 18704, 21098, 23433, 25711,
+    27936, 30109, 32234, 34312, 36346, 38336, 40286, 42196, 44068, 45904, 47705,
+    49472, 51207, 52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047, 65536 };
+#endif
 
 enum QRTONE_STATE { QRTONE_WAITING_TRIGGER, QRTONE_PARSING_SYMBOLS };
 
@@ -199,10 +305,67 @@ typedef struct _qrtone_goertzel_t {
     int32_t window_size;
     int32_t processed_samples;
     int8_t hann_window;
-    float* window_cache;
+    int8_t window_cache_shared; // window_cache is owned by another structure
+    const float* window_cache;
     int32_t window_cache_length;
 } qrtone_goertzel_t;
 
+/**
+ * Constant coefficients of the hann windowed Goertzel filters of all tone frequencies.
+ * Each filter analyze the window [window_begin;window_end[ of a word, the hann window is generated with a rotation.
+ */
+typedef struct _qrtone_goertzel_bank_coefficients_t {
+    float cos_pik_term2[QRTONE_NUM_FREQUENCIES];
+    float pik_term[QRTONE_NUM_FREQUENCIES];
+    float window_rotation_cos[QRTONE_NUM_FREQUENCIES];
+    float window_rotation_sin[QRTONE_NUM_FREQUENCIES];
+    float window_begin[QRTONE_NUM_FREQUENCIES];
+    float window_end[QRTONE_NUM_FREQUENCIES];
+    int32_t window_size[QRTONE_NUM_FREQUENCIES];
+#ifdef QRTONE_FIXED_POINT
+    int32_t fixed_cos_pik_term2[QRTONE_NUM_FREQUENCIES];
+    uint32_t fixed_window_phase_increment[QRTONE_NUM_FREQUENCIES]; // hann window phase step of one sample
+    int32_t fixed_window_begin[QRTONE_NUM_FREQUENCIES];
+    int32_t fixed_window_end[QRTONE_NUM_FREQUENCIES];
+    int32_t fixed_level_offset[QRTONE_NUM_FREQUENCIES]; // level of a unit filter power
+#endif
+} qrtone_goertzel_bank_coefficients_t;
+
+/**
+ * Structure of arrays holding the state of the Goertzel filters of all tone frequencies.
+ */
+typedef struct _qrtone_goertzel_bank_t {
+    float s1[QRTONE_NUM_FREQUENCIES];
+    float s2[QRTONE_NUM_FREQUENCIES];
+    float window_cos[QRTONE_NUM_FREQUENCIES];
+    float window_sin[QRTONE_NUM_FREQUENCIES];
+    const qrtone_goertzel_bank_coefficients_t* coefficients;
+} qrtone_goertzel_bank_t;
+
+#ifdef QRTONE_FIXED_POINT
+/**
+ * Integer state of the Goertzel filters of all tone frequencies, fed with int16 samples
+ */
+typedef struct _qrtone_goertzel_bank_fixed_t {
+    int32_t s1[QRTONE_NUM_FREQUENCIES];
+    int32_t s2[QRTONE_NUM_FREQUENCIES];
+    const qrtone_goertzel_bank_coefficients_t* coefficients;
+} qrtone_goertzel_bank_fixed_t;
+
+/**
+ * Hann windowed Goertzel filter fed with int16 samples
+ */
+typedef struct _qrtone_goertzel_fixed_t {
+    int32_t s1;
+    int32_t s2;
+    int32_t cos_pik_term2;
+    uint32_t window_phase_increment;
+    int32_t window_size;
+    int32_t processed_samples;
+    int32_t level_offset;
+} qrtone_goertzel_fixed_t;
+#endif
+
 typedef struct _qrtone_percentile_t {
     float* q;
     float* dn;
@@ -210,6 +373,8 @@ typedef struct _qrtone_percentile_t {
     int32_t* n;
     int32_t count;
     int32_t marker_count;
+    int32_t marker_capacity;
+    const qrtone_allocator_t* allocator;
 } qrtone_percentile_t;
 
 typedef struct _qrtone_array_t {
@@ -217,6 +382,7 @@ typedef struct _qrtone_array_t {
     int32_t values_length;
     int32_t cursor;
     int32_t inserted;
+    const qrtone_allocator_t* allocator;
 } qrtone_array_t;
 
 typedef struct _qrtone_peak_finder_t {
@@ -232,6 +398,15 @@ typedef struct _qrtone_peak_finder_t {
     int32_t min_decrease_count;
 } qrtone_peak_finder_t;
 
+/**
+ * Set of substituted symbols, bit i of mask is the i-th least reliable symbol
+ */
+typedef struct _qrtone_soft_decision_pattern_t {
+    uint32_t cost; // sum of the margins of the substituted symbols
+    uint32_t mask;
+    int32_t last; // highest bit of mask
+} qrtone_soft_decision_pattern_t;
+
 typedef struct _qrtone_header_t {
     uint8_t length; // payload length
     int8_t crc;
@@ -242,56 +417,259 @@ typedef struct _qrtone_header_t {
     int32_t number_of_symbols;
 } qrtone_header_t;
 
+/**
+ * Hann windowed sliding DFT of the two gate frequencies. A comb filter shared by damped resonators tuned on the bins of the window.
+ */
+typedef struct _qrtone_sliding_dft_t {
+    float* delay_line; // last window_size samples
+    int32_t delay_cursor;
+    int32_t window_size;
+    float comb_gain; // damping^window_size
+    float damping2; // damping^2
+    float gain; // restore the level of the undamped hann window
+    float coefficients[QRTONE_SLIDING_DFT_BINS]; // 2 * damping * cos(w)
+    float output_r[QRTONE_SLIDING_DFT_BINS]; // damping * cos(w)
+    float output_i[QRTONE_SLIDING_DFT_BINS]; // damping * sin(w)
+    float s1[QRTONE_SLIDING_DFT_BINS];
+    float s2[QRTONE_SLIDING_DFT_BINS];
+} qrtone_sliding_dft_t;
+
 typedef struct _qrtone_trigger_analyzer_t {
     int32_t processed_window_alpha;
     int32_t processed_window_beta;
-    int32_t window_offset;
+    int32_t window_offset; // samples between two levels
     int32_t gate_length;
+    qrtone_sliding_dft_t sliding_dft; // used if delay_line is not NULL, in place of the goertzel passes
+    int32_t sliding_remaining; // samples before the next level of the sliding dft
     qrtone_goertzel_t frequency_analyzers_alpha[2];
     qrtone_goertzel_t frequency_analyzers_beta[2];
+#ifdef QRTONE_FIXED_POINT
+    qrtone_goertzel_fixed_t fixed_analyzers_alpha[2];
+    qrtone_goertzel_fixed_t fixed_analyzers_beta[2];
+#endif
     qrtone_percentile_t background_noise_evaluator;
     qrtone_array_t spl_history[2];
     qrtone_peak_finder_t peak_finder;
     int32_t window_analyze;
     float frequencies[2];
     float sample_rate;
-    float* window_cache;
-    int32_t window_cache_length;
     float trigger_snr;
     int64_t first_tone_location;
+    float first_tone_offset; // interpolated peak location - first_tone_location in samples
     qrtone_level_callback_t level_callback;
     void* level_callback_data;
+    int32_t decimation; // levels locations are given to the level callback at the input sample rate
+    int32_t decimation_offset;
+    float idle_energy; // the goertzel passes skip the samples of a window while its energy is below, 0 to analyze all samples
+    float window_energy_alpha; // energy of the idle samples of the current window
+    float window_energy_beta;
+    float idle_level_scale; // squared rms of a gate filter fed with white noise of unit energy
+#ifdef QRTONE_FIXED_POINT
+    int64_t idle_energy_s16; // idle_energy of int16 samples
+    int64_t window_energy_s16_alpha;
+    int64_t window_energy_s16_beta;
+    int32_t idle_level_offset; // idle_level_scale of int16 samples, base 2 logarithm in Q16
+#endif
 } qrtone_trigger_analyzer_t;
 
+/**
+ * Constant parameters of a sample rate. Read only once initialized, it can be shared by any number of qrtone_t instances.
+ */
+struct _qrtone_profile_t {
+    qrtone_config_t config;
+    float sample_rate;
+    int32_t word_length;
+    int32_t gate_length;
+    int32_t word_silence_length;
+    float frequencies[QRTONE_NUM_FREQUENCIES];
+    qrtone_goertzel_bank_coefficients_t bank_coefficients;
+    float* trigger_window_cache; // first half of the hann window of the gate filters
+    int32_t trigger_window_cache_length;
+    int32_t trigger_hop; // hop of the sliding dft trigger, 0 for the goertzel passes
+    ecc_reed_solomon_encoder_t encoder; // field parameters, GF(16) generators are constant tables
+    int32_t symbols_capacity; // number of symbols of the largest message
+    uint16_t erasure_margin; // in 1/256 dB
+    int32_t decimation; // input samples of one analyzed sample, the receiver filters are computed at analysis_sample_rate
+    float analysis_sample_rate;
+    int32_t analysis_word_length;
+    int32_t analysis_gate_length;
+    int32_t decimator_taps_length; // length of the symmetric band limiting filter, 0 if decimation is 1
+    float* decimator_taps; // non zero taps of the first half of the filter, NULL if decimation is 1
+    int32_t* decimator_taps_index; // index of each tap of decimator_taps in the filter
+    int32_t decimator_folded_length; // number of decimator_taps
+    float decimator_center_tap;
+    int32_t decimator_offset; // input sample index of the analyzed sample 0, the delay of the filter is compensated
+#ifdef QRTONE_FIXED_POINT
+    int16_t* decimator_taps_fixed; // decimator_taps scaled by 2^decimator_fixed_shift
+    int32_t decimator_center_tap_fixed;
+    int32_t decimator_fixed_shift; // 15, lower if the sum of the products could overflow an int32
+#endif
+#ifdef QRTONE_FIXED_POINT
+    uint32_t fixed_tone_phase_increment[QRTONE_NUM_FREQUENCIES];
+    uint32_t fixed_gate_window_phase_increment;
+    uint32_t fixed_tukey_window_phase_increment; // hann window of the tukey tapers
+#endif
+    const qrtone_allocator_t* allocator;
+    ecc_allocator_t ecc_allocator;
+};
+
+/**
+ * Bump allocator over a caller-owned memory block
+ */
+typedef struct _qrtone_arena_t {
+    uint8_t* base;
+    size_t size;
+    size_t used;
+} qrtone_arena_t;
+
+/**
+ * Decoding state of a message, from its trigger to its last symbol
+ */
+typedef struct _qrtone_parser_t {
+    int8_t state; // QRTONE_WAITING_TRIGGER when the parser is free
+    qrtone_goertzel_bank_t frequency_analyzers;
+#ifdef QRTONE_FIXED_POINT
+    qrtone_goertzel_bank_fixed_t fixed_analyzers;
+#endif
+    int64_t trigger_location; // first_tone_location of the trigger
+    int64_t first_tone_sample_index; // moved to the first payload tone once the header is decoded
+    int64_t analyzed_samples; // pushed_samples once the pushed samples have been analyzed
+    int32_t symbol_index;
+    int8_t* symbols_cache;
+    int32_t symbols_cache_length;
+    uint16_t* symbols_margin; // level of each symbol of symbols_cache over the second highest tone, in 1/256 dB
+    int8_t* symbols_runner_up; // symbol of the second highest tone
+    int16_t* symbols_level; // level of the tone of each symbol in 1/256 dB
+    int16_t* symbols_noise; // mean level of the other tones in 1/256 dB
+    int32_t fixed_errors;
+    float timing_offset; // first_tone_offset of the trigger
+    qrtone_header_t header;
+    qrtone_header_t* header_cache; // NULL or pointer to header once decoded
+} qrtone_parser_t;
+
 typedef struct _qrtone_t {
-    int8_t qr_tone_state;
-    qrtone_goertzel_t frequency_analyzers[QRTONE_NUM_FREQUENCIES];
-    int64_t first_tone_sample_index;
+    qrtone_allocator_t user_allocator; // allocator provided on init
+    qrtone_allocator_t allocator; // accounting allocator used by all internal structures
+    qrtone_arena_t arena;
+    const qrtone_profile_t* profile;
+    qrtone_profile_t* owned_profile; // NULL or profile created by qrtone_init
+    size_t memory_usage;
+    size_t memory_peak;
+    int8_t allocation_failed;
     int32_t word_length;
     int32_t gate_length;
     int32_t word_silence_length;
-    float gate1_frequency;
-    float gate2_frequency;
     float sample_rate;
-    float frequencies[QRTONE_NUM_FREQUENCIES];
+    int32_t decimation;
+    int32_t analysis_word_length; // samples of a word at the analysis sample rate
+    float* decimator_history; // last decimator_taps_length input samples, written twice to be read contiguously
+    int32_t decimator_cursor;
+    int32_t decimator_phase; // input samples since the last analyzed sample
+    float* decimated_samples; // QRTONE_DECIMATION_BLOCK analyzed samples
+#ifdef QRTONE_FIXED_POINT
+    int16_t* decimator_history_s16; // decimator_history of the int16 samples
+    int16_t* decimated_samples_s16;
+#endif
     qrtone_trigger_analyzer_t trigger_analyzer;
     int8_t* symbols_to_deliver;
     int32_t symbols_to_deliver_length;
-    int8_t* symbols_cache;
-    int32_t symbols_cache_length;
-    qrtone_header_t* header_cache;
+    qrtone_parser_t* parsers; // messages parsed at the same time
+    int32_t parsers_length;
+    int8_t* symbols_scratch; // deinterleaved blocks, symbols_cache length is profile->symbols_capacity, symbols_scratch has QRTONE_MAX_BLOCK_SYMBOLS more
+    qrtone_parser_t* quality_parser; // parser of the last message, its symbols are reported by qrtone_get_symbols_quality
+    int32_t quality_symbols_length; // symbols of the last message reported by qrtone_get_symbols_quality
+    float timing_offset; // timing_offset of the parser of the last message
+    int64_t parsed_samples; // end of the last parsed message, triggers located before were caused by its tones
+    int64_t payload_sample_index; // start of the last message
+    qrtone_soft_decision_pattern_t* soft_decision_heap; // profile->config.soft_decision_budget + 1 patterns
     int64_t pushed_samples;
-    int32_t symbol_index;
-    int8_t* payload;
+    int8_t* payload; // NULL or pointer to the payload_buffer of the last message once decoded
+    int8_t* payload_buffer; // payload_cache or caller buffer receiving the decoded payloads
+    int8_t payload_cache[QRTONE_MAX_PAYLOAD_LENGTH];
     int32_t payload_length;
     int32_t fixed_errors;
+    qrtone_payload_callback_t payload_callback;
+    void* payload_callback_data;
     int32_t output_samples;
-    ecc_reed_solomon_encoder_t encoder;
     qrtone_iterative_tukey_t tukey;
     qrtone_iterative_hann_t hann;
     qrtone_iterative_tone_t tone[QRTONE_NUM_FREQUENCIES];
 } qrtone_t;
 
+/**
+ * Allocation prefix storing the block size, sized for the alignment of any type
+ */
+typedef union _qrtone_allocation_header_t {
+    size_t size;
+    void* p;
+    double d;
+    int64_t i;
+} qrtone_allocation_header_t;
+
+#define QRTONE_ALIGN(size) ((((size) + sizeof(qrtone_allocation_header_t) - 1) / sizeof(qrtone_allocation_header_t)) * sizeof(qrtone_allocation_header_t))
+
+void* qrtone_allocator_malloc(const qrtone_allocator_t* allocator, size_t size) {
+    if (allocator == NULL) {
+        return malloc(size);
+    }
+    return allocator->malloc_fn(allocator->ptr, size);
+}
+
+void qrtone_allocator_free(const qrtone_allocator_t* allocator, void* memory) {
+    if (allocator == NULL) {
+        free(memory);
+    } else if (memory != NULL) {
+        allocator->free_fn(allocator->ptr, memory);
+    }
+}
+
+void* qrtone_heap_malloc(void* ptr, size_t size) {
+    return malloc(size);
+}
+
+void qrtone_heap_free(void* ptr, void* memory) {
+    free(memory);
+}
+
+void* qrtone_arena_malloc(void* ptr, size_t size) {
+    qrtone_arena_t* arena = (qrtone_arena_t*)ptr;
+    size = QRTONE_ALIGN(size);
+    if (arena->size - arena->used < size) {
+        return NULL;
+    }
+    void* memory = arena->base + arena->used;
+    arena->used += size;
+    return memory;
+}
+
+void qrtone_arena_free(void* ptr, void* memory) {
+    // memory is released with the whole arena
+}
+
+/**
+ * Allocate from the user allocator and keep track of the instance memory usage
+ */
+void* qrtone_accounting_malloc(void* ptr, size_t size) {
+    qrtone_t* self = (qrtone_t*)ptr;
+    size_t block_size = QRTONE_ALIGN(sizeof(qrtone_allocation_header_t) + size);
+    qrtone_allocation_header_t* header = self->user_allocator.malloc_fn(self->user_allocator.ptr, block_size);
+    if (header == NULL) {
+        self->allocation_failed = TRUE;
+        return NULL;
+    }
+    header->size = block_size;
+    self->memory_usage += block_size;
+    self->memory_peak = max(self->memory_peak, self->memory_usage);
+    return header + 1;
+}
+
+void qrtone_accounting_free(void* ptr, void* memory) {
+    qrtone_t* self = (qrtone_t*)ptr;
+    qrtone_allocation_header_t* header = (qrtone_allocation_header_t*)memory - 1;
+    self->memory_usage -= header->size;
+    self->user_allocator.free_fn(self->user_allocator.ptr, header);
+}
+
 void qrtone_iterative_tone_reset(qrtone_iterative_tone_t* self) {
     self->index = 0;
     self->k2 = self->original_k2;
@@ -470,15 +848,17 @@ void qrtone_goertzel_init(qrtone_goertzel_t* self, float sample_rate, float freq
         self->sample_rate = sample_rate;
         self->window_size = window_size;
         self->hann_window = hann_window;
+        self->window_cache_shared = FALSE;
         if(hann_window) {
             // cache window
             self->window_cache_length = window_size / 2 + 1;
-            self->window_cache = malloc(sizeof(float) * self->window_cache_length);
+            float* window_cache = malloc(sizeof(float) * self->window_cache_length);
             int32_t i;
             for (i = 0; i < self->window_cache_length; i++) {
-                self->window_cache[i] = 1.0f;
+                window_cache[i] = 1.0f;
             }
-            qrtone_hann_window(self->window_cache, self->window_cache_length, window_size, 0);
+            qrtone_hann_window(window_cache, self->window_cache_length, window_size, 0);
+            self->window_cache = window_cache;
         } else {
             self->window_cache = NULL;
             self->window_cache_length = 0;
@@ -490,13 +870,25 @@ void qrtone_goertzel_init(qrtone_goertzel_t* self, float sample_rate, float freq
         qrtone_goertzel_reset(self);
 }
 
+/**
+ * Init a hann windowed goertzel filter using a window cache owned by the caller
+ * @param window_cache First half of the hann window of length window_size/2+1
+ */
+void qrtone_goertzel_init_shared_window(qrtone_goertzel_t* self, float sample_rate, float frequency, int32_t window_size, const float* window_cache, int32_t window_cache_length) {
+    qrtone_goertzel_init(self, sample_rate, frequency, window_size, 0);
+    self->hann_window = TRUE;
+    self->window_cache_shared = TRUE;
+    self->window_cache = window_cache;
+    self->window_cache_length = window_cache_length;
+}
+
 void qrtone_goertzel_free(qrtone_goertzel_t* self) {
-    if(self->hann_window) {
-        free(self->window_cache);
+    if(self->hann_window && !self->window_cache_shared) {
+        free((float*)self->window_cache);
     }
 }
 
-void qrtone_goertzel_process_samples(qrtone_goertzel_t* self, float* samples,int32_t samples_len) {
+void qrtone_goertzel_process_samples(qrtone_goertzel_t* self, const float* samples,int32_t samples_len) {
     if (self->processed_samples + samples_len <= self->window_size) {
         int32_t size;
         if (self->processed_samples + samples_len == self->window_size) {
@@ -510,15 +902,20 @@ void qrtone_goertzel_process_samples(qrtone_goertzel_t* self, float* samples,int
             size = samples_len;
         }
         int32_t i;
-        for (i = 0; i < size; i++) {
-            if (self->hann_window) {
+        if (self->hann_window) {
+            // window is applied in the filter update, source samples are left untouched
+            for (i = 0; i < size; i++) {
                 const float hann = i + self->processed_samples < self->window_cache_length ? self->window_cache[i + self->processed_samples] : self->window_cache[(self->window_size - 1) - (i + self->processed_samples)];
                 self->s0 = samples[i] * hann + self->cos_pik_term2 * self->s1 - self->s2;
-            } else {
+                self->s2 = self->s1;
+                self->s1 = self->s0;
+            }
+        } else {
+            for (i = 0; i < size; i++) {
                 self->s0 = samples[i] + self->cos_pik_term2 * self->s1 - self->s2;
+                self->s2 = self->s1;
+                self->s1 = self->s0;
             }
-            self->s2 = self->s1;
-            self->s1 = self->s0;
         }
         self->processed_samples += samples_len;
     }
@@ -541,6 +938,422 @@ float qrtone_goertzel_compute_rms(qrtone_goertzel_t* self) {
     return sqrtf((y.r * y.r + y.i * y.i) * 2.f) / self->window_size;
 }
 
+#ifdef QRTONE_FIXED_POINT
+/**
+ * @param phase Phase, a full period is 2^32
+ * @return Cosine in Q15
+ */
+int32_t qrtone_fixed_cos(uint32_t phase) {
+    // 8 bits of table index, 16 bits of linear interpolation
+    const uint32_t index = phase >> 24;
+    const int32_t fraction = (int32_t)((phase >> 8) & 0xFFFF);
+    const int32_t a = QRTONE_FIXED_COS[index];
+    return a + (((QRTONE_FIXED_COS[index + 1] - a) * fraction) >> 16);
+}
+
+/**
+ * @param phase Phase, a full period is 2^32
+ * @return Sine in Q15
+ */
+int32_t qrtone_fixed_sin(uint32_t phase) {
+    return qrtone_fixed_cos(phase - 0x40000000u);
+}
+
+int16_t qrtone_fixed_saturate(int32_t value) {
+    return (int16_t)(value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+}
+
+/**
+ * @return Base 2 logarithm of value in Q16, QRTONE_FIXED_LEVEL_ZERO if value is 0
+ */
+int32_t qrtone_fixed_log2(uint64_t value) {
+    if (value == 0) {
+        return QRTONE_FIXED_LEVEL_ZERO;
+    }
+    int32_t msb = 0;
+    int32_t shift;
+    for (shift = 32; shift > 0; shift >>= 1) {
+        if (value >> (msb + shift)) {
+            msb += shift;
+        }
+    }
+    // most significant bit moved to bit 31
+    const uint32_t mantissa = msb >= 31 ? (uint32_t)(value >> (msb - 31)) : (uint32_t)(value << (31 - msb));
+    // 5 bits of table index, 16 bits of linear interpolation
+    const int32_t index = (int32_t)((mantissa >> 26) & (QRTONE_FIXED_LOG2_SIZE - 1));
+    const int32_t fraction = (int32_t)((mantissa >> 10) & 0xFFFF);
+    const int32_t a = QRTONE_FIXED_LOG2[index];
+    return (msb << QRTONE_FIXED_LEVEL_BITS) + a + (((QRTONE_FIXED_LOG2[index + 1] - a) * fraction) >> 16);
+}
+
+/**
+ * Level of a hann windowed filter, the last windowed sample is 0
+ * @param level_offset Level of a unit filter power, see qrtone_fixed_level_offset
+ * @return Base 2 logarithm of the squared rms in Q16
+ */
+int32_t qrtone_fixed_level(int32_t s1, int32_t s2, int32_t cos_pik_term2, int32_t level_offset) {
+    const int64_t s0 = (((int64_t)cos_pik_term2 * s1) >> QRTONE_FIXED_COEFFICIENT_BITS) - s2;
+    // squared magnitude of s0 - s1 * exp(i * pik_term), the phase correction does not change the magnitude
+    const int64_t power = s0 * s0 + (int64_t)s1 * s1 - ((((int64_t)cos_pik_term2 * s0) >> QRTONE_FIXED_COEFFICIENT_BITS) * s1);
+    if (power <= 0) {
+        return QRTONE_FIXED_LEVEL_ZERO;
+    }
+    return qrtone_fixed_log2((uint64_t)power) + level_offset;
+}
+
+int32_t qrtone_fixed_coefficient(float pik_term) {
+    return (int32_t)floor(cos((double)pik_term) * 2.0 * (1 << QRTONE_FIXED_COEFFICIENT_BITS) + 0.5);
+}
+
+int32_t qrtone_fixed_level_offset(int32_t window_size) {
+    // squared rms is 2 * power / (window_size * 2^QRTONE_FIXED_STATE_BITS)^2
+    return (int32_t)floor((1.0 - 2.0 * log2((double)window_size) - 2.0 * QRTONE_FIXED_STATE_BITS) * (1 << QRTONE_FIXED_LEVEL_BITS) + 0.5);
+}
+
+uint32_t qrtone_fixed_window_phase_increment(int32_t window_size) {
+    return (uint32_t)(4294967296.0 / (window_size - 1));
+}
+
+/**
+ * @return level converted to dB
+ */
+float qrtone_fixed_level_to_db(int32_t level) {
+    return (float)level * (QRTONE_FIXED_DB_PER_LEVEL / (1 << QRTONE_FIXED_LEVEL_BITS));
+}
+
+/**
+ * @return level converted to 1/256 dB, saturated. QRTONE_FIXED_DB_PER_LEVEL * 256 / 65536 is 197283 / 2^24
+ */
+int16_t qrtone_fixed_level_to_q8(int64_t level) {
+    int64_t q8 = (level * 197283) >> 24;
+    return (int16_t)(q8 < INT16_MIN ? INT16_MIN : (q8 > INT16_MAX ? INT16_MAX : q8));
+}
+#endif
+
+/**
+ * @return level in dB converted to 1/256 dB, saturated
+ */
+int16_t qrtone_level_to_q8(float level) {
+    float q8 = level * 256.0f;
+    if (!(q8 > INT16_MIN)) {
+        // -inf level of a silent tone
+        return INT16_MIN;
+    }
+    return q8 < INT16_MAX ? (int16_t)q8 : INT16_MAX;
+}
+
+qrtone_goertzel_bank_t* qrtone_goertzel_bank_new(void) {
+    return malloc(sizeof(qrtone_goertzel_bank_t));
+}
+
+void qrtone_goertzel_bank_reset(qrtone_goertzel_bank_t* self) {
+    int32_t i;
+    for (i = 0; i < QRTONE_NUM_FREQUENCIES; i++) {
+        self->s1[i] = 0.f;
+        self->s2[i] = 0.f;
+        // hann window start with cos(0)
+        self->window_cos[i] = 1.f;
+        self->window_sin[i] = 0.f;
+    }
+}
+
+qrtone_goertzel_bank_coefficients_t* qrtone_goertzel_bank_coefficients_new(void) {
+    return malloc(sizeof(qrtone_goertzel_bank_coefficients_t));
+}
+
+/**
+ * Compute the coefficients of the Goertzel bank of hann windowed filters
+ * @param sample_rate Sample rate in Hz
+ * @param frequencies Array of QRTONE_NUM_FREQUENCIES frequencies to analyze
+ * @param window_sizes Array of QRTONE_NUM_FREQUENCIES window length. Each window is centered in the word.
+ * @param word_length Length of a word in samples
+ */
+void qrtone_goertzel_bank_coefficients_init(qrtone_goertzel_bank_coefficients_t* self, float sample_rate, const float* frequencies, const int32_t* window_sizes, int32_t word_length) {
+    int32_t i;
+    for (i = 0; i < QRTONE_NUM_FREQUENCIES; i++) {
+        self->window_size[i] = window_sizes[i];
+        // The last sample of the window is not processed as the hann window value is 0
+        self->window_begin[i] = (float)(word_length / 2 - window_sizes[i] / 2);
+        self->window_end[i] = self->window_begin[i] + (float)(window_sizes[i] - 1);
+        self->window_rotation_cos[i] = cosf(QRTONE_2PI / (window_sizes[i] - 1));
+        self->window_rotation_sin[i] = sinf(QRTONE_2PI / (window_sizes[i] - 1));
+        float samplingRateFactor = window_sizes[i] / sample_rate;
+        self->pik_term[i] = QRTONE_2PI * (frequencies[i] * samplingRateFactor) / window_sizes[i];
+        self->cos_pik_term2[i] = cosf(self->pik_term[i]) * 2.0f;
+#ifdef QRTONE_FIXED_POINT
+        self->fixed_cos_pik_term2[i] = qrtone_fixed_coefficient(self->pik_term[i]);
+        self->fixed_window_phase_increment[i] = qrtone_fixed_window_phase_increment(window_sizes[i]);
+        self->fixed_window_begin[i] = word_length / 2 - window_sizes[i] / 2;
+        self->fixed_window_end[i] = self->fixed_window_begin[i] + window_sizes[i] - 1;
+        self->fixed_level_offset[i] = qrtone_fixed_level_offset(window_sizes[i]);
+#endif
+    }
+}
+
+/**
+ * Init the Goertzel bank state
+ * @param coefficients Filters coefficients, must remain valid while the bank is in use
+ */
+void qrtone_goertzel_bank_init(qrtone_goertzel_bank_t* self, const qrtone_goertzel_bank_coefficients_t* coefficients) {
+    self->coefficients = coefficients;
+    qrtone_goertzel_bank_reset(self);
+}
+
+#if QRTONE_SIMD_LANES > 1
+#if defined(QRTONE_SIMD_AVX2)
+typedef __m256 qrtone_vfloat;
+typedef __m256 qrtone_vmask;
+#define QRTONE_VLOAD(p) _mm256_loadu_ps(p)
+#define QRTONE_VSTORE(p, a) _mm256_storeu_ps(p, a)
+#define QRTONE_VSET(v) _mm256_set1_ps(v)
+#define QRTONE_VADD(a, b) _mm256_add_ps(a, b)
+#define QRTONE_VSUB(a, b) _mm256_sub_ps(a, b)
+#define QRTONE_VMUL(a, b) _mm256_mul_ps(a, b)
+#define QRTONE_VIN_RANGE(v, lo, hi) _mm256_and_ps(_mm256_cmp_ps(v, lo, _CMP_GE_OQ), _mm256_cmp_ps(v, hi, _CMP_LT_OQ))
+#define QRTONE_VSELECT(m, a, b) _mm256_blendv_ps(b, a, m)
+#elif defined(QRTONE_SIMD_SSE2)
+typedef __m128 qrtone_vfloat;
+typedef __m128 qrtone_vmask;
+#define QRTONE_VLOAD(p) _mm_loadu_ps(p)
+#define QRTONE_VSTORE(p, a) _mm_storeu_ps(p, a)
+#define QRTONE_VSET(v) _mm_set1_ps(v)
+#define QRTONE_VADD(a, b) _mm_add_ps(a, b)
+#define QRTONE_VSUB(a, b) _mm_sub_ps(a, b)
+#define QRTONE_VMUL(a, b) _mm_mul_ps(a, b)
+#define QRTONE_VIN_RANGE(v, lo, hi) _mm_and_ps(_mm_cmpge_ps(v, lo), _mm_cmplt_ps(v, hi))
+#define QRTONE_VSELECT(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#elif defined(QRTONE_SIMD_NEON)
+typedef float32x4_t qrtone_vfloat;
+typedef uint32x4_t qrtone_vmask;
+#define QRTONE_VLOAD(p) vld1q_f32(p)
+#define QRTONE_VSTORE(p, a) vst1q_f32(p, a)
+#define QRTONE_VSET(v) vdupq_n_f32(v)
+#define QRTONE_VADD(a, b) vaddq_f32(a, b)
+#define QRTONE_VSUB(a, b) vsubq_f32(a, b)
+#define QRTONE_VMUL(a, b) vmulq_f32(a, b)
+#define QRTONE_VIN_RANGE(v, lo, hi) vandq_u32(vcgeq_f32(v, lo), vcltq_f32(v, hi))
+#define QRTONE_VSELECT(m, a, b) vbslq_f32(m, a, b)
+#endif
+
+/**
+ * Process QRTONE_SIMD_LANES filters at once. Filters outside of their window keep their state thanks to a lane mask.
+ */
+void qrtone_goertzel_bank_process_lanes(qrtone_goertzel_bank_t* self, int32_t first_lane, const float* samples, int32_t samples_len, int32_t position) {
+    const qrtone_goertzel_bank_coefficients_t* c = self->coefficients;
+    float begin = c->window_begin[first_lane];
+    float end = c->window_end[first_lane];
+    int32_t i;
+    for (i = 1; i < QRTONE_SIMD_LANES; i++) {
+        begin = min(begin, c->window_begin[first_lane + i]);
+        end = max(end, c->window_end[first_lane + i]);
+    }
+    // Skip samples where all filters of the lanes are idle
+    int32_t from = max(0, (int32_t)begin - position);
+    int32_t to = min(samples_len, (int32_t)end - position);
+    if (from >= to) {
+        return;
+    }
+    qrtone_vfloat s1 = QRTONE_VLOAD(self->s1 + first_lane);
+    qrtone_vfloat s2 = QRTONE_VLOAD(self->s2 + first_lane);
+    qrtone_vfloat window_cos = QRTONE_VLOAD(self->window_cos + first_lane);
+    qrtone_vfloat window_sin = QRTONE_VLOAD(self->window_sin + first_lane);
+    const qrtone_vfloat cos_pik_term2 = QRTONE_VLOAD(c->cos_pik_term2 + first_lane);
+    const qrtone_vfloat rotation_cos = QRTONE_VLOAD(c->window_rotation_cos + first_lane);
+    const qrtone_vfloat rotation_sin = QRTONE_VLOAD(c->window_rotation_sin + first_lane);
+    const qrtone_vfloat window_begin = QRTONE_VLOAD(c->window_begin + first_lane);
+    const qrtone_vfloat window_end = QRTONE_VLOAD(c->window_end + first_lane);
+    const qrtone_vfloat half = QRTONE_VSET(0.5f);
+    const qrtone_vfloat one = QRTONE_VSET(1.0f);
+    qrtone_vfloat sample_position = QRTONE_VSET((float)(position + from));
+    for (i = from; i < to; i++) {
+        const qrtone_vmask active = QRTONE_VIN_RANGE(sample_position, window_begin, window_end);
+        const qrtone_vfloat hann = QRTONE_VSUB(half, QRTONE_VMUL(half, window_cos));
+        const qrtone_vfloat s0 = QRTONE_VSUB(QRTONE_VADD(QRTONE_VMUL(QRTONE_VSET(samples[i]), hann), QRTONE_VMUL(cos_pik_term2, s1)), s2);
+        const qrtone_vfloat next_cos = QRTONE_VSUB(QRTONE_VMUL(window_cos, rotation_cos), QRTONE_VMUL(window_sin, rotation_sin));
+        const qrtone_vfloat next_sin = QRTONE_VADD(QRTONE_VMUL(window_sin, rotation_cos), QRTONE_VMUL(window_cos, rotation_sin));
+        s2 = QRTONE_VSELECT(active, s1, s2);
+        s1 = QRTONE_VSELECT(active, s0, s1);
+        window_cos = QRTONE_VSELECT(active, next_cos, window_cos);
+        window_sin = QRTONE_VSELECT(active, next_sin, window_sin);
+        sample_position = QRTONE_VADD(sample_position, one);
+    }
+    QRTONE_VSTORE(self->s1 + first_lane, s1);
+    QRTONE_VSTORE(self->s2 + first_lane, s2);
+    QRTONE_VSTORE(self->window_cos + first_lane, window_cos);
+    QRTONE_VSTORE(self->window_sin + first_lane, window_sin);
+}
+#endif
+
+/**
+ * Feed all filters of the bank with the provided word samples.
+ * @param samples Audio samples
+ * @param samples_len Number of samples
+ * @param position Location of the first sample in the word
+ */
+void qrtone_goertzel_bank_process_samples(qrtone_goertzel_bank_t* self, const float* samples, int32_t samples_len, int32_t position) {
+    int32_t idfreq;
+#if QRTONE_SIMD_LANES > 1
+    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq += QRTONE_SIMD_LANES) {
+        qrtone_goertzel_bank_process_lanes(self, idfreq, samples, samples_len, position);
+    }
+#else
+    const qrtone_goertzel_bank_coefficients_t* c = self->coefficients;
+    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
+        int32_t from = max(0, (int32_t)c->window_begin[idfreq] - position);
+        int32_t to = min(samples_len, (int32_t)c->window_end[idfreq] - position);
+        float s1 = self->s1[idfreq];
+        float s2 = self->s2[idfreq];
+        float window_cos = self->window_cos[idfreq];
+        float window_sin = self->window_sin[idfreq];
+        const float cos_pik_term2 = c->cos_pik_term2[idfreq];
+        const float rotation_cos = c->window_rotation_cos[idfreq];
+        const float rotation_sin = c->window_rotation_sin[idfreq];
+        int32_t i;
+        for (i = from; i < to; i++) {
+            const float s0 = samples[i] * (0.5f - 0.5f * window_cos) + cos_pik_term2 * s1 - s2;
+            const float next_cos = window_cos * rotation_cos - window_sin * rotation_sin;
+            window_sin = window_sin * rotation_cos + window_cos * rotation_sin;
+            window_cos = next_cos;
+            s2 = s1;
+            s1 = s0;
+        }
+        self->s1[idfreq] = s1;
+        self->s2[idfreq] = s2;
+        self->window_cos[idfreq] = window_cos;
+        self->window_sin[idfreq] = window_sin;
+    }
+#endif
+}
+
+/**
+ * Compute the RMS value of all filters then reset the bank for the next word
+ * @param rms Output array of QRTONE_NUM_FREQUENCIES values
+ */
+void qrtone_goertzel_bank_compute_rms(qrtone_goertzel_bank_t* self, float* rms) {
+    const qrtone_goertzel_bank_coefficients_t* c = self->coefficients;
+    int32_t idfreq;
+    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
+        // final computations, the last windowed sample is always 0
+        const float s0 = c->cos_pik_term2[idfreq] * self->s1[idfreq] - self->s2[idfreq];
+        qrtonecomplex cc = CX_EXP(NEW_CX(c->pik_term[idfreq], 0));
+        qrtonecomplex parta = CX_SUB(NEW_CX(s0, 0), CX_MUL(NEW_CX(self->s1[idfreq], 0), cc));
+        qrtonecomplex partb = CX_EXP(NEW_CX(c->pik_term[idfreq] * (c->window_size[idfreq] - 1.0f), 0));
+        qrtonecomplex y = CX_MUL(parta, partb);
+        rms[idfreq] = sqrtf((y.r * y.r + y.i * y.i) * 2.f) / c->window_size[idfreq];
+    }
+    qrtone_goertzel_bank_reset(self);
+}
+
+#ifdef QRTONE_FIXED_POINT
+qrtone_goertzel_bank_fixed_t* qrtone_goertzel_bank_fixed_new(void) {
+    return malloc(sizeof(qrtone_goertzel_bank_fixed_t));
+}
+
+void qrtone_goertzel_bank_fixed_reset(qrtone_goertzel_bank_fixed_t* self) {
+    int32_t i;
+    for (i = 0; i < QRTONE_NUM_FREQUENCIES; i++) {
+        self->s1[i] = 0;
+        self->s2[i] = 0;
+    }
+}
+
+/**
+ * Init the integer Goertzel bank state
+ * @param coefficients Filters coefficients, must remain valid while the bank is in use
+ */
+void qrtone_goertzel_bank_fixed_init(qrtone_goertzel_bank_fixed_t* self, const qrtone_goertzel_bank_coefficients_t* coefficients) {
+    self->coefficients = coefficients;
+    qrtone_goertzel_bank_fixed_reset(self);
+}
+
+/**
+ * Feed all filters of the bank with the provided word samples.
+ * @param samples Audio samples in Q15
+ * @param samples_len Number of samples
+ * @param position Location of the first sample in the word
+ */
+void qrtone_goertzel_bank_fixed_process_samples(qrtone_goertzel_bank_fixed_t* self, const int16_t* samples, int32_t samples_len, int32_t position) {
+    const qrtone_goertzel_bank_coefficients_t* c = self->coefficients;
+    int32_t idfreq;
+    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
+        int32_t from = max(0, c->fixed_window_begin[idfreq] - position);
+        int32_t to = min(samples_len, c->fixed_window_end[idfreq] - position);
+        int32_t s1 = self->s1[idfreq];
+        int32_t s2 = self->s2[idfreq];
+        const int32_t cos_pik_term2 = c->fixed_cos_pik_term2[idfreq];
+        const uint32_t phase_increment = c->fixed_window_phase_increment[idfreq];
+        uint32_t phase = (uint32_t)(position + from - c->fixed_window_begin[idfreq]) * phase_increment;
+        int32_t i;
+        for (i = from; i < to; i++) {
+            const int32_t hann = (32768 - qrtone_fixed_cos(phase)) >> 1;
+            const int32_t s0 = ((samples[i] * hann) >> QRTONE_FIXED_INPUT_SHIFT) + (int32_t)(((int64_t)cos_pik_term2 * s1) >> QRTONE_FIXED_COEFFICIENT_BITS) - s2;
+            s2 = s1;
+            s1 = s0;
+            phase += phase_increment;
+        }
+        self->s1[idfreq] = s1;
+        self->s2[idfreq] = s2;
+    }
+}
+
+/**
+ * Compute the level of all filters then reset the bank for the next word
+ * @param levels Output array of QRTONE_NUM_FREQUENCIES base 2 logarithm of the squared rms in Q16
+ */
+void qrtone_goertzel_bank_fixed_compute_levels(qrtone_goertzel_bank_fixed_t* self, int32_t* levels) {
+    const qrtone_goertzel_bank_coefficients_t* c = self->coefficients;
+    int32_t idfreq;
+    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
+        levels[idfreq] = qrtone_fixed_level(self->s1[idfreq], self->s2[idfreq], c->fixed_cos_pik_term2[idfreq], c->fixed_level_offset[idfreq]);
+    }
+    qrtone_goertzel_bank_fixed_reset(self);
+}
+
+void qrtone_goertzel_fixed_reset(qrtone_goertzel_fixed_t* self) {
+    self->s1 = 0;
+    self->s2 = 0;
+    self->processed_samples = 0;
+}
+
+void qrtone_goertzel_fixed_init(qrtone_goertzel_fixed_t* self, float sample_rate, float frequency, int32_t window_size) {
+    self->window_size = window_size;
+    self->cos_pik_term2 = qrtone_fixed_coefficient(QRTONE_2PI * frequency / sample_rate);
+    self->window_phase_increment = qrtone_fixed_window_phase_increment(window_size);
+    self->level_offset = qrtone_fixed_level_offset(window_size);
+    qrtone_goertzel_fixed_reset(self);
+}
+
+void qrtone_goertzel_fixed_process_samples(qrtone_goertzel_fixed_t* self, const int16_t* samples, int32_t samples_len) {
+    if (self->processed_samples + samples_len <= self->window_size) {
+        // The last sample of the window is not processed as the hann window value is 0
+        const int32_t size = self->processed_samples + samples_len == self->window_size ? samples_len - 1 : samples_len;
+        uint32_t phase = (uint32_t)self->processed_samples * self->window_phase_increment;
+        int32_t s1 = self->s1;
+        int32_t s2 = self->s2;
+        int32_t i;
+        for (i = 0; i < size; i++) {
+            const int32_t hann = (32768 - qrtone_fixed_cos(phase)) >> 1;
+            const int32_t s0 = ((samples[i] * hann) >> QRTONE_FIXED_INPUT_SHIFT) + (int32_t)(((int64_t)self->cos_pik_term2 * s1) >> QRTONE_FIXED_COEFFICIENT_BITS) - s2;
+            s2 = s1;
+            s1 = s0;
+            phase += self->window_phase_increment;
+        }
+        self->s1 = s1;
+        self->s2 = s2;
+        self->processed_samples += samples_len;
+    }
+}
+
+/**
+ * @return Base 2 logarithm of the squared rms in Q16
+ */
+int32_t qrtone_goertzel_fixed_compute_level(qrtone_goertzel_fixed_t* self) {
+    const int32_t level = qrtone_fixed_level(self->s1, self->s2, self->cos_pik_term2, self->level_offset);
+    qrtone_goertzel_fixed_reset(self);
+    return level;
+}
+#endif
+
 /**
  * Simple bubblesort, because bubblesort is efficient for small count, and count is likely to be small
  * https://github.com/absmall/p2
@@ -583,14 +1396,18 @@ void qrtone_percentile_update_markers(qrtone_percentile_t* self) {
  */
 void qrtone_percentile_add_end_markers(qrtone_percentile_t* self) {
     self->marker_count = 2;
-    self->q = malloc(sizeof(float) * self->marker_count);
-    self->dn = malloc(sizeof(float) * self->marker_count);
-    self->np = malloc(sizeof(float) * self->marker_count);
-    self->n = malloc(sizeof(float) * self->marker_count);
-    memset(self->q, 0, sizeof(float) * self->marker_count);
-    memset(self->dn, 0, sizeof(float) * self->marker_count);
-    memset(self->np, 0, sizeof(float) * self->marker_count);
-    memset(self->n, 0, sizeof(float) * self->marker_count);
+    self->marker_capacity = max(self->marker_capacity, self->marker_count);
+    self->q = qrtone_allocator_malloc(self->allocator, sizeof(float) * self->marker_capacity);
+    self->dn = qrtone_allocator_malloc(self->allocator, sizeof(float) * self->marker_capacity);
+    self->np = qrtone_allocator_malloc(self->allocator, sizeof(float) * self->marker_capacity);
+    self->n = qrtone_allocator_malloc(self->allocator, sizeof(int32_t) * self->marker_capacity);
+    if (self->q == NULL || self->dn == NULL || self->np == NULL || self->n == NULL) {
+        return;
+    }
+    memset(self->q, 0, sizeof(float) * self->marker_capacity);
+    memset(self->dn, 0, sizeof(float) * self->marker_capacity);
+    memset(self->np, 0, sizeof(float) * self->marker_capacity);
+    memset(self->n, 0, sizeof(int32_t) * self->marker_capacity);
     self->dn[0] = 0.0;
     self->dn[1] = 1.0;
     qrtone_percentile_update_markers(self);
@@ -602,6 +1419,8 @@ void qrtone_percentile_add_end_markers(qrtone_percentile_t* self) {
  */
 void qrtone_percentile_init(qrtone_percentile_t* self) {
     self->count = 0;
+    self->marker_capacity = 0;
+    self->allocator = NULL;
     qrtone_percentile_add_end_markers(self);
 }
 
@@ -610,10 +1429,15 @@ void qrtone_percentile_init(qrtone_percentile_t* self) {
  * @author Aaron Small
  */
 int32_t qrtone_percentile_allocate_markers(qrtone_percentile_t* self, int32_t count) {
-    float* new_q = malloc(sizeof(float) * ((int64_t)self->marker_count + (int64_t)count));
-    float* new_dn = malloc(sizeof(float) * ((int64_t)self->marker_count + (int64_t)count));
-    float* new_np = malloc(sizeof(float) * ((int64_t)self->marker_count + (int64_t)count));
-    int32_t* new_n = malloc(sizeof(int32_t) * ((int64_t)self->marker_count + (int64_t)count));
+    if (self->marker_count + count <= self->marker_capacity) {
+        // markers have been allocated on init
+        self->marker_count += count;
+        return self->marker_count - count;
+    }
+    float* new_q = qrtone_allocator_malloc(self->allocator, sizeof(float) * ((int64_t)self->marker_count + (int64_t)count));
+    float* new_dn = qrtone_allocator_malloc(self->allocator, sizeof(float) * ((int64_t)self->marker_count + (int64_t)count));
+    float* new_np = qrtone_allocator_malloc(self->allocator, sizeof(float) * ((int64_t)self->marker_count + (int64_t)count));
+    int32_t* new_n = qrtone_allocator_malloc(self->allocator, sizeof(int32_t) * ((int64_t)self->marker_count + (int64_t)count));
 
     memset(new_q + self->marker_count, 0, sizeof(float) * count);
     memset(new_dn + self->marker_count, 0, sizeof(float) * count);
@@ -625,10 +1449,10 @@ int32_t qrtone_percentile_allocate_markers(qrtone_percentile_t* self, int32_t co
     memcpy(new_np, self->np, sizeof(float) * self->marker_count);
     memcpy(new_n, self->n, sizeof(int32_t) * self->marker_count);
 
-    free(self->q);
-    free(self->dn);
-    free(self->np);
-    free(self->n);
+    qrtone_allocator_free(self->allocator, self->q);
+    qrtone_allocator_free(self->allocator, self->dn);
+    qrtone_allocator_free(self->allocator, self->np);
+    qrtone_allocator_free(self->allocator, self->n);
 
     self->q = new_q;
     self->dn = new_dn;
@@ -636,6 +1460,7 @@ int32_t qrtone_percentile_allocate_markers(qrtone_percentile_t* self, int32_t co
     self->n = new_n;
 
     self->marker_count += count;
+    self->marker_capacity = self->marker_count;
 
     return self->marker_count - count;
 }
@@ -665,14 +1490,23 @@ qrtone_percentile_t* qrtone_percentile_new(void) {
  *
  * @author Aaron Small
  */
-void qrtone_percentile_init_quantile(qrtone_percentile_t* self, float quant) {
+void qrtone_percentile_init_quantile_allocator(qrtone_percentile_t* self, float quant, const qrtone_allocator_t* allocator) {
     if (quant >= 0 && quant <= 1) {
         self->count = 0;
+        self->allocator = allocator;
+        // end markers and quantile markers
+        self->marker_capacity = 5;
         qrtone_percentile_add_end_markers(self);
-        qrtone_percentile_add_quantile(self, quant);
+        if (self->n != NULL) {
+            qrtone_percentile_add_quantile(self, quant);
+        }
     }
 }
 
+void qrtone_percentile_init_quantile(qrtone_percentile_t* self, float quant) {
+    qrtone_percentile_init_quantile_allocator(self, quant, NULL);
+}
+
 /**
  * @author Aaron Small
  */
@@ -785,24 +1619,31 @@ float qrtone_percentile_result(qrtone_percentile_t* self) {
 }
 
 void qrtone_percentile_free(qrtone_percentile_t* self) {
-    free(self->q);
-    free(self->dn);
-    free(self->np);
-    free(self->n);
+    qrtone_allocator_free(self->allocator, self->q);
+    qrtone_allocator_free(self->allocator, self->dn);
+    qrtone_allocator_free(self->allocator, self->np);
+    qrtone_allocator_free(self->allocator, self->n);
 }
 
 qrtone_array_t* qrtone_array_new(void) {
     return malloc(sizeof(qrtone_array_t));
 }
 
-void qrtone_array_init(qrtone_array_t* self, int32_t length) {
-    self->values = malloc(sizeof(float) * length);
-    memset(self->values, 0, sizeof(float) * length);
+void qrtone_array_init_allocator(qrtone_array_t* self, int32_t length, const qrtone_allocator_t* allocator) {
+    self->allocator = allocator;
+    self->values = qrtone_allocator_malloc(allocator, sizeof(float) * length);
+    if (self->values != NULL) {
+        memset(self->values, 0, sizeof(float) * length);
+    }
     self->values_length = length;
     self->cursor = 0;
     self->inserted = 0;
 }
 
+void qrtone_array_init(qrtone_array_t* self, int32_t length) {
+    qrtone_array_init_allocator(self, length, NULL);
+}
+
 float qrtone_array_get(qrtone_array_t* self, int32_t index) {
     int32_t circular_index = self->cursor - self->inserted + index;
     if (circular_index < 0) {
@@ -825,7 +1666,7 @@ float qrtone_array_last(qrtone_array_t* self) {
 }
 
 void qrtone_array_free(qrtone_array_t* self) {
-    free(self->values);
+    qrtone_allocator_free(self->allocator, self->values);
 }
 
 void qrtone_array_add(qrtone_array_t* self, float value) {
@@ -974,11 +1815,15 @@ int8_t qrtone_header_init_from_data(qrtone_header_t* self, int8_t* data) {
     return TRUE;
 }
 
-void qrtone_compute_frequencies(float* frequencies, float offset) {
+void qrtone_compute_frequencies(const qrtone_config_t* config, float* frequencies, float offset) {
     // Precompute pitch frequencies
     int32_t i;
     for (i = 0; i < QRTONE_NUM_FREQUENCIES; i++) {
-        frequencies[i] = QRTONE_AUDIBLE_FIRST_FREQUENCY * powf(QRTONE_MULT_SEMITONE, i + offset);
+        if (config->frequency_increment != 0) {
+            frequencies[i] = config->first_frequency + (i + offset) * config->frequency_increment;
+        } else {
+            frequencies[i] = config->first_frequency * powf(config->frequency_multiplier, i + offset);
+        }
     }
 }
 
@@ -990,44 +1835,173 @@ int32_t qrtone_compute_minimum_window_size(float sampleRate, float targetFrequen
     return max(window_size, (int)ceil(sampleRate * (5.0 * (1.0 / targetFrequency))));
 }
 
-void qrtone_trigger_analyzer_init(qrtone_trigger_analyzer_t* self, float sample_rate, int32_t gate_length,int32_t window_analyze, float gate_frequencies[2], float trigger_snr) {
-    self->processed_window_alpha = 0;
-    self->processed_window_beta = 0;
-    self->level_callback = NULL;
-    self->level_callback_data = NULL;
-    self->first_tone_location = -1;
-    self->window_analyze = window_analyze;
-    self->sample_rate = sample_rate;
-    self->trigger_snr = trigger_snr;
-    self->gate_length = gate_length;
-    // 50% overlap
-    self->window_offset = self->window_analyze / 2;
-    qrtone_percentile_init_quantile(&(self->background_noise_evaluator), QRTONE_PERCENTILE_BACKGROUND);
-    int32_t i;
-    for (i = 0; i < 2; i++) {
-        self->frequencies[i] = gate_frequencies[i];
-        qrtone_goertzel_init(&(self->frequency_analyzers_alpha[i]), sample_rate, gate_frequencies[i], self->window_analyze, 0);
-        qrtone_goertzel_init(&(self->frequency_analyzers_beta[i]), sample_rate, gate_frequencies[i], self->window_analyze, 0);
-        qrtone_array_init(&(self->spl_history[i]), (gate_length * 3) / self->window_offset);
+void qrtone_sliding_dft_reset(qrtone_sliding_dft_t* self) {
+    if (self->delay_line != NULL) {
+        memset(self->delay_line, 0, sizeof(float) * self->window_size);
     }
-    int32_t slopeWindows = max(1, (gate_length / 2) / self->window_offset);
-    qrtone_peak_finder_init(&(self->peak_finder), -1, slopeWindows);
-    // cache hann window values
-    self->window_cache_length = self->window_analyze / 2 + 1;
-    self->window_cache = malloc(sizeof(float) * self->window_cache_length);
-    for(i = 0; i < self->window_cache_length; i++) {
-        self->window_cache[i] = 1.0f;
-    }
-    qrtone_hann_window(self->window_cache, self->window_cache_length, self->window_analyze, 0);
+    self->delay_cursor = 0;
+    memset(self->s1, 0, sizeof(self->s1));
+    memset(self->s2, 0, sizeof(self->s2));
 }
 
-void qrtone_trigger_analyzer_free(qrtone_trigger_analyzer_t* self) {
-    qrtone_percentile_free(&(self->background_noise_evaluator));
+/**
+ * Gate frequencies are rounded to the nearest bin of the window, the comb filter then cancels every resonator pole.
+ * @param window_size Length of the hann window
+ */
+void qrtone_sliding_dft_init(qrtone_sliding_dft_t* self, float sample_rate, float frequencies[2], int32_t window_size, const qrtone_allocator_t* allocator) {
+    self->window_size = window_size;
+    const double damping = pow(QRTONE_SLIDING_DFT_DECAY, 1.0 / window_size);
+    self->comb_gain = (float)pow(damping, window_size);
+    self->damping2 = (float)(damping * damping);
+    int32_t id_freq;
+    for (id_freq = 0; id_freq < 2; id_freq++) {
+        const int32_t bin = (int32_t)floorf(frequencies[id_freq] * window_size / sample_rate + 0.5f);
+        int32_t i;
+        for (i = 0; i < 3; i++) {
+            const double w = 2.0 * M_PI * (bin - 1 + i) / window_size;
+            self->coefficients[id_freq * 3 + i] = (float)(2.0 * damping * cos(w));
+            self->output_r[id_freq * 3 + i] = (float)(damping * cos(w));
+            self->output_i[id_freq * 3 + i] = (float)(damping * sin(w));
+        }
+    }
+    // Sum of the hann window over the sum of the damped hann window
+    double hann_sum = 0;
+    double damped_sum = 0;
+    int32_t m;
+    for (m = 0; m < window_size; m++) {
+        const double hann = 0.5 - 0.5 * cos(2.0 * M_PI * m / window_size);
+        hann_sum += hann;
+        damped_sum += hann * pow(damping, m);
+    }
+    self->gain = (float)(hann_sum / damped_sum);
+    self->delay_line = qrtone_allocator_malloc(allocator, sizeof(float) * window_size);
+    qrtone_sliding_dft_reset(self);
+}
+
+void qrtone_sliding_dft_free(qrtone_sliding_dft_t* self, const qrtone_allocator_t* allocator) {
+    qrtone_allocator_free(allocator, self->delay_line);
+    self->delay_line = NULL;
+}
+
+void qrtone_sliding_dft_process_samples(qrtone_sliding_dft_t* self, const float* samples, int32_t samples_length) {
+    int32_t i;
+    for (i = 0; i < samples_length; i++) {
+        // x[n] - r^N x[n-N] is shared by all the resonators
+        const float comb = samples[i] - self->comb_gain * self->delay_line[self->delay_cursor];
+        self->delay_line[self->delay_cursor] = samples[i];
+        self->delay_cursor = self->delay_cursor + 1 == self->window_size ? 0 : self->delay_cursor + 1;
+        int32_t b;
+        for (b = 0; b < QRTONE_SLIDING_DFT_BINS; b++) {
+            const float s0 = comb + self->coefficients[b] * self->s1[b] - self->damping2 * self->s2[b];
+            self->s2[b] = self->s1[b];
+            self->s1[b] = s0;
+        }
+    }
+}
+
+#ifdef QRTONE_FIXED_POINT
+/**
+ * The resonators stay in float, the int16 samples are converted by blocks
+ */
+void qrtone_sliding_dft_process_samples_s16(qrtone_sliding_dft_t* self, const int16_t* samples, int32_t samples_length) {
+    float buffer[64];
+    int32_t processed = 0;
+    while (processed < samples_length) {
+        const int32_t to_process = min(samples_length - processed, 64);
+        int32_t i;
+        for (i = 0; i < to_process; i++) {
+            buffer[i] = samples[processed + i] * (1.0f / 32768.0f);
+        }
+        qrtone_sliding_dft_process_samples(self, buffer, to_process);
+        processed += to_process;
+    }
+}
+#endif
+
+/**
+ * Levels of the last window_size samples
+ * @param spl_levels Levels of the two gate frequencies in dB
+ */
+void qrtone_sliding_dft_compute_levels(qrtone_sliding_dft_t* self, float spl_levels[2]) {
+    int32_t id_freq;
+    for (id_freq = 0; id_freq < 2; id_freq++) {
+        float r = 0;
+        float i = 0;
+        int32_t b;
+        for (b = id_freq * 3; b < id_freq * 3 + 3; b++) {
+            // X_k = s1 - r e^(-jw) s2, the hann window is 0.5 X_k - 0.25 X_k-1 - 0.25 X_k+1
+            const float weight = b == id_freq * 3 + 1 ? 0.5f : -0.25f;
+            r += weight * (self->s1[b] - self->output_r[b] * self->s2[b]);
+            i += weight * self->output_i[b] * self->s2[b];
+        }
+        const float rms = sqrtf((r * r + i * i) * 2.f) * self->gain / self->window_size;
+        // a window of zeros has a finite level, as in the goertzel passes
+        spl_levels[id_freq] = 20.0f * log10f(rms + FLT_MIN);
+    }
+}
+
+/**
+ * @param window_cache First half of the hann window of length window_analyze/2+1, must remain valid while the trigger is in use
+ * @param hop Samples between two levels computed by a sliding dft. 0 to use two goertzel passes with 50% overlap
+ * @param idle_level Level in dB of the idle goertzel windows, 0 to analyze all samples
+ */
+void qrtone_trigger_analyzer_init(qrtone_trigger_analyzer_t* self, float sample_rate, int32_t gate_length,int32_t window_analyze, int32_t hop, float gate_frequencies[2], float trigger_snr, float idle_level, const float* window_cache, const qrtone_allocator_t* allocator) {
+    self->processed_window_alpha = 0;
+    self->processed_window_beta = 0;
+    self->level_callback = NULL;
+    self->level_callback_data = NULL;
+    self->decimation = 1;
+    self->decimation_offset = 0;
+    self->first_tone_location = -1;
+    self->first_tone_offset = 0;
+    self->window_analyze = window_analyze;
+    self->sample_rate = sample_rate;
+    self->trigger_snr = trigger_snr;
+    self->gate_length = gate_length;
+    self->sliding_dft.delay_line = NULL;
+    self->idle_energy = idle_level < 0 ? window_analyze * powf(10.0f, idle_level / 10.0f) : 0;
+    self->window_energy_alpha = 0;
+    self->window_energy_beta = 0;
+    // the power of the hann window is 3/8, the rms of a tone is its amplitude / sqrt(2)
+    self->idle_level_scale = 0.75f / ((float)window_analyze * window_analyze);
+#ifdef QRTONE_FIXED_POINT
+    // 32768 is full scale
+    self->idle_energy_s16 = (int64_t)(self->idle_energy * 1073741824.0);
+    self->window_energy_s16_alpha = 0;
+    self->window_energy_s16_beta = 0;
+    self->idle_level_offset = (int32_t)floor((log2(0.75) - 2.0 * log2((double)window_analyze) - 30.0) * (1 << QRTONE_FIXED_LEVEL_BITS) + 0.5);
+#endif
+    if (hop > 0) {
+        self->window_offset = hop;
+        self->sliding_remaining = window_analyze;
+        qrtone_sliding_dft_init(&(self->sliding_dft), sample_rate, gate_frequencies, window_analyze, allocator);
+    } else {
+        // 50% overlap
+        self->window_offset = self->window_analyze / 2;
+    }
+    qrtone_percentile_init_quantile_allocator(&(self->background_noise_evaluator), QRTONE_PERCENTILE_BACKGROUND, allocator);
+    int32_t i;
+    for (i = 0; i < 2; i++) {
+        self->frequencies[i] = gate_frequencies[i];
+        qrtone_goertzel_init_shared_window(&(self->frequency_analyzers_alpha[i]), sample_rate, gate_frequencies[i], self->window_analyze, window_cache, self->window_analyze / 2 + 1);
+        qrtone_goertzel_init_shared_window(&(self->frequency_analyzers_beta[i]), sample_rate, gate_frequencies[i], self->window_analyze, window_cache, self->window_analyze / 2 + 1);
+#ifdef QRTONE_FIXED_POINT
+        qrtone_goertzel_fixed_init(&(self->fixed_analyzers_alpha[i]), sample_rate, gate_frequencies[i], self->window_analyze);
+        qrtone_goertzel_fixed_init(&(self->fixed_analyzers_beta[i]), sample_rate, gate_frequencies[i], self->window_analyze);
+#endif
+        qrtone_array_init_allocator(&(self->spl_history[i]), (gate_length * 3) / self->window_offset, allocator);
+    }
+    int32_t slopeWindows = max(1, (gate_length / 2) / self->window_offset);
+    qrtone_peak_finder_init(&(self->peak_finder), -1, slopeWindows);
+}
+
+void qrtone_trigger_analyzer_free(qrtone_trigger_analyzer_t* self, const qrtone_allocator_t* allocator) {
+    qrtone_percentile_free(&(self->background_noise_evaluator));
+    qrtone_sliding_dft_free(&(self->sliding_dft), allocator);
     int32_t i;
     for (i = 0; i < 2; i++) {
         qrtone_array_free(&(self->spl_history[i]));
     }
-    free(self->window_cache);
 }
 
 void qrtone_trigger_analyzer_reset(qrtone_trigger_analyzer_t* self) {
@@ -1035,10 +2009,22 @@ void qrtone_trigger_analyzer_reset(qrtone_trigger_analyzer_t* self) {
     qrtone_peak_finder_init(&(self->peak_finder), self->peak_finder.min_increase_count, self->peak_finder.min_decrease_count);
     self->processed_window_alpha = 0;
     self->processed_window_beta = 0;
+    self->sliding_remaining = self->window_analyze;
+    qrtone_sliding_dft_reset(&(self->sliding_dft));
+    self->window_energy_alpha = 0;
+    self->window_energy_beta = 0;
+#ifdef QRTONE_FIXED_POINT
+    self->window_energy_s16_alpha = 0;
+    self->window_energy_s16_beta = 0;
+#endif
     int32_t i;
     for (i = 0; i < 2; i++) {
         qrtone_goertzel_reset(&(self->frequency_analyzers_alpha[i]));
         qrtone_goertzel_reset(&(self->frequency_analyzers_beta[i]));
+#ifdef QRTONE_FIXED_POINT
+        qrtone_goertzel_fixed_reset(&(self->fixed_analyzers_alpha[i]));
+        qrtone_goertzel_fixed_reset(&(self->fixed_analyzers_beta[i]));
+#endif
         qrtone_array_clear(&(self->spl_history[i]));
     }
 }
@@ -1103,93 +2089,236 @@ int64_t qrtone_find_peak_location(float p0, float p1, float p2, int64_t p1_locat
     return p1_location + (int64_t)location * window_length;
 }
 
-void qrtone_trigger_analyzer_process(qrtone_trigger_analyzer_t* self, int64_t total_processed, float* samples, int32_t samples_length, int32_t* window_processed, qrtone_goertzel_t* frequency_analyzers) {
+/**
+ * Add the levels of an analysis window and look for the trigger pattern
+ * @param location Location of the first sample of the analysis window
+ * @param spl_levels Levels of the two gate frequencies in dB
+ */
+void qrtone_trigger_analyzer_add_levels(qrtone_trigger_analyzer_t* self, int64_t location, float spl_levels[2]) {
+    int32_t id_freq;
+    for (id_freq = 0; id_freq < 2; id_freq++) {
+        qrtone_array_add(self->spl_history + id_freq, spl_levels[id_freq]);
+    }
+    qrtone_percentile_add(&(self->background_noise_evaluator), spl_levels[1]);
+    int32_t triggered = 0;            
+    if (qrtone_peak_finder_add(&(self->peak_finder), location, (float)spl_levels[1])) {
+        // We found a peak
+        int64_t element_index = self->peak_finder.last_peak_index;
+        float element_value = self->peak_finder.last_peak_value;
+        float background_noise_second_peak = qrtone_percentile_result(&(self->background_noise_evaluator));
+        // Check if peak value is greater than specified Signal Noise ratio
+        if (element_value > background_noise_second_peak + self->trigger_snr) {
+            // Check if the level on other triggering frequencies is below triggering level (at the same time)
+            int32_t peak_index = qrtone_array_size(self->spl_history + 1) - 1 - (int32_t)(location / self->window_offset - element_index / self->window_offset);
+            if (peak_index >= 0 && peak_index < qrtone_array_size(self->spl_history) && qrtone_array_get(self->spl_history, peak_index) < element_value - self->trigger_snr) {
+                int32_t first_peak_index = peak_index - (self->gate_length / self->window_offset);
+                triggered = qrtone_array_get(self->spl_history, first_peak_index) > element_value - self->trigger_snr;
+                // Check if for the first peak the level was inferior than trigger level
+                if (self->first_tone_location == -1 && first_peak_index >= 0 && first_peak_index < qrtone_array_size(self->spl_history) &&
+                    qrtone_array_get(self->spl_history, first_peak_index) > element_value - self->trigger_snr &&
+                    qrtone_array_get(self->spl_history + 1, first_peak_index) < element_value - self->trigger_snr) {
+                    // All trigger conditions are met, the first trigger is kept until it is read
+                    // Evaluate the exact position of the first tone
+                    float p0 = qrtone_array_get(self->spl_history + 1, peak_index - 1);
+                    float p1 = qrtone_array_get(self->spl_history + 1, peak_index);
+                    float p2 = qrtone_array_get(self->spl_history + 1, peak_index + 1);
+                    int64_t peak_location = qrtone_find_peak_location(p0, p1, p2, element_index, self->window_offset);
+                    self->first_tone_location = peak_location + self->gate_length / 2 + self->window_analyze / 2;
+                    float location, height, half_curvature;
+                    qrtone_quadratic_interpolation(p0, p1, p2, &location, &height, &half_curvature);
+                    self->first_tone_offset = location * self->window_offset - (float)(peak_location - element_index);
+                }
+            }
+        }
+    }
+    if(self->level_callback != NULL) {
+        self->level_callback(self->level_callback_data, location * self->decimation + self->decimation_offset, (float)spl_levels[0], (float)spl_levels[1], triggered);
+    }
+}
+
+/**
+ * Accumulate the energy of the samples of an idle window
+ * @return Number of samples before the one that brings the energy to threshold, samples_length if the window is still idle
+ */
+int32_t qrtone_idle_samples(const float* samples, int32_t samples_length, float* energy, float threshold) {
+    float sum = *energy;
+    int32_t i;
+    for (i = 0; i < samples_length; i++) {
+        sum += samples[i] * samples[i];
+        if (sum >= threshold) {
+            break;
+        }
+    }
+    *energy = sum;
+    return i;
+}
+
+/**
+ * @param window_energy Energy of the idle samples of the window, the filters are run from the sample that brings it to idle_energy
+ */
+void qrtone_trigger_analyzer_process(qrtone_trigger_analyzer_t* self, int64_t total_processed, const float* samples, int32_t samples_length, int32_t* window_processed, float* window_energy, qrtone_goertzel_t* frequency_analyzers) {
     int32_t processed = 0;
-    while (self->first_tone_location == -1 && processed < samples_length) {
+    while (processed < samples_length) {
         int32_t to_process = min(samples_length - processed, self->window_analyze - *window_processed);
-        // Apply Hann window
-        int32_t i;
-        for (i = 0; i < to_process; i++) {
-            const float hann = i + *window_processed < self->window_cache_length ? self->window_cache[i + *window_processed] : self->window_cache[(self->window_analyze - 1) - (i + *window_processed)];
-            samples[i + processed] *= hann;
+        int32_t idle = 0;
+        if (*window_energy < self->idle_energy) {
+            idle = qrtone_idle_samples(samples + processed, to_process, window_energy, self->idle_energy);
         }
+        // Hann window is applied by the goertzel filters, the state of the filters is zero while the window is idle
         int32_t id_freq;
         for (id_freq = 0; id_freq < 2; id_freq++) {
-            qrtone_goertzel_process_samples(frequency_analyzers + id_freq, samples + processed, to_process);
+            frequency_analyzers[id_freq].processed_samples += idle;
+            if (idle < to_process) {
+                qrtone_goertzel_process_samples(frequency_analyzers + id_freq, samples + processed + idle, to_process - idle);
+            }
         }
         processed += to_process;
         *window_processed += to_process;
         if (*window_processed == self->window_analyze) {
             *window_processed = 0;
             float spl_levels[2];
-            for (id_freq = 0; id_freq < 2; id_freq++) {
-                float spl_level = 20.0f * log10f(qrtone_goertzel_compute_rms(frequency_analyzers + id_freq));
-                spl_levels[id_freq] = spl_level;
-                qrtone_array_add(self->spl_history + id_freq, (float)spl_level);
-            }
-            qrtone_percentile_add(&(self->background_noise_evaluator), spl_levels[1]);
-            int64_t location = total_processed + processed - self->window_analyze;
-            int32_t triggered = 0;            
-            if (qrtone_peak_finder_add(&(self->peak_finder), location, (float)spl_levels[1])) {
-                // We found a peak
-                int64_t element_index = self->peak_finder.last_peak_index;
-                float element_value = self->peak_finder.last_peak_value;
-                float background_noise_second_peak = qrtone_percentile_result(&(self->background_noise_evaluator));
-                // Check if peak value is greater than specified Signal Noise ratio
-                if (element_value > background_noise_second_peak + self->trigger_snr) {
-                    // Check if the level on other triggering frequencies is below triggering level (at the same time)
-                    int32_t peak_index = qrtone_array_size(self->spl_history + 1) - 1 - (int32_t)(location / self->window_offset - element_index / self->window_offset);
-                    if (peak_index >= 0 && peak_index < qrtone_array_size(self->spl_history) && qrtone_array_get(self->spl_history, peak_index) < element_value - self->trigger_snr) {
-                        int32_t first_peak_index = peak_index - (self->gate_length / self->window_offset);
-                        triggered = qrtone_array_get(self->spl_history, first_peak_index) > element_value - self->trigger_snr;
-                        // Check if for the first peak the level was inferior than trigger level
-                        if (first_peak_index >= 0 && first_peak_index < qrtone_array_size(self->spl_history) &&
-                            qrtone_array_get(self->spl_history, first_peak_index) > element_value - self->trigger_snr &&
-                            qrtone_array_get(self->spl_history + 1, first_peak_index) < element_value - self->trigger_snr) {
-                            // All trigger conditions are met
-                            // Evaluate the exact position of the first tone
-                            int64_t peak_location = qrtone_find_peak_location(qrtone_array_get(self->spl_history + 1, peak_index - 1),
-                                qrtone_array_get(self->spl_history + 1, peak_index), qrtone_array_get(self->spl_history + 1, peak_index + 1),
-                                element_index, self->window_offset);
-                            self->first_tone_location = peak_location + self->gate_length / 2 + self->window_offset;
-                        }
-                    }
+            if (*window_energy < self->idle_energy) {
+                // level of white noise of the same energy
+                spl_levels[0] = 10.0f * log10f(*window_energy * self->idle_level_scale + FLT_MIN);
+                spl_levels[1] = spl_levels[0];
+                for (id_freq = 0; id_freq < 2; id_freq++) {
+                    qrtone_goertzel_reset(frequency_analyzers + id_freq);
+                }
+            } else {
+                // a window of zeros has a finite level, the background noise percentile does not handle -inf
+                for (id_freq = 0; id_freq < 2; id_freq++) {
+                    spl_levels[id_freq] = 20.0f * log10f(qrtone_goertzel_compute_rms(frequency_analyzers + id_freq) + FLT_MIN);
                 }
             }
-            if(self->level_callback != NULL) {
-                self->level_callback(self->level_callback_data, total_processed + processed - self->window_analyze, (float)spl_levels[0], (float)spl_levels[1], triggered);
+            *window_energy = 0;
+            qrtone_trigger_analyzer_add_levels(self, total_processed + processed - self->window_analyze, spl_levels);
+        }
+    }
+}
+
+void qrtone_trigger_analyzer_process_sliding(qrtone_trigger_analyzer_t* self, int64_t total_processed, const float* samples, const int16_t* samples_s16, int32_t samples_length) {
+    int32_t processed = 0;
+    while (processed < samples_length) {
+        int32_t to_process = min(samples_length - processed, self->sliding_remaining);
+#ifdef QRTONE_FIXED_POINT
+        if (samples_s16 != NULL) {
+            qrtone_sliding_dft_process_samples_s16(&(self->sliding_dft), samples_s16 + processed, to_process);
+        } else
+#endif
+        {
+            qrtone_sliding_dft_process_samples(&(self->sliding_dft), samples + processed, to_process);
+        }
+        processed += to_process;
+        self->sliding_remaining -= to_process;
+        if (self->sliding_remaining == 0) {
+            self->sliding_remaining = self->window_offset;
+            float spl_levels[2];
+            qrtone_sliding_dft_compute_levels(&(self->sliding_dft), spl_levels);
+            qrtone_trigger_analyzer_add_levels(self, total_processed + processed - self->window_analyze, spl_levels);
+        }
+    }
+}
+
+void qrtone_trigger_analyzer_process_samples(qrtone_trigger_analyzer_t* self, int64_t total_processed, const float* samples, int32_t samples_length) {
+    if (self->sliding_dft.delay_line != NULL) {
+        qrtone_trigger_analyzer_process_sliding(self, total_processed, samples, NULL, samples_length);
+        return;
+    }
+    qrtone_trigger_analyzer_process(self, total_processed, samples, samples_length, &(self->processed_window_alpha), &(self->window_energy_alpha), self->frequency_analyzers_alpha);
+    if (total_processed > self->window_offset) {
+        qrtone_trigger_analyzer_process(self, total_processed, samples, samples_length, &(self->processed_window_beta), &(self->window_energy_beta), self->frequency_analyzers_beta);
+    } else if (self->window_offset - total_processed < samples_length) {
+        // Start to process on the part used by the offset window
+        int32_t from = (int32_t)(self->window_offset - total_processed);
+        qrtone_trigger_analyzer_process(self, total_processed + from, samples + from, samples_length - from, &(self->processed_window_beta), &(self->window_energy_beta), self->frequency_analyzers_beta);
+    }
+}
+
+#ifdef QRTONE_FIXED_POINT
+/**
+ * @see qrtone_idle_samples
+ */
+int32_t qrtone_idle_samples_s16(const int16_t* samples, int32_t samples_length, int64_t* energy, int64_t threshold) {
+    int64_t sum = *energy;
+    int32_t i;
+    for (i = 0; i < samples_length; i++) {
+        sum += (int32_t)samples[i] * samples[i];
+        if (sum >= threshold) {
+            break;
+        }
+    }
+    *energy = sum;
+    return i;
+}
+
+void qrtone_trigger_analyzer_process_s16(qrtone_trigger_analyzer_t* self, int64_t total_processed, const int16_t* samples, int32_t samples_length, int32_t* window_processed, int64_t* window_energy, qrtone_goertzel_fixed_t* frequency_analyzers) {
+    int32_t processed = 0;
+    while (processed < samples_length) {
+        int32_t to_process = min(samples_length - processed, self->window_analyze - *window_processed);
+        int32_t idle = 0;
+        if (*window_energy < self->idle_energy_s16) {
+            idle = qrtone_idle_samples_s16(samples + processed, to_process, window_energy, self->idle_energy_s16);
+        }
+        int32_t id_freq;
+        for (id_freq = 0; id_freq < 2; id_freq++) {
+            frequency_analyzers[id_freq].processed_samples += idle;
+            if (idle < to_process) {
+                qrtone_goertzel_fixed_process_samples(frequency_analyzers + id_freq, samples + processed + idle, to_process - idle);
+            }
+        }
+        processed += to_process;
+        *window_processed += to_process;
+        if (*window_processed == self->window_analyze) {
+            *window_processed = 0;
+            // Only the two levels of the analysis window are converted to float
+            float spl_levels[2];
+            if (*window_energy < self->idle_energy_s16) {
+                // level of white noise of the same energy
+                const int32_t level = *window_energy > 0 ? qrtone_fixed_log2((uint64_t)*window_energy) + self->idle_level_offset : QRTONE_FIXED_LEVEL_ZERO;
+                spl_levels[0] = qrtone_fixed_level_to_db(level);
+                spl_levels[1] = spl_levels[0];
+                for (id_freq = 0; id_freq < 2; id_freq++) {
+                    qrtone_goertzel_fixed_reset(frequency_analyzers + id_freq);
+                }
+            } else {
+                for (id_freq = 0; id_freq < 2; id_freq++) {
+                    spl_levels[id_freq] = qrtone_fixed_level_to_db(qrtone_goertzel_fixed_compute_level(frequency_analyzers + id_freq));
+                }
             }
+            *window_energy = 0;
+            qrtone_trigger_analyzer_add_levels(self, total_processed + processed - self->window_analyze, spl_levels);
         }
     }
 }
 
-void qrtone_trigger_analyzer_process_samples(qrtone_trigger_analyzer_t* self, int64_t total_processed, float* samples, int32_t samples_length) {
-    float* samples_alpha = malloc(sizeof(float) * samples_length);
-    memcpy(samples_alpha, samples, sizeof(float) * samples_length);
-    qrtone_trigger_analyzer_process(self, total_processed, samples_alpha, samples_length, &(self->processed_window_alpha), self->frequency_analyzers_alpha);
-    free(samples_alpha);
+void qrtone_trigger_analyzer_process_samples_s16(qrtone_trigger_analyzer_t* self, int64_t total_processed, const int16_t* samples, int32_t samples_length) {
+    if (self->sliding_dft.delay_line != NULL) {
+        qrtone_trigger_analyzer_process_sliding(self, total_processed, NULL, samples, samples_length);
+        return;
+    }
+    qrtone_trigger_analyzer_process_s16(self, total_processed, samples, samples_length, &(self->processed_window_alpha), &(self->window_energy_s16_alpha), self->fixed_analyzers_alpha);
     if (total_processed > self->window_offset) {
-        float* samples_beta = malloc(sizeof(float) * samples_length);
-        memcpy(samples_beta, samples, sizeof(float) * samples_length);
-        qrtone_trigger_analyzer_process(self, total_processed, samples_beta, samples_length, &(self->processed_window_beta), self->frequency_analyzers_beta);
-        free(samples_beta);
+        qrtone_trigger_analyzer_process_s16(self, total_processed, samples, samples_length, &(self->processed_window_beta), &(self->window_energy_s16_beta), self->fixed_analyzers_beta);
     } else if (self->window_offset - total_processed < samples_length) {
         // Start to process on the part used by the offset window
         int32_t from = (int32_t)(self->window_offset - total_processed);
-        int32_t length = samples_length - from;
-        float* samples_beta = malloc(sizeof(float) * length);
-        memcpy(samples_beta, samples + from, sizeof(float) * length);
-        qrtone_trigger_analyzer_process(self, total_processed + (int32_t)(self->window_offset - total_processed), samples_beta, length, &(self->processed_window_beta), self->frequency_analyzers_beta);
-        free(samples_beta);
+        qrtone_trigger_analyzer_process_s16(self, total_processed + from, samples + from, samples_length - from, &(self->processed_window_beta), &(self->window_energy_s16_beta), self->fixed_analyzers_beta);
     }
 }
+#endif
 
 int32_t qrtone_trigger_maximum_window_length(qrtone_trigger_analyzer_t * self) {
+    if (self->sliding_dft.delay_line != NULL) {
+        return self->sliding_remaining;
+    }
     return min(self->window_analyze - self->processed_window_alpha, self->window_analyze - self->processed_window_beta);
 }
 
-void qrtone_interleave_symbols(int8_t* symbols, int32_t symbols_length, int32_t block_size) {
-    int8_t* symbols_output = malloc(symbols_length);
+/**
+ * Permute symbols
+ * @param symbols_output Scratch buffer of length symbols_length
+ */
+void qrtone_interleave_symbols_buffer(int8_t* symbols, int32_t symbols_length, int32_t block_size, int8_t* symbols_output) {
     int32_t insertion_cursor = 0;
     int32_t j;
     for (j = 0; j < block_size; j++) {
@@ -1200,11 +2329,19 @@ void qrtone_interleave_symbols(int8_t* symbols, int32_t symbols_length, int32_t
         }
     }
     memcpy(symbols, symbols_output, symbols_length);
-    free(symbols_output);
 }
 
-void qrtone_deinterleave_symbols(int8_t* symbols, int32_t symbols_length, int32_t block_size) {
+void qrtone_interleave_symbols(int8_t* symbols, int32_t symbols_length, int32_t block_size) {
     int8_t* symbols_output = malloc(symbols_length);
+    qrtone_interleave_symbols_buffer(symbols, symbols_length, block_size, symbols_output);
+    free(symbols_output);
+}
+
+/**
+ * Cancel the permutation of symbols
+ * @param symbols_output Scratch buffer of length symbols_length
+ */
+void qrtone_deinterleave_symbols_buffer(int8_t* symbols, int32_t symbols_length, int32_t block_size, int8_t* symbols_output) {
     int32_t insertion_cursor = 0;
     int32_t j;
     for (j = 0; j < block_size; j++) {
@@ -1215,149 +2352,670 @@ void qrtone_deinterleave_symbols(int8_t* symbols, int32_t symbols_length, int32_
         }
     }
     memcpy(symbols, symbols_output, symbols_length);
-    free(symbols_output);
 }
 
-void qrtone_init(qrtone_t* self, float sample_rate) {
-    self->symbols_cache = NULL;
-    self->symbols_cache_length = 0;
-    self->symbols_to_deliver = NULL;
-    self->symbols_to_deliver_length = 0;
-    self->payload = NULL;
-    self->payload_length = 0;
-    self->first_tone_sample_index = -1;
-    self->pushed_samples = 0;
-    self->symbol_index = 0;
-    self->fixed_errors = 0;
-    self->qr_tone_state = QRTONE_WAITING_TRIGGER;
-    self->sample_rate = sample_rate;
-    self->word_length = (int32_t)(sample_rate * QRTONE_WORD_TIME);
-    self->gate_length = (int32_t)(sample_rate * QRTONE_GATE_TIME);
-    self->word_silence_length = (int32_t)(sample_rate * QRTONE_WORD_SILENCE_TIME);
-    qrtone_compute_frequencies(self->frequencies, 0);
-    self->gate1_frequency = self->frequencies[FREQUENCY_ROOT];
-    self->gate2_frequency = self->frequencies[FREQUENCY_ROOT + 2];
-    float gates_freq[2];
-    gates_freq[0] = self->gate1_frequency;
-    gates_freq[1] = self->gate2_frequency;
-    int32_t idfreq;
-    float close_frequencies[QRTONE_NUM_FREQUENCIES];
-    qrtone_compute_frequencies(close_frequencies, QRTONE_WINDOW_WIDTH);
-    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {        
-        int32_t adaptative_window = qrtone_compute_minimum_window_size(sample_rate, self->frequencies[idfreq], close_frequencies[idfreq]);
-        qrtone_goertzel_init(&(self->frequency_analyzers[idfreq]), sample_rate, self->frequencies[idfreq], min(self->word_length, adaptative_window), 1);
-        qrtone_iterative_tone_init(&(self->tone[idfreq]), self->frequencies[idfreq], self->sample_rate);
-    }
-    qrtone_trigger_analyzer_init(&(self->trigger_analyzer), sample_rate, self->gate_length, self->frequency_analyzers[FREQUENCY_ROOT].window_size ,gates_freq, QRTONE_DEFAULT_TRIGGER_SNR);
-    ecc_reed_solomon_encoder_init(&(self->encoder), 0x13, 16, 1);
-    self->header_cache = NULL;
-    qrtone_iterative_hann_init(&(self->hann), self->gate_length);
-    qrtone_iterative_tukey_init(&(self->tukey), QRTONE_TUKEY_ALPHA, self->word_length);
-    self->output_samples = 0;
+void qrtone_deinterleave_symbols(int8_t* symbols, int32_t symbols_length, int32_t block_size) {
+    int8_t* symbols_output = malloc(symbols_length);
+    qrtone_deinterleave_symbols_buffer(symbols, symbols_length, block_size, symbols_output);
+    free(symbols_output);
 }
 
-void qrtone_set_level_callback(qrtone_t* self, void* data, qrtone_level_callback_t lvl_callback) {    
-    self->trigger_analyzer.level_callback = lvl_callback;
-    self->trigger_analyzer.level_callback_data = data;
+qrtone_profile_t* qrtone_profile_new(void) {
+    return malloc(sizeof(qrtone_profile_t));
 }
 
+void qrtone_config_audible(qrtone_config_t* config, float sample_rate) {
+    config->sample_rate = sample_rate;
+    config->first_frequency = QRTONE_AUDIBLE_FIRST_FREQUENCY;
+    config->frequency_increment = 0;
+    config->frequency_multiplier = QRTONE_MULT_SEMITONE;
+    config->word_time = QRTONE_WORD_TIME;
+    config->word_silence_time = QRTONE_WORD_SILENCE_TIME;
+    config->gate_time = QRTONE_GATE_TIME;
+    config->trigger_snr = QRTONE_DEFAULT_TRIGGER_SNR;
+    config->trigger_hop_ratio = 0;
+    config->trigger_idle_level = 0;
+    config->erasure_margin = QRTONE_DEFAULT_ERASURE_MARGIN;
+    config->soft_decision_budget = QRTONE_DEFAULT_SOFT_DECISION_BUDGET;
+    config->parsers = QRTONE_DEFAULT_PARSERS;
+    config->decimation = 1;
+}
 
-int64_t qrtone_get_tone_location(qrtone_t* self) {
-    return self->first_tone_sample_index + (int64_t)self->symbol_index * ((int64_t)self->word_length + self->word_silence_length) + self->word_silence_length;
+void qrtone_config_fast(qrtone_config_t* config, float sample_rate) {
+    qrtone_config_audible(config, sample_rate);
+    config->word_time = QRTONE_FAST_WORD_TIME;
+    config->word_silence_time = QRTONE_FAST_WORD_SILENCE_TIME;
+    config->gate_time = QRTONE_FAST_GATE_TIME;
 }
 
+void qrtone_config_inaudible(qrtone_config_t* config, float sample_rate) {
+    qrtone_config_audible(config, sample_rate);
+    config->first_frequency = QRTONE_INAUDIBLE_FIRST_FREQUENCY;
+    config->frequency_increment = QRTONE_INAUDIBLE_STEP;
+    config->frequency_multiplier = 0;
+}
 
-int32_t qrtone_get_maximum_length(qrtone_t* self) {
-    if (self->qr_tone_state == QRTONE_WAITING_TRIGGER) {
-        return qrtone_trigger_maximum_window_length(&(self->trigger_analyzer));
-    } else {
-        return self->word_length + (int32_t)(self->pushed_samples - qrtone_get_tone_location(self));
+/**
+ * Check that the tones of a configuration can be analyzed at sample_rate
+ */
+int8_t qrtone_config_check_sample_rate(const qrtone_config_t* config, float sample_rate) {
+    float frequencies[QRTONE_NUM_FREQUENCIES];
+    float close_frequencies[QRTONE_NUM_FREQUENCIES];
+    qrtone_compute_frequencies(config, frequencies, 0);
+    qrtone_compute_frequencies(config, close_frequencies, QRTONE_WINDOW_WIDTH);
+    // Highest tone and the spectral leakage of the highest window must stay below the Nyquist frequency
+    if (!(close_frequencies[QRTONE_NUM_FREQUENCIES - 1] < sample_rate / 2)) {
+        return FALSE;
+    }
+    const int32_t word_length = (int32_t)(sample_rate * config->word_time);
+    const int32_t gate_length = (int32_t)(sample_rate * config->gate_time);
+    if (word_length < QRTONE_MIN_WORD_LENGTH) {
+        return FALSE;
     }
+    // Gate tones are analyzed with the window of the first gate frequency, with 50% overlap
+    int32_t gate_window = min(word_length, qrtone_compute_minimum_window_size(sample_rate, frequencies[FREQUENCY_ROOT], close_frequencies[FREQUENCY_ROOT]));
+    return gate_length >= 2 * gate_window;
 }
 
-void qrtone_arraycopy_to8bits(int32_t* src, int32_t src_pos, int8_t* dest, int32_t dest_pos, int32_t length) {
-    int32_t i;
-    for (i = 0; i < length; i++) {
-        dest[i + dest_pos] = (int8_t)(src[i + src_pos] & 0xFF);
+/**
+ * @return The decimation factor of the receiver, the largest one leaving a transition band of QRTONE_DECIMATION_TRANSITION
+ * above the tones if config->decimation is 0
+ */
+int32_t qrtone_config_decimation(const qrtone_config_t* config) {
+    if (config->decimation != 0) {
+        return config->decimation;
+    }
+    float close_frequencies[QRTONE_NUM_FREQUENCIES];
+    qrtone_compute_frequencies(config, close_frequencies, QRTONE_WINDOW_WIDTH);
+    int32_t decimation;
+    for (decimation = QRTONE_MAX_DECIMATION; decimation > 1; decimation--) {
+        const float sample_rate = config->sample_rate / decimation;
+        if (sample_rate - 2 * close_frequencies[QRTONE_NUM_FREQUENCIES - 1] >= QRTONE_DECIMATION_TRANSITION * sample_rate
+            && qrtone_config_check_sample_rate(config, sample_rate)) {
+            return decimation;
+        }
     }
+    return 1;
 }
 
-void qrtone_arraycopy_to32bits(int8_t* src, int32_t src_pos, int32_t* dest, int32_t dest_pos, int32_t length) {
-    int32_t i;
-    for (i = 0; i < length; i++) {
-        dest[i + dest_pos] = src[i + src_pos];
+int8_t qrtone_config_check(const qrtone_config_t* config) {
+    if (!(config->sample_rate > 0) || !(config->first_frequency > 0) || !(config->trigger_snr > 0) || !(config->erasure_margin >= 0) || config->soft_decision_budget < 0
+        || config->parsers < 1 || config->parsers > QRTONE_MAX_PARSERS || config->decimation < 0 || config->decimation > QRTONE_MAX_DECIMATION) {
+        return FALSE;
+    }
+    if (config->frequency_increment != 0 ? !(config->frequency_increment > 0) : !(config->frequency_multiplier > 1.0f)) {
+        return FALSE;
+    }
+    if (config->trigger_hop_ratio != 0 && !(config->trigger_hop_ratio >= QRTONE_MIN_TRIGGER_HOP_RATIO && config->trigger_hop_ratio <= QRTONE_MAX_TRIGGER_HOP_RATIO)) {
+        return FALSE;
+    }
+    if (!(config->trigger_idle_level <= 0)) {
+        return FALSE;
     }
+    if (!(config->word_silence_time >= 0) || !qrtone_config_check_sample_rate(config, config->sample_rate)) {
+        return FALSE;
+    }
+    // The receiver analyzes the tones at the decimated sample rate
+    const int32_t decimation = qrtone_config_decimation(config);
+    return decimation == 1 || qrtone_config_check_sample_rate(config, config->sample_rate / decimation);
 }
 
-void qrtone_payload_to_symbols(qrtone_t* self, int8_t* payload, uint8_t payload_length, int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t has_crc, int8_t* symbols){
-    qrtone_header_t header;
-    qrtone_header_init(&header, payload_length, block_symbols_size, block_ecc_symbols, has_crc, 0);
-    int8_t* payload_bytes;
-    if (has_crc) {
-        payload_bytes = malloc((size_t)payload_length + CRC_BYTE_LENGTH);
-        memcpy(payload_bytes, payload, payload_length);
-        qrtone_crc16_t crc;
-        qrtone_crc16_init(&crc);
-        qrtone_crc16_add_array(&crc, payload_bytes, payload_length);
-        payload_bytes[payload_length] = (int8_t)(crc.crc16 >> 8);
-        payload_bytes[payload_length + 1] = (int8_t)(crc.crc16 & 0xFF);
-        payload_length += CRC_BYTE_LENGTH;
-    } else {
-        payload_bytes = payload;
+/**
+ * Blackman windowed sinc cut at the decimated Nyquist frequency. The tones are in the pass band, the transition band ends
+ * where the aliases would reach the highest tone. With a decimation of 2 the filter is a half band filter.
+ * @param high_frequency Highest frequency of the band of the tones
+ * @return 0 if the allocation failed
+ */
+int8_t qrtone_decimator_init(qrtone_profile_t* self, float high_frequency, const qrtone_allocator_t* allocator) {
+    const int32_t decimation = self->decimation;
+    const float transition = self->sample_rate / decimation - 2 * high_frequency;
+    const int32_t taps_length = ((int32_t)ceilf(QRTONE_DECIMATION_BLACKMAN_WIDTH * self->sample_rate / transition)) | 1;
+    const int32_t center = (taps_length - 1) / 2;
+    self->decimator_taps = qrtone_allocator_malloc(allocator, sizeof(float) * center);
+    self->decimator_taps_index = qrtone_allocator_malloc(allocator, sizeof(int32_t) * center);
+    if (self->decimator_taps == NULL || self->decimator_taps_index == NULL) {
+        return FALSE;
     }
-    int32_t block_id, i;
-    int32_t* block_symbols = malloc(sizeof(int32_t) * block_symbols_size);
-    for (block_id = 0; block_id < header.number_of_blocks; block_id++) {
-        memset(block_symbols, 0, sizeof(int32_t) * block_symbols_size);
-        int32_t payload_size = min(header.payload_byte_size, payload_length - block_id * header.payload_byte_size);
-        for (i = 0; i < payload_size; i++) {
-            // offset most significant bits to the right without keeping sign
-            block_symbols[i * 2] = (payload_bytes[i + block_id * header.payload_byte_size] >> 4) & 0x0F;
-            // keep only least significant bits for the second hexadecimal symbol
-            block_symbols[i * 2 + 1] = payload_bytes[i + block_id * header.payload_byte_size] & 0x0F;
+    self->decimator_taps_length = taps_length;
+    self->decimator_folded_length = 0;
+    double sum = 1.0 / decimation;
+    int32_t k;
+    for (k = 0; k < center; k++) {
+        const int32_t x = center - k;
+        // the sinc is zero on the multiples of the decimation, these taps are skipped
+        if (x % decimation == 0) {
+            continue;
         }
-        // Add ECC parity symbols
-        ecc_reed_solomon_encoder_encode(&(self->encoder), block_symbols, block_symbols_size, block_ecc_symbols);
-        // Copy data to main symbols
-        qrtone_arraycopy_to8bits(block_symbols, 0, symbols, block_id * block_symbols_size, payload_size * 2);
-        // Copy parity to main symbols
-        qrtone_arraycopy_to8bits(block_symbols, header.payload_symbols_size, symbols, block_id * block_symbols_size + payload_size * 2, block_ecc_symbols);
+        const double blackman = 0.42 - 0.5 * cos(2.0 * M_PI * k / (taps_length - 1)) + 0.08 * cos(4.0 * M_PI * k / (taps_length - 1));
+        const double tap = sin(M_PI * x / decimation) / (M_PI * x) * blackman;
+        self->decimator_taps[self->decimator_folded_length] = (float)tap;
+        self->decimator_taps_index[self->decimator_folded_length] = k;
+        self->decimator_folded_length++;
+        sum += 2 * tap;
     }
-    // Permute symbols
-    qrtone_interleave_symbols(symbols, header.number_of_symbols, block_symbols_size);
-    free(block_symbols);
-    if (payload_bytes != payload) {
-        free(payload_bytes);
+    // unit gain of the pass band
+    for (k = 0; k < self->decimator_folded_length; k++) {
+        self->decimator_taps[k] = (float)(self->decimator_taps[k] / sum);
     }
-}
-
-int32_t qrtone_set_payload_ext(qrtone_t* self, int8_t* payload, uint8_t payload_length, int8_t ecc_level, int8_t add_crc) {
-    if (ecc_level < 0 || ecc_level > QRTONE_ECC_H) {
-        return 0;
+    self->decimator_center_tap = (float)(1.0 / decimation / sum);
+    // an analyzed sample is computed after each group of decimation input samples, at the middle of the filter
+    self->decimator_offset = decimation - 1 - center;
+#ifdef QRTONE_FIXED_POINT
+    self->decimator_taps_fixed = qrtone_allocator_malloc(allocator, sizeof(int16_t) * center);
+    if (self->decimator_taps_fixed == NULL) {
+        return FALSE;
     }
-    qrtone_header_t header;
-    qrtone_header_init(&header, payload_length, ECC_SYMBOLS[ecc_level][0], ECC_SYMBOLS[ecc_level][1], add_crc, ecc_level);
-    if (self->symbols_to_deliver != NULL) {
-        free(self->symbols_to_deliver);
-        self->symbols_to_deliver = NULL;
-        self->symbols_to_deliver_length = 0;
+    // int16 samples are accumulated in an int32, the sum of the absolute taps bounds the accumulator
+    double taps_sum = fabs(self->decimator_center_tap);
+    for (k = 0; k < self->decimator_folded_length; k++) {
+        taps_sum += 2 * fabs(self->decimator_taps[k]);
     }
-    self->symbols_to_deliver_length = header.number_of_symbols + HEADER_SYMBOLS;
-    self->symbols_to_deliver = malloc(self->symbols_to_deliver_length);
-    int8_t header_data[HEADER_SIZE];
-    qrtone_header_encode(&header, header_data);
-    // Encode header symbols
-    qrtone_payload_to_symbols(self, header_data, HEADER_SIZE, HEADER_SYMBOLS, HEADER_ECC_SYMBOLS, 0, self->symbols_to_deliver);
-    // Encode payload symbols
-    qrtone_payload_to_symbols(self, payload, payload_length, ECC_SYMBOLS[ecc_level][0], ECC_SYMBOLS[ecc_level][1], add_crc, self->symbols_to_deliver + HEADER_SYMBOLS);
-    self->output_samples = 0;
-    // return number of samples
-    return 2 * self->gate_length + (self->symbols_to_deliver_length / 2) * (self->word_silence_length + self->word_length);
+    self->decimator_fixed_shift = 15;
+    while (self->decimator_fixed_shift > 1 && taps_sum * 32768.0 * (1 << self->decimator_fixed_shift) >= 2147483647.0) {
+        self->decimator_fixed_shift--;
+    }
+    const double scale = (double)(1 << self->decimator_fixed_shift);
+    for (k = 0; k < self->decimator_folded_length; k++) {
+        self->decimator_taps_fixed[k] = (int16_t)floor(self->decimator_taps[k] * scale + 0.5);
+    }
+    self->decimator_center_tap_fixed = (int32_t)floor(self->decimator_center_tap * scale + 0.5);
+#endif
+    return TRUE;
 }
 
-int32_t qrtone_set_payload(qrtone_t* self, int8_t* payload, uint8_t payload_length) {
-    return qrtone_set_payload_ext(self, payload, payload_length, QRTONE_DEFAULT_ECC_LEVEL, 1);
-}
+/**
+ * Compute the constant parameters of a configuration
+ * @param allocator Allocator of the profile buffers, must remain valid until qrtone_profile_free. NULL to use malloc
+ * @return 1 on success, 0 if the configuration is not valid or if an allocation failed. qrtone_profile_free must be called in both cases.
+ */
+int8_t qrtone_profile_init_allocator(qrtone_profile_t* self, const qrtone_config_t* config, const qrtone_allocator_t* allocator) {
+    self->allocator = allocator;
+    self->trigger_window_cache = NULL;
+    self->decimator_taps = NULL;
+    self->decimator_taps_index = NULL;
+#ifdef QRTONE_FIXED_POINT
+    self->decimator_taps_fixed = NULL;
+#endif
+    if (!qrtone_config_check(config)) {
+        // nothing allocated, qrtone_profile_free releases NULL pointers
+        memset(&(self->encoder), 0, sizeof(ecc_reed_solomon_encoder_t));
+        return FALSE;
+    }
+    self->config = *config;
+    const float sample_rate = config->sample_rate;
+    const ecc_allocator_t* ecc_allocator = NULL;
+    if (allocator != NULL) {
+        self->ecc_allocator.malloc_fn = allocator->malloc_fn;
+        self->ecc_allocator.free_fn = allocator->free_fn;
+        self->ecc_allocator.ptr = allocator->ptr;
+        ecc_allocator = &(self->ecc_allocator);
+    }
+    self->sample_rate = sample_rate;
+    self->word_length = (int32_t)(sample_rate * config->word_time);
+    self->gate_length = (int32_t)(sample_rate * config->gate_time);
+    self->word_silence_length = (int32_t)(sample_rate * config->word_silence_time);
+    qrtone_compute_frequencies(config, self->frequencies, 0);
+    int32_t idfreq;
+    float close_frequencies[QRTONE_NUM_FREQUENCIES];
+    int32_t window_sizes[QRTONE_NUM_FREQUENCIES];
+    qrtone_compute_frequencies(config, close_frequencies, QRTONE_WINDOW_WIDTH);
+    // Receiver filters run at the decimated sample rate, the emitter at sample_rate
+    self->decimation = qrtone_config_decimation(config);
+    self->analysis_sample_rate = sample_rate / self->decimation;
+    self->analysis_word_length = self->word_length / self->decimation;
+    self->analysis_gate_length = self->gate_length / self->decimation;
+    self->decimator_taps_length = 0;
+    self->decimator_offset = 0;
+    int8_t decimator_ok = self->decimation == 1 || qrtone_decimator_init(self, close_frequencies[QRTONE_NUM_FREQUENCIES - 1], allocator);
+    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
+        int32_t adaptative_window = qrtone_compute_minimum_window_size(self->analysis_sample_rate, self->frequencies[idfreq], close_frequencies[idfreq]);
+        window_sizes[idfreq] = min(self->analysis_word_length, adaptative_window);
+    }
+    qrtone_goertzel_bank_coefficients_init(&(self->bank_coefficients), self->analysis_sample_rate, self->frequencies, window_sizes, self->analysis_word_length);
+#ifdef QRTONE_FIXED_POINT
+    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
+        self->fixed_tone_phase_increment[idfreq] = (uint32_t)floor((double)self->frequencies[idfreq] / sample_rate * 4294967296.0 + 0.5);
+    }
+    self->fixed_gate_window_phase_increment = qrtone_fixed_window_phase_increment(self->gate_length);
+    self->fixed_tukey_window_phase_increment = qrtone_fixed_window_phase_increment(((int32_t)floorf(QRTONE_TUKEY_ALPHA * (self->word_length - 1) / 2.0f)) * 2);
+#endif
+    self->trigger_hop = config->trigger_hop_ratio > 0 ? max(1, (int32_t)(config->trigger_hop_ratio * window_sizes[FREQUENCY_ROOT])) : 0;
+    // cache hann window values, shared by all gate filters
+    self->trigger_window_cache_length = window_sizes[FREQUENCY_ROOT] / 2 + 1;
+    self->trigger_window_cache = qrtone_allocator_malloc(allocator, sizeof(float) * self->trigger_window_cache_length);
+    if (self->trigger_window_cache != NULL) {
+        int32_t i;
+        for (i = 0; i < self->trigger_window_cache_length; i++) {
+            self->trigger_window_cache[i] = 1.0f;
+        }
+        qrtone_hann_window(self->trigger_window_cache, self->trigger_window_cache_length, window_sizes[FREQUENCY_ROOT], 0);
+    }
+    // GF(16) encoding is table driven, it does not modify the profile
+    ecc_reed_solomon_encoder_init_allocator(&(self->encoder), ECC_GF16_PRIMITIVE, 16, 1, ecc_allocator);
+    // Largest message, decoding buffers are allocated once
+    self->symbols_capacity = HEADER_SYMBOLS;
+    self->erasure_margin = (uint16_t)(fminf(config->erasure_margin, 255.0f) * 256.0f);
+    int8_t ecc_level;
+    for (ecc_level = QRTONE_ECC_L; ecc_level <= QRTONE_ECC_H; ecc_level++) {
+        qrtone_header_t header;
+        qrtone_header_init(&header, QRTONE_MAX_PAYLOAD_LENGTH, ECC_SYMBOLS[ecc_level][0], ECC_SYMBOLS[ecc_level][1], TRUE, ecc_level);
+        self->symbols_capacity = max(self->symbols_capacity, header.number_of_symbols);
+    }
+    int8_t encoder_ok = self->encoder.field.exp_table != NULL && self->encoder.field.log_table != NULL
+        && self->encoder.cached_generators != NULL && self->encoder.cached_generators->value != NULL;
+    return self->trigger_window_cache != NULL && encoder_ok && decimator_ok;
+}
+
+int8_t qrtone_profile_init(qrtone_profile_t* self, float sample_rate) {
+    qrtone_config_t config;
+    qrtone_config_audible(&config, sample_rate);
+    return qrtone_profile_init_allocator(self, &config, NULL);
+}
+
+int8_t qrtone_profile_init_config(qrtone_profile_t* self, const qrtone_config_t* config) {
+    return qrtone_profile_init_allocator(self, config, NULL);
+}
+
+void qrtone_profile_free(qrtone_profile_t* self) {
+    ecc_reed_solomon_encoder_free(&(self->encoder));
+    qrtone_allocator_free(self->allocator, self->trigger_window_cache);
+    qrtone_allocator_free(self->allocator, self->decimator_taps);
+    qrtone_allocator_free(self->allocator, self->decimator_taps_index);
+#ifdef QRTONE_FIXED_POINT
+    qrtone_allocator_free(self->allocator, self->decimator_taps_fixed);
+#endif
+}
+
+/**
+ * Setup the accounting allocator of the instance
+ */
+void qrtone_init_memory(qrtone_t* self, const qrtone_allocator_t* allocator) {
+    if (allocator != NULL) {
+        self->user_allocator = *allocator;
+    } else {
+        self->user_allocator.malloc_fn = qrtone_heap_malloc;
+        self->user_allocator.free_fn = qrtone_heap_free;
+        self->user_allocator.ptr = NULL;
+    }
+    self->allocator.malloc_fn = qrtone_accounting_malloc;
+    self->allocator.free_fn = qrtone_accounting_free;
+    self->allocator.ptr = self;
+    self->memory_usage = 0;
+    self->memory_peak = 0;
+    self->allocation_failed = FALSE;
+    self->owned_profile = NULL;
+    if (self->user_allocator.malloc_fn != qrtone_arena_malloc) {
+        self->arena.base = NULL;
+        self->arena.size = 0;
+        self->arena.used = 0;
+    }
+}
+
+/**
+ * Allocate the decoding buffers of a parser for the largest message
+ */
+void qrtone_parser_init(qrtone_t* self, qrtone_parser_t* parser) {
+    const qrtone_profile_t* profile = self->profile;
+    parser->state = QRTONE_WAITING_TRIGGER;
+    qrtone_goertzel_bank_init(&(parser->frequency_analyzers), &(profile->bank_coefficients));
+#ifdef QRTONE_FIXED_POINT
+    qrtone_goertzel_bank_fixed_init(&(parser->fixed_analyzers), &(profile->bank_coefficients));
+#endif
+    parser->trigger_location = -1;
+    parser->first_tone_sample_index = -1;
+    parser->analyzed_samples = 0;
+    parser->symbol_index = 0;
+    parser->symbols_cache = qrtone_allocator_malloc(&(self->allocator), profile->symbols_capacity);
+    parser->symbols_cache_length = 0;
+    parser->symbols_margin = qrtone_allocator_malloc(&(self->allocator), sizeof(uint16_t) * profile->symbols_capacity);
+    parser->symbols_runner_up = qrtone_allocator_malloc(&(self->allocator), profile->symbols_capacity);
+    parser->symbols_level = qrtone_allocator_malloc(&(self->allocator), sizeof(int16_t) * profile->symbols_capacity);
+    parser->symbols_noise = qrtone_allocator_malloc(&(self->allocator), sizeof(int16_t) * profile->symbols_capacity);
+    parser->fixed_errors = 0;
+    parser->timing_offset = 0;
+    parser->header_cache = NULL;
+}
+
+void qrtone_parser_free(qrtone_t* self, qrtone_parser_t* parser) {
+    qrtone_allocator_free(&(self->allocator), parser->symbols_cache);
+    qrtone_allocator_free(&(self->allocator), parser->symbols_margin);
+    qrtone_allocator_free(&(self->allocator), parser->symbols_runner_up);
+    qrtone_allocator_free(&(self->allocator), parser->symbols_level);
+    qrtone_allocator_free(&(self->allocator), parser->symbols_noise);
+}
+
+/**
+ * Init the per stream state, all constant parameters are read from the profile
+ */
+int8_t qrtone_init_state(qrtone_t* self, const qrtone_profile_t* profile) {
+    self->profile = profile;
+    self->symbols_to_deliver = NULL;
+    self->symbols_to_deliver_length = 0;
+    self->payload = NULL;
+    self->payload_length = 0;
+    self->pushed_samples = 0;
+    self->fixed_errors = 0;
+    self->payload_callback = NULL;
+    self->payload_callback_data = NULL;
+    self->payload_buffer = self->payload_cache;
+    self->sample_rate = profile->sample_rate;
+    self->word_length = profile->word_length;
+    self->gate_length = profile->gate_length;
+    self->word_silence_length = profile->word_silence_length;
+    float gates_freq[2];
+    gates_freq[0] = profile->frequencies[FREQUENCY_ROOT];
+    gates_freq[1] = profile->frequencies[FREQUENCY_ROOT + 2];
+    int32_t idfreq;
+    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
+        qrtone_iterative_tone_init(&(self->tone[idfreq]), profile->frequencies[idfreq], self->sample_rate);
+    }
+    self->decimation = profile->decimation;
+    self->analysis_word_length = profile->analysis_word_length;
+    self->decimator_history = NULL;
+    self->decimator_cursor = 0;
+    self->decimator_phase = 0;
+    self->decimated_samples = NULL;
+#ifdef QRTONE_FIXED_POINT
+    self->decimator_history_s16 = NULL;
+    self->decimated_samples_s16 = NULL;
+#endif
+    if (self->decimation > 1) {
+        self->decimator_history = qrtone_allocator_malloc(&(self->allocator), sizeof(float) * 2 * profile->decimator_taps_length);
+        if (self->decimator_history != NULL) {
+            memset(self->decimator_history, 0, sizeof(float) * 2 * profile->decimator_taps_length);
+        }
+        self->decimated_samples = qrtone_allocator_malloc(&(self->allocator), sizeof(float) * QRTONE_DECIMATION_BLOCK);
+#ifdef QRTONE_FIXED_POINT
+        self->decimator_history_s16 = qrtone_allocator_malloc(&(self->allocator), sizeof(int16_t) * 2 * profile->decimator_taps_length);
+        if (self->decimator_history_s16 != NULL) {
+            memset(self->decimator_history_s16, 0, sizeof(int16_t) * 2 * profile->decimator_taps_length);
+        }
+        self->decimated_samples_s16 = qrtone_allocator_malloc(&(self->allocator), sizeof(int16_t) * QRTONE_DECIMATION_BLOCK);
+#endif
+    }
+    qrtone_trigger_analyzer_init(&(self->trigger_analyzer), profile->analysis_sample_rate, profile->analysis_gate_length, profile->bank_coefficients.window_size[FREQUENCY_ROOT], profile->trigger_hop, gates_freq, profile->config.trigger_snr, profile->config.trigger_idle_level, profile->trigger_window_cache, &(self->allocator));
+    self->trigger_analyzer.decimation = profile->decimation;
+    self->trigger_analyzer.decimation_offset = profile->decimator_offset;
+    // Allocate decoding buffers for the largest message, push_samples does not allocate memory
+    self->parsers = qrtone_allocator_malloc(&(self->allocator), sizeof(qrtone_parser_t) * profile->config.parsers);
+    self->parsers_length = self->parsers != NULL ? profile->config.parsers : 0;
+    int32_t id_parser;
+    for (id_parser = 0; id_parser < self->parsers_length; id_parser++) {
+        qrtone_parser_init(self, &(self->parsers[id_parser]));
+    }
+    self->symbols_scratch = qrtone_allocator_malloc(&(self->allocator), (size_t)profile->symbols_capacity + QRTONE_MAX_BLOCK_SYMBOLS);
+    self->quality_parser = self->parsers;
+    self->quality_symbols_length = 0;
+    self->timing_offset = 0;
+    self->parsed_samples = 0;
+    self->payload_sample_index = -1;
+    self->soft_decision_heap = qrtone_allocator_malloc(&(self->allocator), sizeof(qrtone_soft_decision_pattern_t) * ((size_t)profile->config.soft_decision_budget + 1));
+    qrtone_iterative_hann_init(&(self->hann), self->gate_length);
+    qrtone_iterative_tukey_init(&(self->tukey), QRTONE_TUKEY_ALPHA, self->word_length);
+    self->output_samples = 0;
+    return !self->allocation_failed;
+}
+
+int8_t qrtone_init_config(qrtone_t* self, const qrtone_config_t* config, const qrtone_allocator_t* allocator) {
+    qrtone_init_memory(self, allocator);
+    self->owned_profile = qrtone_allocator_malloc(&(self->allocator), sizeof(qrtone_profile_t));
+    if (self->owned_profile == NULL) {
+        self->profile = NULL;
+        return FALSE;
+    }
+    if (!qrtone_profile_init_allocator(self->owned_profile, config, &(self->allocator))) {
+        // keep the instance in a state that qrtone_free accepts
+        qrtone_profile_free(self->owned_profile);
+        qrtone_allocator_free(&(self->allocator), self->owned_profile);
+        self->owned_profile = NULL;
+        self->profile = NULL;
+        return FALSE;
+    }
+    return qrtone_init_state(self, self->owned_profile);
+}
+
+int8_t qrtone_init_allocator(qrtone_t* self, float sample_rate, const qrtone_allocator_t* allocator) {
+    qrtone_config_t config;
+    qrtone_config_audible(&config, sample_rate);
+    return qrtone_init_config(self, &config, allocator);
+}
+
+int8_t qrtone_init_profile(qrtone_t* self, const qrtone_profile_t* profile, const qrtone_allocator_t* allocator) {
+    qrtone_init_memory(self, allocator);
+    return qrtone_init_state(self, profile);
+}
+
+void qrtone_init(qrtone_t* self, float sample_rate) {
+    qrtone_init_allocator(self, sample_rate, NULL);
+}
+
+/**
+ * Sum the arena space of all allocations, arena memory is not reused after free
+ */
+void* qrtone_measure_malloc(void* ptr, size_t size) {
+    *((size_t*)ptr) += QRTONE_ALIGN(size);
+    return malloc(size);
+}
+
+size_t qrtone_required_memory(float sample_rate) {
+    // Measure allocations done by the initialization
+    size_t required = QRTONE_ALIGN(sizeof(qrtone_t));
+    qrtone_allocator_t allocator = { qrtone_measure_malloc, qrtone_heap_free, &required };
+    qrtone_t* qrtone = qrtone_new();
+    qrtone_init_allocator(qrtone, sample_rate, &allocator);
+    qrtone_free(qrtone);
+    free(qrtone);
+    return required;
+}
+
+size_t qrtone_required_memory_profile(const qrtone_profile_t* profile) {
+    size_t required = QRTONE_ALIGN(sizeof(qrtone_t));
+    qrtone_allocator_t allocator = { qrtone_measure_malloc, qrtone_heap_free, &required };
+    qrtone_t* qrtone = qrtone_new();
+    qrtone_init_profile(qrtone, profile, &allocator);
+    qrtone_free(qrtone);
+    free(qrtone);
+    return required;
+}
+
+/**
+ * Place the qrtone_t structure at the beginning of the arena and return an allocator of the remaining space
+ */
+qrtone_t* qrtone_arena_init(void* arena, size_t arena_size, qrtone_allocator_t* allocator) {
+    if (arena == NULL || arena_size < QRTONE_ALIGN(sizeof(qrtone_t))) {
+        return NULL;
+    }
+    qrtone_t* self = (qrtone_t*)arena;
+    self->arena.base = (uint8_t*)arena;
+    self->arena.size = arena_size;
+    self->arena.used = QRTONE_ALIGN(sizeof(qrtone_t));
+    allocator->malloc_fn = qrtone_arena_malloc;
+    allocator->free_fn = qrtone_arena_free;
+    allocator->ptr = &(self->arena);
+    return self;
+}
+
+qrtone_t* qrtone_init_arena(void* arena, size_t arena_size, float sample_rate) {
+    qrtone_allocator_t allocator;
+    qrtone_t* self = qrtone_arena_init(arena, arena_size, &allocator);
+    if (self == NULL || !qrtone_init_allocator(self, sample_rate, &allocator)) {
+        return NULL;
+    }
+    return self;
+}
+
+qrtone_t* qrtone_init_arena_profile(void* arena, size_t arena_size, const qrtone_profile_t* profile) {
+    qrtone_allocator_t allocator;
+    qrtone_t* self = qrtone_arena_init(arena, arena_size, &allocator);
+    if (self == NULL || !qrtone_init_profile(self, profile, &allocator)) {
+        return NULL;
+    }
+    return self;
+}
+
+size_t qrtone_get_memory_usage(qrtone_t* self) {
+    return self->memory_usage;
+}
+
+size_t qrtone_get_memory_peak(qrtone_t* self) {
+    return self->memory_peak;
+}
+
+void qrtone_set_level_callback(qrtone_t* self, void* data, qrtone_level_callback_t lvl_callback) {    
+    self->trigger_analyzer.level_callback = lvl_callback;
+    self->trigger_analyzer.level_callback_data = data;
+}
+
+void qrtone_set_payload_callback(qrtone_t* self, void* data, qrtone_payload_callback_t payload_callback) {
+    self->payload_callback = payload_callback;
+    self->payload_callback_data = data;
+}
+
+void qrtone_set_payload_buffer(qrtone_t* self, int8_t* payload_buffer) {
+    self->payload_buffer = payload_buffer != NULL ? payload_buffer : self->payload_cache;
+}
+
+
+/**
+ * Words are located from the emitted word lengths, the rounding of the decimation does not accumulate
+ */
+int64_t qrtone_get_tone_location(qrtone_t* self, qrtone_parser_t* parser) {
+    return parser->first_tone_sample_index + ((int64_t)parser->symbol_index * ((int64_t)self->word_length + self->word_silence_length) + self->word_silence_length) / self->decimation;
+}
+
+
+int32_t qrtone_get_maximum_length(qrtone_t* self) {
+    int32_t maximum_length = -1;
+    int32_t id_parser;
+    for (id_parser = 0; id_parser < self->parsers_length; id_parser++) {
+        qrtone_parser_t* parser = &(self->parsers[id_parser]);
+        if (parser->state == QRTONE_PARSING_SYMBOLS) {
+            int32_t length = self->analysis_word_length + (int32_t)(self->pushed_samples - qrtone_get_tone_location(self, parser));
+            maximum_length = maximum_length == -1 ? length : min(maximum_length, length);
+        }
+    }
+    if (maximum_length == -1) {
+        maximum_length = qrtone_trigger_maximum_window_length(&(self->trigger_analyzer));
+    }
+    // input samples up to the last analyzed sample of the window
+    return maximum_length * self->decimation - self->decimator_phase;
+}
+
+void qrtone_arraycopy_to8bits(int32_t* src, int32_t src_pos, int8_t* dest, int32_t dest_pos, int32_t length) {
+    int32_t i;
+    for (i = 0; i < length; i++) {
+        dest[i + dest_pos] = (int8_t)(src[i + src_pos] & 0xFF);
+    }
+}
+
+void qrtone_arraycopy_to32bits(int8_t* src, int32_t src_pos, int32_t* dest, int32_t dest_pos, int32_t length) {
+    int32_t i;
+    for (i = 0; i < length; i++) {
+        dest[i + dest_pos] = src[i + src_pos];
+    }
+}
+
+/**
+ * @return 0 if the interleaving scratch buffer could not be allocated
+ */
+int8_t qrtone_payload_to_symbols(qrtone_t* self, int8_t* payload, uint8_t payload_length, int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t has_crc, int8_t* symbols){
+    qrtone_header_t header;
+    qrtone_header_init(&header, payload_length, block_symbols_size, block_ecc_symbols, has_crc, 0);
+    // Permutation scratch, it is too large for the stack of small targets
+    int8_t* symbols_scratch = qrtone_allocator_malloc(&(self->allocator), header.number_of_symbols);
+    if (symbols_scratch == NULL) {
+        return 0;
+    }
+    int8_t crc_payload[QRTONE_MAX_PAYLOAD_LENGTH + CRC_BYTE_LENGTH];
+    int8_t* payload_bytes;
+    if (has_crc) {
+        payload_bytes = crc_payload;
+        memcpy(payload_bytes, payload, payload_length);
+        qrtone_crc16_t crc;
+        qrtone_crc16_init(&crc);
+        qrtone_crc16_add_array(&crc, payload_bytes, payload_length);
+        payload_bytes[payload_length] = (int8_t)(crc.crc16 >> 8);
+        payload_bytes[payload_length + 1] = (int8_t)(crc.crc16 & 0xFF);
+        payload_length += CRC_BYTE_LENGTH;
+    } else {
+        payload_bytes = payload;
+    }
+    int32_t block_id, i;
+    int32_t block_symbols[QRTONE_MAX_BLOCK_SYMBOLS];
+    for (block_id = 0; block_id < header.number_of_blocks; block_id++) {
+        memset(block_symbols, 0, sizeof(int32_t) * block_symbols_size);
+        int32_t payload_size = min(header.payload_byte_size, payload_length - block_id * header.payload_byte_size);
+        for (i = 0; i < payload_size; i++) {
+            // offset most significant bits to the right without keeping sign
+            block_symbols[i * 2] = (payload_bytes[i + block_id * header.payload_byte_size] >> 4) & 0x0F;
+            // keep only least significant bits for the second hexadecimal symbol
+            block_symbols[i * 2 + 1] = payload_bytes[i + block_id * header.payload_byte_size] & 0x0F;
+        }
+        // Add ECC parity symbols
+        // The GF(16) encoder does not use the cached generators of the shared profile
+        ecc_reed_solomon_gf16_encode(self->profile->encoder.field.generator_base, block_symbols, block_symbols_size, block_ecc_symbols);
+        // Copy data to main symbols
+        qrtone_arraycopy_to8bits(block_symbols, 0, symbols, block_id * block_symbols_size, payload_size * 2);
+        // Copy parity to main symbols
+        qrtone_arraycopy_to8bits(block_symbols, header.payload_symbols_size, symbols, block_id * block_symbols_size + payload_size * 2, block_ecc_symbols);
+    }
+    // Permute symbols
+    qrtone_interleave_symbols_buffer(symbols, header.number_of_symbols, block_symbols_size, symbols_scratch);
+    qrtone_allocator_free(&(self->allocator), symbols_scratch);
+    return 1;
+}
+
+int32_t qrtone_get_message_length(qrtone_t* self, uint8_t payload_length, int8_t ecc_level, int8_t add_crc) {
+    if (ecc_level < 0 || ecc_level > QRTONE_ECC_H) {
+        return 0;
+    }
+    qrtone_header_t header;
+    qrtone_header_init(&header, payload_length, ECC_SYMBOLS[ecc_level][0], ECC_SYMBOLS[ecc_level][1], add_crc, ecc_level);
+    return 2 * self->gate_length + ((header.number_of_symbols + HEADER_SYMBOLS) / 2) * (self->word_silence_length + self->word_length);
+}
+
+int32_t qrtone_get_gate_length(qrtone_t* self) {
+    return self->gate_length;
+}
+
+int32_t qrtone_set_payload_ext(qrtone_t* self, int8_t* payload, uint8_t payload_length, int8_t ecc_level, int8_t add_crc) {
+    if (ecc_level < 0 || ecc_level > QRTONE_ECC_H) {
+        return 0;
+    }
+    qrtone_header_t header;
+    qrtone_header_init(&header, payload_length, ECC_SYMBOLS[ecc_level][0], ECC_SYMBOLS[ecc_level][1], add_crc, ecc_level);
+    if (self->arena.base != NULL) {
+        // arena is sized for receiving only
+        return 0;
+    }
+    if (self->symbols_to_deliver != NULL) {
+        qrtone_allocator_free(&(self->allocator), self->symbols_to_deliver);
+        self->symbols_to_deliver = NULL;
+        self->symbols_to_deliver_length = 0;
+    }
+    self->symbols_to_deliver = qrtone_allocator_malloc(&(self->allocator), (size_t)header.number_of_symbols + HEADER_SYMBOLS);
+    if (self->symbols_to_deliver == NULL) {
+        return 0;
+    }
+    self->symbols_to_deliver_length = header.number_of_symbols + HEADER_SYMBOLS;
+    int8_t header_data[HEADER_SIZE];
+    qrtone_header_encode(&header, header_data);
+    // Encode header and payload symbols
+    if (!qrtone_payload_to_symbols(self, header_data, HEADER_SIZE, HEADER_SYMBOLS, HEADER_ECC_SYMBOLS, 0, self->symbols_to_deliver)
+        || !qrtone_payload_to_symbols(self, payload, payload_length, ECC_SYMBOLS[ecc_level][0], ECC_SYMBOLS[ecc_level][1], add_crc, self->symbols_to_deliver + HEADER_SYMBOLS)) {
+        qrtone_allocator_free(&(self->allocator), self->symbols_to_deliver);
+        self->symbols_to_deliver = NULL;
+        self->symbols_to_deliver_length = 0;
+        return 0;
+    }
+    self->output_samples = 0;
+    // return number of samples
+    return qrtone_get_message_length(self, payload_length, ecc_level, add_crc);
+}
+
+int32_t qrtone_set_payload(qrtone_t* self, int8_t* payload, uint8_t payload_length) {
+    return qrtone_set_payload_ext(self, payload, payload_length, QRTONE_DEFAULT_ECC_LEVEL, 1);
+}
 
 void qrtone_generate_pitch(float* samples, int32_t samples_length, int32_t offset, float sample_rate, float frequency, float power_peak) {
     const float t_step = 1.0f / sample_rate;
@@ -1427,104 +3085,243 @@ void qrtone_get_samples(qrtone_t* self, float* samples, int32_t samples_length,
     }
 }
 
+#ifdef QRTONE_FIXED_POINT
+/**
+ * Integer version of qrtone_iterative_tukey_next
+ * @param index Location in the word
+ * @return tukey window value in Q15
+ */
+int32_t qrtone_fixed_tukey(qrtone_t* self, int32_t index) {
+    int32_t hann_index;
+    if (index < self->tukey.index_begin_flat) {
+        hann_index = index;
+    } else if (index >= self->tukey.index_end_flat) {
+        // the end taper continue the hann window of the begin taper
+        hann_index = self->tukey.index_begin_flat + index - self->tukey.index_end_flat;
+    } else {
+        return 32768;
+    }
+    return (32768 - qrtone_fixed_cos((uint32_t)hann_index * self->profile->fixed_tukey_window_phase_increment)) >> 1;
+}
+
+void qrtone_get_samples_s16(qrtone_t* self, int16_t* samples, int32_t samples_length, int16_t power) {
+    const qrtone_profile_t* profile = self->profile;
+    int32_t write_offset = 0;
+    int32_t i;
+    while (write_offset < samples_length) {
+        int32_t step_end;
+        if (self->output_samples < self->gate_length * 2) {
+            // On header
+            int32_t done = self->output_samples % self->gate_length;
+            int32_t frequency_index = self->output_samples < self->gate_length ? FREQUENCY_ROOT : FREQUENCY_ROOT + 2;
+            const uint32_t tone_increment = profile->fixed_tone_phase_increment[frequency_index];
+            const uint32_t window_increment = profile->fixed_gate_window_phase_increment;
+            uint32_t tone_phase = (uint32_t)done * tone_increment;
+            uint32_t window_phase = (uint32_t)done * window_increment;
+            step_end = min(self->gate_length - done, samples_length - write_offset);
+            for (i = 0; i < step_end; i++) {
+                const int32_t hann = (32768 - qrtone_fixed_cos(window_phase)) >> 1;
+                const int32_t tone = (qrtone_fixed_sin(tone_phase) * hann) >> 15;
+                samples[write_offset + i] = qrtone_fixed_saturate(samples[write_offset + i] + ((tone * power) >> 15));
+                tone_phase += tone_increment;
+                window_phase += window_increment;
+            }
+        } else {
+            // On word
+            int32_t word_index = ((self->output_samples - self->gate_length * 2) / (self->word_length + self->word_silence_length)) * 2;
+            int32_t word_done = (self->output_samples - self->gate_length * 2) % (self->word_length + self->word_silence_length);
+            if (word_done < self->word_silence_length) {
+                // silence stage
+                step_end = min(self->word_silence_length - word_done, samples_length - write_offset);
+            } else if (word_index < self->symbols_to_deliver_length) {
+                // tone stage
+                word_done -= self->word_silence_length;
+                const uint32_t first_increment = profile->fixed_tone_phase_increment[self->symbols_to_deliver[word_index]];
+                const uint32_t second_increment = profile->fixed_tone_phase_increment[self->symbols_to_deliver[word_index + 1] + FREQUENCY_ROOT];
+                uint32_t first_phase = (uint32_t)word_done * first_increment;
+                uint32_t second_phase = (uint32_t)word_done * second_increment;
+                step_end = min(self->word_length - word_done, samples_length - write_offset);
+                for (i = 0; i < step_end; i++) {
+                    // |sum * window| <= 2^31, the shift apply the half power of each tone
+                    const int32_t tone = ((qrtone_fixed_sin(first_phase) + qrtone_fixed_sin(second_phase)) * qrtone_fixed_tukey(self, word_done + i)) >> 16;
+                    samples[write_offset + i] = qrtone_fixed_saturate(samples[write_offset + i] + ((tone * power) >> 15));
+                    first_phase += first_increment;
+                    second_phase += second_increment;
+                }
+            } else {
+                // no more data to write
+                step_end = samples_length - write_offset;
+            }
+        }
+        write_offset += step_end;
+        self->output_samples += step_end;
+    }
+}
+#endif
+
 qrtone_t* qrtone_new(void) {
     qrtone_t* self = malloc(sizeof(qrtone_t));
     return self;
 }
 
 void qrtone_free(qrtone_t* self) {
-    if (self->payload != NULL) {
-        free(self->payload);
+    if (self->profile == NULL) {
+        return;
     }
-    if (self->symbols_to_deliver != NULL) {
-        free(self->symbols_to_deliver);
-    }
-    if (self->symbols_cache != NULL) {
-        free(self->symbols_cache);
+    qrtone_allocator_free(&(self->allocator), self->symbols_to_deliver);
+    int32_t id_parser;
+    for (id_parser = 0; id_parser < self->parsers_length; id_parser++) {
+        qrtone_parser_free(self, &(self->parsers[id_parser]));
     }
-    if(self->header_cache != NULL) {
-        free(self->header_cache);
-    }
-    int32_t idfreq;
-    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
-        qrtone_goertzel_free(self->frequency_analyzers + idfreq);
+    qrtone_allocator_free(&(self->allocator), self->parsers);
+    qrtone_allocator_free(&(self->allocator), self->symbols_scratch);
+    qrtone_allocator_free(&(self->allocator), self->soft_decision_heap);
+    qrtone_allocator_free(&(self->allocator), self->decimator_history);
+    qrtone_allocator_free(&(self->allocator), self->decimated_samples);
+#ifdef QRTONE_FIXED_POINT
+    qrtone_allocator_free(&(self->allocator), self->decimator_history_s16);
+    qrtone_allocator_free(&(self->allocator), self->decimated_samples_s16);
+#endif
+    qrtone_trigger_analyzer_free(&(self->trigger_analyzer), &(self->allocator));
+    if (self->owned_profile != NULL) {
+        qrtone_profile_free(self->owned_profile);
+        qrtone_allocator_free(&(self->allocator), self->owned_profile);
     }
-    ecc_reed_solomon_encoder_free(&(self->encoder));
-    qrtone_trigger_analyzer_free(&(self->trigger_analyzer));
 }
 
-void qrtone_reset(qrtone_t* self) {
-    if (self->symbols_cache != NULL) {
-        free(self->symbols_cache);
-        self->symbols_cache = NULL;
-        self->symbols_cache_length = 0;
-    }
-    if (self->header_cache != NULL) {
-        free(self->header_cache);
-        self->header_cache = NULL;
-    }
-    if (self->symbols_to_deliver != NULL) {
-        free(self->symbols_to_deliver);
-        self->symbols_to_deliver = NULL;
-        self->symbols_to_deliver_length = 0;
+/**
+ * Free the parser for the next trigger
+ */
+void qrtone_parser_reset(qrtone_parser_t* parser) {
+    parser->symbols_cache_length = 0;
+    parser->header_cache = NULL;
+    parser->state = QRTONE_WAITING_TRIGGER;
+    parser->symbol_index = 0;
+}
+
+/**
+ * Decode a block with its least confident symbols as erasures
+ * @param blocks Deinterleaved blocks, the column block_id is fixed in place on success
+ * @return TRUE if the block has been fixed
+ */
+int8_t qrtone_decode_block_erasures(qrtone_t* self, uint8_t* blocks, int32_t number_of_blocks, int32_t block_id, int32_t block_symbols_size, int32_t block_ecc_symbols,
+    int32_t last_block_length, const uint16_t* symbols_margin) {
+    int32_t last_block_parity = last_block_length - block_ecc_symbols;
+    int32_t last_block_gap = block_symbols_size - last_block_length;
+    int32_t erasures[QRTONE_MAX_BLOCK_SYMBOLS];
+    uint16_t erasures_margin[QRTONE_MAX_BLOCK_SYMBOLS];
+    int32_t erasures_length = 0;
+    int32_t row;
+    for(row = 0; row < block_symbols_size; row++) {
+        // row of the symbol in the transmitted order, zero symbols of the last block are known
+        int32_t j = row;
+        if(block_id == number_of_blocks - 1 && row >= last_block_parity) {
+            if(row < last_block_parity + last_block_gap) {
+                continue;
+            }
+            j = row - last_block_gap;
+        }
+        uint16_t margin = symbols_margin[j * (number_of_blocks - 1) + min(j, last_block_length) + block_id];
+        if(margin >= self->profile->erasure_margin) {
+            continue;
+        }
+        // insertion sort, keep the block_ecc_symbols lowest margins
+        if(erasures_length == block_ecc_symbols) {
+            if(margin >= erasures_margin[erasures_length - 1]) {
+                continue;
+            }
+            erasures_length--;
+        }
+        int32_t i;
+        for(i = erasures_length; i > 0 && erasures_margin[i - 1] > margin; i--) {
+            erasures_margin[i] = erasures_margin[i - 1];
+            erasures[i] = erasures[i - 1];
+        }
+        erasures_margin[i] = margin;
+        erasures[i] = row;
+        erasures_length++;
     }
-    qrtone_trigger_analyzer_reset(&(self->trigger_analyzer));
-    int32_t idfreq;
-    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
-        qrtone_goertzel_reset(&(self->frequency_analyzers[idfreq]));
+    int32_t block[QRTONE_MAX_BLOCK_SYMBOLS];
+    for(row = 0; row < block_symbols_size; row++) {
+        block[row] = blocks[row * number_of_blocks + block_id];
+    }
+    if(ecc_reed_solomon_gf16_decode_erasures(self->profile->encoder.field.generator_base, block, block_symbols_size, block_ecc_symbols, erasures_length > 0 ? erasures : NULL, erasures_length, &(self->fixed_errors)) != ECC_NO_ERRORS) {
+        return FALSE;
+    }
+    for(row = 0; row < block_symbols_size; row++) {
+        blocks[row * number_of_blocks + block_id] = (uint8_t)block[row];
     }
-    self->qr_tone_state = QRTONE_WAITING_TRIGGER;
-    self->symbol_index = 0;
+    return TRUE;
 }
 
-int8_t* qrtone_symbols_to_payload(qrtone_t* self, int8_t* symbols, int32_t symbols_length, int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t has_crc) {
+/**
+ * Decode symbols into a payload without allocating memory
+ * @param symbols_margin NULL or confidence of each symbol in 1/256 dB, the symbols below profile->erasure_margin are decoded as erasures
+ * @param symbols_scratch Buffer of symbols_length + block_symbols_size bytes receiving the blocks without the permutation of symbols
+ * @param payload Buffer receiving the decoded payload (without crc)
+ * @return TRUE if the payload has been decoded
+ */
+int8_t qrtone_symbols_to_payload_buffer(qrtone_t* self, int8_t* symbols, const uint16_t* symbols_margin, int32_t symbols_length, int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t has_crc, int8_t* symbols_scratch, int8_t* payload) {
     int32_t payload_symbols_size = block_symbols_size - block_ecc_symbols;
     int32_t payload_byte_size = payload_symbols_size / 2;
     int32_t payload_length = ((symbols_length / block_symbols_size) * payload_symbols_size + max(0, symbols_length % block_symbols_size - block_ecc_symbols)) / 2;
     int32_t number_of_blocks = (int32_t)ceil(symbols_length / (float)block_symbols_size);
-
-    // Cancel permutation of symbols
-    qrtone_deinterleave_symbols(symbols, symbols_length, block_symbols_size);
+    if(block_symbols_size > QRTONE_MAX_BLOCK_SYMBOLS) {
+        return FALSE;
+    }
+    // Cancel permutation of symbols, symbol j of block k is stored in blocks[j * number_of_blocks + k]
+    // The last block is shorter, zero symbols are inserted between its payload and its parity symbols
+    uint8_t* blocks = (uint8_t*)symbols_scratch;
+    int32_t last_block_length = symbols_length - (number_of_blocks - 1) * block_symbols_size;
+    int32_t last_block_parity = last_block_length - block_ecc_symbols;
+    int32_t last_block_gap = block_symbols_size - last_block_length;
+    memset(blocks, 0, (size_t)block_symbols_size * number_of_blocks);
+    int32_t cursor = 0;
+    int32_t block_id;
+    int32_t j;
+    for(j = 0; j < block_symbols_size; j++) {
+        for(block_id = 0; block_id < number_of_blocks - 1; block_id++) {
+            blocks[j * number_of_blocks + block_id] = (uint8_t)symbols[cursor++];
+        }
+        if(j < last_block_length) {
+            blocks[(j < last_block_parity ? j : j + last_block_gap) * number_of_blocks + number_of_blocks - 1] = (uint8_t)symbols[cursor++];
+        }
+    }
+    // Use Reed-Solomon in order to fix correctable errors of all blocks
+    if(symbols_margin == NULL) {
+        if(ecc_reed_solomon_gf16_decode_batch(self->profile->encoder.field.generator_base, blocks, number_of_blocks, block_symbols_size, block_ecc_symbols, NULL, &(self->fixed_errors)) > 0) {
+            return FALSE;
+        }
+    } else {
+        for(block_id = 0; block_id < number_of_blocks; block_id++) {
+            if(!qrtone_decode_block_erasures(self, blocks, number_of_blocks, block_id, block_symbols_size, block_ecc_symbols, last_block_length, symbols_margin)) {
+                return FALSE;
+            }
+        }
+    }
     int32_t offset = 0;
     if(has_crc) {
         offset = -CRC_BYTE_LENGTH;
     }
-    int8_t* payload = malloc((size_t)payload_length + offset);
     int32_t crc_value[CRC_BYTE_LENGTH];
     memset(crc_value, 0, sizeof(int32_t) * CRC_BYTE_LENGTH);
     int32_t crc_index = 0;
-    int32_t block_id;
-    int32_t* block_symbols = malloc(sizeof(int32_t) * block_symbols_size);
     for(block_id = 0; block_id < number_of_blocks; block_id++) {
-        memset(block_symbols, 0, sizeof(int32_t) * block_symbols_size);
-        int32_t payload_symbols_length = min(payload_symbols_size, symbols_length - block_ecc_symbols - block_id * block_symbols_size);
-        // Copy payload symbols
-        qrtone_arraycopy_to32bits(symbols, block_id * block_symbols_size, block_symbols, 0, payload_symbols_length);
-        // Copy parity symbols
-        qrtone_arraycopy_to32bits(symbols, block_id * block_symbols_size + payload_symbols_length, block_symbols, payload_symbols_size, block_ecc_symbols);
-        // Use Reed-Solomon in order to fix correctable errors
-        // Fix symbols thanks to ECC parity symbols
-        int32_t ret = ecc_reed_solomon_decoder_decode(&(self->encoder.field), block_symbols, block_symbols_size, block_ecc_symbols, &(self->fixed_errors));
-        if(ret == ECC_REED_SOLOMON_ERROR) {
-            free(payload);
-            payload = NULL;
-            break;
-        }
+        const uint8_t* block_symbols = blocks + block_id;
         // copy result to payload
         int32_t payload_block_byte_size = min(payload_byte_size, payload_length + offset - block_id * payload_byte_size);
         int32_t i;
         for(i=0; i < payload_block_byte_size; i++) {
-            payload[i + block_id * payload_byte_size] = (int8_t)((block_symbols[i * 2] << 4) | (block_symbols[i * 2 + 1] & 0x0f));
+            payload[i + block_id * payload_byte_size] = (int8_t)((block_symbols[i * 2 * number_of_blocks] << 4) | (block_symbols[(i * 2 + 1) * number_of_blocks] & 0x0f));
         }
         if(has_crc) {
             int32_t maxi = min(payload_byte_size, payload_length - block_id * payload_byte_size);
             for(i = max(0, payload_block_byte_size); i < maxi; i++) {
-                crc_value[crc_index++] = ((block_symbols[i * 2] << 4) | (block_symbols[i * 2 + 1] & 0x0F));
+                crc_value[crc_index++] = ((block_symbols[i * 2 * number_of_blocks] << 4) | (block_symbols[(i * 2 + 1) * number_of_blocks] & 0x0F));
             }
         }
     }
-    free(block_symbols);
-    if(payload != NULL && has_crc) {
+    if(has_crc) {
         int32_t stored_crc = 0;
         stored_crc = stored_crc | crc_value[0] << 8;
         stored_crc = stored_crc | crc_value[1];
@@ -1533,147 +3330,589 @@ int8_t* qrtone_symbols_to_payload(qrtone_t* self, int8_t* symbols, int32_t symbo
         qrtone_crc16_init(&crc16);
         qrtone_crc16_add_array(&crc16, payload, payload_length + offset);
         if(crc16.crc16 != stored_crc) {
-            free(payload);
-            payload = NULL;
+            return FALSE;
         }
     }
+    return TRUE;
+}
+
+int8_t* qrtone_symbols_to_payload(qrtone_t* self, int8_t* symbols, int32_t symbols_length, int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t has_crc) {
+    int32_t payload_symbols_size = block_symbols_size - block_ecc_symbols;
+    int32_t payload_length = ((symbols_length / block_symbols_size) * payload_symbols_size + max(0, symbols_length % block_symbols_size - block_ecc_symbols)) / 2;
+    if(has_crc) {
+        payload_length -= CRC_BYTE_LENGTH;
+    }
+    int8_t* symbols_scratch = malloc((size_t)symbols_length + block_symbols_size);
+    int8_t* payload = malloc(max(1, payload_length));
+    if(!qrtone_symbols_to_payload_buffer(self, symbols, NULL, symbols_length, block_symbols_size, block_ecc_symbols, has_crc, symbols_scratch, payload)) {
+        free(payload);
+        payload = NULL;
+    }
+    free(symbols_scratch);
     return payload;
 }
 
 
-void qrtone_feed_trigger_analyzer(qrtone_t* self, int64_t total_processed, float* samples, int32_t samples_length) {
-    qrtone_trigger_analyzer_process_samples(&(self->trigger_analyzer), total_processed, samples, samples_length);
-    if(self->trigger_analyzer.first_tone_location != -1) {
-        self->qr_tone_state = QRTONE_PARSING_SYMBOLS;
-        if(self->payload != NULL) {
-            free(self->payload);
+/**
+ * Free parser for a new trigger, the parser of the last message is kept while another one is free so its quality remains available
+ * @return NULL if all parsers are parsing a message
+ */
+qrtone_parser_t* qrtone_get_free_parser(qrtone_t* self) {
+    qrtone_parser_t* free_parser = NULL;
+    int32_t id_parser;
+    for (id_parser = 0; id_parser < self->parsers_length; id_parser++) {
+        qrtone_parser_t* parser = &(self->parsers[id_parser]);
+        if (parser->state == QRTONE_WAITING_TRIGGER && (free_parser == NULL || free_parser == self->quality_parser)) {
+            free_parser = parser;
         }
-        self->payload = NULL;
-        self->payload_length = 0;
-        self->first_tone_sample_index = self->trigger_analyzer.first_tone_location;
-        int32_t idfreq;
-        for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
-            qrtone_goertzel_reset(&(self->frequency_analyzers[idfreq]));
-        }
-        if(self->symbols_cache != NULL) {
-            free(self->symbols_cache);
-        }
-        self->symbols_cache = malloc(HEADER_SYMBOLS);
-        memset(self->symbols_cache, 0, HEADER_SYMBOLS);
-        self->symbols_cache_length = HEADER_SYMBOLS;
-        qrtone_trigger_analyzer_reset(&(self->trigger_analyzer));
-        self->fixed_errors = 0;
     }
+    return free_parser;
+}
+
+/**
+ * Start symbols parsing once the trigger analyzer has found the first tone.
+ * The trigger analyzer is not reset, it keeps running while parsing so a message sent right after the current one is not missed.
+ * A trigger found while a message is parsed starts another parser, if the trigger was caused by the tones of the message its
+ * header is rejected by the crc. The trigger is kept until a parser is free.
+ */
+void qrtone_check_trigger(qrtone_t* self) {
+    if(self->trigger_analyzer.first_tone_location == -1) {
+        return;
+    }
+    // A trigger located before the end of the last message was caused by its tones
+    if(self->trigger_analyzer.first_tone_location > self->parsed_samples) {
+        qrtone_parser_t* parser = qrtone_get_free_parser(self);
+        if(parser == NULL) {
+            return;
+        }
+        parser->state = QRTONE_PARSING_SYMBOLS;
+        parser->trigger_location = self->trigger_analyzer.first_tone_location;
+        parser->first_tone_sample_index = self->trigger_analyzer.first_tone_location;
+        parser->analyzed_samples = -1;
+        parser->timing_offset = self->trigger_analyzer.first_tone_offset;
+        qrtone_goertzel_bank_reset(&(parser->frequency_analyzers));
+#ifdef QRTONE_FIXED_POINT
+        qrtone_goertzel_bank_fixed_reset(&(parser->fixed_analyzers));
+#endif
+        memset(parser->symbols_cache, 0, HEADER_SYMBOLS);
+        parser->symbols_cache_length = HEADER_SYMBOLS;
+    }
+    self->trigger_analyzer.first_tone_location = -1;
+}
+
+/**
+ * A message has been decoded, the parsers triggered by its tones are abandoned
+ */
+void qrtone_abandon_parsers(qrtone_t* self) {
+    int32_t id_parser;
+    for (id_parser = 0; id_parser < self->parsers_length; id_parser++) {
+        qrtone_parser_t* parser = &(self->parsers[id_parser]);
+        if (parser->state == QRTONE_PARSING_SYMBOLS && parser->trigger_location <= self->parsed_samples) {
+            qrtone_parser_reset(parser);
+        }
+    }
+}
+
+int32_t qrtone_get_tone_index(qrtone_t* self, qrtone_parser_t* parser, int32_t samples_length) {
+    return (int32_t)(samples_length - (self->pushed_samples - qrtone_get_tone_location(self, parser)));
+}
+
+/**
+ * Decode the header symbols of the parser if its header_cache is NULL, the payload symbols otherwise
+ * @param symbols_margin NULL or confidence of each symbol, see qrtone_symbols_to_payload_buffer
+ * @param data Receive the header bytes or the payload
+ * @return TRUE if the header or the payload is valid
+ */
+int8_t qrtone_symbols_to_data(qrtone_t* self, qrtone_parser_t* parser, const uint16_t* symbols_margin, int8_t* data) {
+    if(parser->header_cache == NULL) {
+        return qrtone_symbols_to_payload_buffer(self, parser->symbols_cache, symbols_margin, parser->symbols_cache_length, HEADER_SYMBOLS, HEADER_ECC_SYMBOLS, 0, self->symbols_scratch, data)
+            && qrtone_header_init_from_data(&(parser->header), data) && parser->header.number_of_symbols <= self->profile->symbols_capacity;
+    }
+    return qrtone_symbols_to_payload_buffer(self, parser->symbols_cache, symbols_margin, parser->symbols_cache_length, ECC_SYMBOLS[parser->header_cache->ecc_level][0], ECC_SYMBOLS[parser->header_cache->ecc_level][1], parser->header_cache->crc, self->symbols_scratch, data);
+}
+
+void qrtone_soft_decision_heap_push(qrtone_soft_decision_pattern_t* heap, int32_t* heap_length, uint32_t cost, uint32_t mask, int32_t last) {
+    int32_t i = (*heap_length)++;
+    while(i > 0 && heap[(i - 1) / 2].cost > cost) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i].cost = cost;
+    heap[i].mask = mask;
+    heap[i].last = last;
 }
 
-int32_t qrtone_get_tone_index(qrtone_t* self, int32_t samples_length) {
-    return (int32_t)(samples_length - (self->pushed_samples - qrtone_get_tone_location(self)));
+qrtone_soft_decision_pattern_t qrtone_soft_decision_heap_pop(qrtone_soft_decision_pattern_t* heap, int32_t* heap_length) {
+    qrtone_soft_decision_pattern_t top = heap[0];
+    qrtone_soft_decision_pattern_t moved = heap[--(*heap_length)];
+    int32_t i = 0;
+    while(2 * i + 1 < *heap_length) {
+        int32_t child = 2 * i + 1;
+        if(child + 1 < *heap_length && heap[child + 1].cost < heap[child].cost) {
+            child++;
+        }
+        if(heap[child].cost >= moved.cost) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = moved;
+    return top;
 }
 
-void qrtone_cached_symbols_to_payload(qrtone_t* self) {
-    if(self->payload != NULL) {
-        free(self->payload);
+/**
+ * Chase decoding of a payload with crc. Substitute the least reliable symbols by their runner-up tone and decode again, in increasing
+ * order of the sum of the margins of the substituted symbols, until the crc is valid or profile->config.soft_decision_budget attempts.
+ * Each pattern of the heap spawns at most two patterns: the next symbol is added, or replaces the last symbol.
+ * @param symbols Hard decision symbols, restored on return
+ * @param symbols_scratch Buffer of symbols_length + block_symbols_size bytes
+ * @param payload Buffer receiving the decoded payload (without crc)
+ * @return TRUE if the payload has been decoded
+ */
+int8_t qrtone_symbols_soft_decision(qrtone_t* self, int8_t* symbols, const int8_t* symbols_runner_up, const uint16_t* symbols_margin, int32_t symbols_length,
+    int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t* symbols_scratch, int8_t* payload) {
+    // least reliable symbols, by ascending margin
+    int32_t positions[QRTONE_SOFT_DECISION_POSITIONS];
+    int8_t hard_symbols[QRTONE_SOFT_DECISION_POSITIONS];
+    int32_t positions_length = 0;
+    int32_t i;
+    for(i = 0; i < symbols_length; i++) {
+        uint16_t margin = symbols_margin[i];
+        if(positions_length == QRTONE_SOFT_DECISION_POSITIONS) {
+            if(margin >= symbols_margin[positions[positions_length - 1]]) {
+                continue;
+            }
+            positions_length--;
+        }
+        int32_t j;
+        for(j = positions_length; j > 0 && symbols_margin[positions[j - 1]] > margin; j--) {
+            positions[j] = positions[j - 1];
+        }
+        positions[j] = i;
+        positions_length++;
+    }
+    qrtone_soft_decision_pattern_t* heap = self->soft_decision_heap;
+    int32_t heap_length = 0;
+    if(positions_length > 0) {
+        qrtone_soft_decision_heap_push(heap, &heap_length, symbols_margin[positions[0]], 1, 0);
+    }
+    int32_t fixed_errors = self->fixed_errors;
+    int32_t attempt;
+    for(attempt = 0; attempt < self->profile->config.soft_decision_budget && heap_length > 0; attempt++) {
+        qrtone_soft_decision_pattern_t pattern = qrtone_soft_decision_heap_pop(heap, &heap_length);
+        int32_t substitutions = 0;
+        for(i = 0; i <= pattern.last; i++) {
+            if((pattern.mask >> i) & 1) {
+                substitutions++;
+                hard_symbols[i] = symbols[positions[i]];
+                symbols[positions[i]] = symbols_runner_up[positions[i]];
+            }
+        }
+        self->fixed_errors = fixed_errors + substitutions;
+        int8_t decoded = qrtone_symbols_to_payload_buffer(self, symbols, NULL, symbols_length, block_symbols_size, block_ecc_symbols, TRUE, symbols_scratch, payload);
+        for(i = 0; i <= pattern.last; i++) {
+            if((pattern.mask >> i) & 1) {
+                symbols[positions[i]] = hard_symbols[i];
+            }
+        }
+        if(decoded) {
+            return TRUE;
+        }
+        int32_t next = pattern.last + 1;
+        if(next < positions_length) {
+            uint32_t next_margin = symbols_margin[positions[next]];
+            qrtone_soft_decision_heap_push(heap, &heap_length, pattern.cost + next_margin, pattern.mask | (1u << next), next);
+            qrtone_soft_decision_heap_push(heap, &heap_length, pattern.cost - symbols_margin[positions[pattern.last]] + next_margin,
+                (pattern.mask & ~(1u << pattern.last)) | (1u << next), next);
+        }
     }
-    self->payload = qrtone_symbols_to_payload(self, self->symbols_cache, self->symbols_cache_length, ECC_SYMBOLS[self->header_cache->ecc_level][0], ECC_SYMBOLS[self->header_cache->ecc_level][1], self->header_cache->crc);
-    self->payload_length = self->header_cache->length;
+    self->fixed_errors = fixed_errors;
+    return FALSE;
 }
 
-void qrtone_cached_symbols_to_header(qrtone_t* self) {
-    int8_t* header_bytes = qrtone_symbols_to_payload(self, self->symbols_cache, self->symbols_cache_length, HEADER_SYMBOLS, HEADER_ECC_SYMBOLS, 0);
-    if(header_bytes != NULL) {
-        if(self->header_cache != NULL) {
-            free(self->header_cache);
+/**
+ * Decode the cached symbols with errors only, then with erasures, then with the soft decision decoding for payloads with crc.
+ * Blocks overloaded with errors may be miscorrected without error, so the next pass is triggered by the crc check of the decoded data.
+ */
+int8_t qrtone_cached_symbols_to_data(qrtone_t* self, qrtone_parser_t* parser, int8_t* data) {
+    int32_t fixed_errors = self->fixed_errors;
+    if(qrtone_symbols_to_data(self, parser, NULL, data)) {
+        return TRUE;
+    }
+    if(self->profile->erasure_margin > 0) {
+        self->fixed_errors = fixed_errors;
+        if(qrtone_symbols_to_data(self, parser, parser->symbols_margin, data)) {
+            return TRUE;
         }
-        self->header_cache = malloc(sizeof(qrtone_header_t));
-        if(!qrtone_header_init_from_data(self->header_cache, header_bytes)) {
-            self->header_cache = NULL;
+    }
+    // Only the crc16 of the payload is strong enough to reject the miscorrections of many attempts
+    if(self->profile->config.soft_decision_budget > 0 && parser->header_cache != NULL && parser->header_cache->crc) {
+        self->fixed_errors = fixed_errors;
+        return qrtone_symbols_soft_decision(self, parser->symbols_cache, parser->symbols_runner_up, parser->symbols_margin, parser->symbols_cache_length,
+            ECC_SYMBOLS[parser->header_cache->ecc_level][0], ECC_SYMBOLS[parser->header_cache->ecc_level][1], self->symbols_scratch, data);
+    }
+    return FALSE;
+}
+
+/**
+ * Keep the reports of the message, the next message can be triggered before they are read
+ */
+void qrtone_end_message(qrtone_t* self, qrtone_parser_t* parser) {
+    self->quality_parser = parser;
+    self->quality_symbols_length = parser->symbols_cache_length;
+    self->timing_offset = parser->timing_offset;
+}
+
+void qrtone_cached_symbols_to_payload(qrtone_t* self, qrtone_parser_t* parser) {
+    qrtone_end_message(self, parser);
+    int64_t header_location = parser->first_tone_sample_index - (((int64_t)(HEADER_SYMBOLS) / 2) * ((int64_t)self->word_length + self->word_silence_length)) / self->decimation;
+    self->payload_sample_index = header_location * self->decimation + self->profile->decimator_offset - self->gate_length * 2;
+    self->payload = NULL;
+    self->fixed_errors = parser->fixed_errors;
+    if(qrtone_cached_symbols_to_data(self, parser, self->payload_buffer)) {
+        self->payload = self->payload_buffer;
+    }
+    self->payload_length = parser->header_cache->length;
+}
+
+/**
+ * Decode the header, fixed_errors of the last message is kept while the payload of the parser is not decoded
+ */
+void qrtone_cached_symbols_to_header(qrtone_t* self, qrtone_parser_t* parser) {
+    int8_t header_bytes[HEADER_SIZE];
+    int32_t fixed_errors = self->fixed_errors;
+    parser->header_cache = NULL;
+    self->fixed_errors = 0;
+    if(qrtone_cached_symbols_to_data(self, parser, header_bytes)) {
+        parser->header_cache = &(parser->header);
+        parser->fixed_errors = self->fixed_errors;
+        self->fixed_errors = fixed_errors;
+    } else {
+        qrtone_end_message(self, parser);
+    }
+}
+
+
+/**
+ * Store the two symbols of the current word, chosen by the highest filter level in each half of the frequencies.
+ * The margin over the second highest level is kept as the confidence of the symbol.
+ */
+void qrtone_spl_to_symbols(qrtone_parser_t* self) {
+    float spl[QRTONE_NUM_FREQUENCIES];
+    int32_t idfreq;
+    qrtone_goertzel_bank_compute_rms(&(self->frequency_analyzers), spl);
+    for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
+        spl[idfreq] = 20.0f * log10f(spl[idfreq]);
+    }
+    int32_t symbol_offset;
+    for (symbol_offset = 0; symbol_offset < 2; symbol_offset++) {
+        int32_t max_symbol_id = -1;
+        int32_t second_symbol_id = -1;
+        float max_symbol_gain = -99999999999999.9f;
+        float second_symbol_gain = -99999999999999.9f;
+        float sum_gain = 0;
+        for (idfreq = symbol_offset * FREQUENCY_ROOT; idfreq < (symbol_offset + 1) * FREQUENCY_ROOT; idfreq++) {
+            float gain = spl[idfreq];
+            sum_gain += gain;
+            if (gain > max_symbol_gain) {
+                second_symbol_gain = max_symbol_gain;
+                second_symbol_id = max_symbol_id;
+                max_symbol_gain = gain;
+                max_symbol_id = idfreq;
+            } else if (gain > second_symbol_gain) {
+                second_symbol_gain = gain;
+                second_symbol_id = idfreq;
+            }
         }
-        free(header_bytes);
+        int32_t symbol_index = self->symbol_index * 2 + symbol_offset;
+        self->symbols_cache[symbol_index] = (int8_t)(max_symbol_id - symbol_offset * FREQUENCY_ROOT);
+        self->symbols_runner_up[symbol_index] = (int8_t)(max(second_symbol_id, symbol_offset * FREQUENCY_ROOT) - symbol_offset * FREQUENCY_ROOT);
+        // silent bins give -inf levels, the margin saturates
+        float margin = (max_symbol_gain - second_symbol_gain) * 256.0f;
+        self->symbols_margin[symbol_index] = margin < 65535.0f ? (uint16_t)margin : 65535;
+        self->symbols_level[symbol_index] = qrtone_level_to_q8(max_symbol_gain);
+        self->symbols_noise[symbol_index] = qrtone_level_to_q8((sum_gain - max_symbol_gain - second_symbol_gain) / (FREQUENCY_ROOT - 2));
     }
 }
 
+#ifdef QRTONE_FIXED_POINT
+/**
+ * Integer version of qrtone_spl_to_symbols
+ */
+void qrtone_fixed_levels_to_symbols(qrtone_parser_t* self) {
+    int32_t levels[QRTONE_NUM_FREQUENCIES];
+    int32_t idfreq;
+    qrtone_goertzel_bank_fixed_compute_levels(&(self->fixed_analyzers), levels);
+    int32_t symbol_offset;
+    for (symbol_offset = 0; symbol_offset < 2; symbol_offset++) {
+        int32_t max_symbol_id = symbol_offset * FREQUENCY_ROOT;
+        int32_t second_symbol_id = max_symbol_id + 1;
+        int32_t second_level = INT32_MIN;
+        int64_t sum_levels = levels[max_symbol_id];
+        for (idfreq = max_symbol_id + 1; idfreq < (symbol_offset + 1) * FREQUENCY_ROOT; idfreq++) {
+            sum_levels += levels[idfreq];
+            if (levels[idfreq] > levels[max_symbol_id]) {
+                second_level = levels[max_symbol_id];
+                second_symbol_id = max_symbol_id;
+                max_symbol_id = idfreq;
+            } else if (levels[idfreq] > second_level) {
+                second_level = levels[idfreq];
+                second_symbol_id = idfreq;
+            }
+        }
+        int32_t symbol_index = self->symbol_index * 2 + symbol_offset;
+        self->symbols_cache[symbol_index] = (int8_t)(max_symbol_id - symbol_offset * FREQUENCY_ROOT);
+        self->symbols_runner_up[symbol_index] = (int8_t)(second_symbol_id - symbol_offset * FREQUENCY_ROOT);
+        // levels are Q16 log2 of the squared rms, QRTONE_FIXED_DB_PER_LEVEL * 256 / 65536 is 197283 / 2^24
+        int64_t margin = (((int64_t)levels[max_symbol_id] - second_level) * 197283) >> 24;
+        self->symbols_margin[symbol_index] = (uint16_t)(margin < 65535 ? margin : 65535);
+        self->symbols_level[symbol_index] = qrtone_fixed_level_to_q8(levels[max_symbol_id]);
+        self->symbols_noise[symbol_index] = qrtone_fixed_level_to_q8((sum_levels - levels[max_symbol_id] - second_level) / (FREQUENCY_ROOT - 2));
+    }
+}
+#endif
 
-int8_t qrtone_analyze_tones(qrtone_t* self, float* samples, int32_t samples_length) {
+/**
+ * Decode the symbols of the tones of a parser contained in samples or samples_s16
+ * @param samples float samples or NULL
+ * @param samples_s16 int16 samples, used when samples is NULL
+ * @return 1 if the payload of the parser has been decoded
+ */
+int8_t qrtone_analyze_tones_samples(qrtone_t* self, qrtone_parser_t* parser, const float* samples, const int16_t* samples_s16, int32_t samples_length) {
+    parser->analyzed_samples = self->pushed_samples;
     // Processed samples in current tone
-    int32_t processed_samples = (int32_t)(self->pushed_samples - samples_length - qrtone_get_tone_location(self));
+    int32_t processed_samples = (int32_t)(self->pushed_samples - samples_length - qrtone_get_tone_location(self, parser));
     // cursor keep track of tone analysis in provided samples array, cursor start with tone location
-    int32_t cursor = max(0, qrtone_get_tone_index(self, samples_length));
+    int32_t cursor = max(0, qrtone_get_tone_index(self, parser, samples_length));
     while(cursor < samples_length) {
         // Processed samples in current tone taking account of cursor position
         int32_t tone_window_cursor = processed_samples + cursor;
         // do not process more than wordLength
-        int32_t cursor_increment = min(samples_length - cursor, self->word_length - tone_window_cursor);
-        int32_t idfreq;
-        for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
-            int32_t start_window = self->word_length / 2 - self->frequency_analyzers[idfreq].window_size / 2;
-            int32_t start_analyze = max(0, start_window - tone_window_cursor) + cursor;
-            int32_t analyze_length = min(samples_length - start_analyze,
-                    self->frequency_analyzers[idfreq].window_size - self->frequency_analyzers[idfreq].processed_samples);
-            if(analyze_length > 0 && start_analyze < samples_length) {
-                qrtone_goertzel_process_samples((&self->frequency_analyzers[idfreq]), samples + start_analyze, analyze_length);
-            }
+        int32_t cursor_increment = min(samples_length - cursor, self->analysis_word_length - tone_window_cursor);
+#ifdef QRTONE_FIXED_POINT
+        if (samples == NULL) {
+            qrtone_goertzel_bank_fixed_process_samples(&(parser->fixed_analyzers), samples_s16 + cursor, cursor_increment, tone_window_cursor);
+        } else
+#endif
+        {
+            qrtone_goertzel_bank_process_samples(&(parser->frequency_analyzers), samples + cursor, cursor_increment, tone_window_cursor);
         }
-        if (tone_window_cursor + cursor_increment == self->word_length) {
-            float spl[QRTONE_NUM_FREQUENCIES];
-            for (idfreq = 0; idfreq < QRTONE_NUM_FREQUENCIES; idfreq++) {
-                float rmsValue = qrtone_goertzel_compute_rms(&(self->frequency_analyzers[idfreq]));
-                spl[idfreq] = 20.0f * log10f(rmsValue);
-            }
-            int32_t symbol_offset;
-            for (symbol_offset = 0; symbol_offset < 2; symbol_offset++) {
-                int32_t max_symbol_id = -1;
-                float max_symbol_gain = -99999999999999.9f;
-                for (idfreq = symbol_offset * FREQUENCY_ROOT; idfreq < (symbol_offset + 1) * FREQUENCY_ROOT; idfreq++) {
-                    float gain = spl[idfreq];
-                    if (gain > max_symbol_gain) {
-                        max_symbol_gain = gain;
-                        max_symbol_id = idfreq;
-                    }
-                }
-                self->symbols_cache[self->symbol_index * 2 + symbol_offset] = (int8_t)(max_symbol_id - symbol_offset * FREQUENCY_ROOT);
+        cursor += cursor_increment;
+        if (tone_window_cursor + cursor_increment == self->analysis_word_length) {
+#ifdef QRTONE_FIXED_POINT
+            if (samples == NULL) {
+                qrtone_fixed_levels_to_symbols(parser);
+            } else
+#endif
+            {
+                qrtone_spl_to_symbols(parser);
             }
-            self->symbol_index += 1;
+            parser->symbol_index += 1;
             // jump to next tone samples
-            processed_samples = (int32_t)(self->pushed_samples - samples_length - qrtone_get_tone_location(self));
-            cursor = max(cursor, qrtone_get_tone_index(self, samples_length));
-            if (self->symbol_index * 2 == self->symbols_cache_length) {
-                if (self->header_cache == NULL) {
+            processed_samples = (int32_t)(self->pushed_samples - samples_length - qrtone_get_tone_location(self, parser));
+            cursor = max(cursor, qrtone_get_tone_index(self, parser, samples_length));
+            if (parser->symbol_index * 2 == parser->symbols_cache_length) {
+                if (parser->header_cache == NULL) {
                     // Decoding of HEADER complete
-                    qrtone_cached_symbols_to_header(self);
-                    // CRC error
-                    if (self->header_cache == NULL) {
-                        qrtone_reset(self);
-                        break;
+                    qrtone_cached_symbols_to_header(self, parser);
+                    // CRC error, the trigger was false or the message is lost
+                    if (parser->header_cache == NULL) {
+                        qrtone_parser_reset(parser);
+                        return 0;
                     }
-                    free(self->symbols_cache);
-                    self->symbols_cache = malloc(self->header_cache->number_of_symbols);
-                    memset(self->symbols_cache, 0, self->header_cache->number_of_symbols);
-                    self->symbols_cache_length = self->header_cache->number_of_symbols;
-                    self->symbol_index = 0;
-                    self->first_tone_sample_index += ((int64_t)(HEADER_SYMBOLS) / 2) * ((int64_t)self->word_length + self->word_silence_length);
+                    memset(parser->symbols_cache, 0, parser->header_cache->number_of_symbols);
+                    parser->symbols_cache_length = parser->header_cache->number_of_symbols;
+                    parser->symbol_index = 0;
+                    parser->first_tone_sample_index += (((int64_t)(HEADER_SYMBOLS) / 2) * ((int64_t)self->word_length + self->word_silence_length)) / self->decimation;
                 } else {
                     // Decoding complete
-                    qrtone_cached_symbols_to_payload(self);
-                    qrtone_reset(self);
+                    qrtone_cached_symbols_to_payload(self, parser);
+                    qrtone_parser_reset(parser);
+                    if (self->payload != NULL) {
+                        self->parsed_samples = self->pushed_samples - samples_length + cursor;
+                        qrtone_abandon_parsers(self);
+                        if (self->payload_callback != NULL) {
+                            qrtone_message_t message;
+                            message.payload = self->payload;
+                            message.payload_length = self->payload_length;
+                            message.sample_index = self->payload_sample_index;
+                            qrtone_get_link_quality(self, &(message.quality));
+                            self->payload_callback(self->payload_callback_data, &message);
+                        }
+                    }
                     return self->payload != NULL;
                 }
             }
         }
-        cursor += cursor_increment;
     }
     return 0;
 }
 
+/**
+ * @return A parser that has not analyzed the last pushed samples, NULL if all parsers are up to date
+ */
+qrtone_parser_t* qrtone_get_pending_parser(qrtone_t* self) {
+    int32_t id_parser;
+    for (id_parser = 0; id_parser < self->parsers_length; id_parser++) {
+        qrtone_parser_t* parser = &(self->parsers[id_parser]);
+        if (parser->state == QRTONE_PARSING_SYMBOLS && parser->analyzed_samples != self->pushed_samples) {
+            return parser;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Process the samples in windows of qrtone_trigger_maximum_window_length samples. The trigger analyzer looks for the gates in the window,
+ * then each parser analyzes its tones up to the end of the window. The decoded messages do not depend on the length of the pushes.
+ * @param samples float samples or NULL
+ * @param samples_s16 int16 samples, used when samples is NULL
+ */
+int8_t qrtone_push_samples_buffer(qrtone_t* self, const float* samples, const int16_t* samples_s16, int32_t samples_length) {
+    const int64_t push_start = self->pushed_samples;
+    int8_t decoded = 0;
+    int32_t processed = 0;
+    while(processed < samples_length) {
+        int32_t window_length = min(samples_length - processed, qrtone_trigger_maximum_window_length(&(self->trigger_analyzer)));
+#ifdef QRTONE_FIXED_POINT
+        if (samples == NULL) {
+            qrtone_trigger_analyzer_process_samples_s16(&(self->trigger_analyzer), push_start + processed, samples_s16 + processed, window_length);
+        } else
+#endif
+        {
+            qrtone_trigger_analyzer_process_samples(&(self->trigger_analyzer), push_start + processed, samples + processed, window_length);
+        }
+        processed += window_length;
+        self->pushed_samples = push_start + processed;
+        qrtone_check_trigger(self);
+        qrtone_parser_t* parser;
+        while((parser = qrtone_get_pending_parser(self)) != NULL) {
+            // a new parser analyzes the pushed samples from the beginning, its first tone may precede the trigger window
+            int32_t from = (int32_t)(max(parser->analyzed_samples, push_start) - push_start);
+#ifdef QRTONE_FIXED_POINT
+            if (samples == NULL) {
+                decoded |= qrtone_analyze_tones_samples(self, parser, NULL, samples_s16 + from, processed - from);
+            } else
+#endif
+            {
+                decoded |= qrtone_analyze_tones_samples(self, parser, samples + from, NULL, processed - from);
+            }
+            // the message may have ended in this window, the kept trigger can start the freed parser
+            qrtone_check_trigger(self);
+        }
+        // all parsers are busy, the trigger is dropped
+        self->trigger_analyzer.first_tone_location = -1;
+    }
+    return decoded;
+}
+
+int8_t qrtone_push_decimated_block(qrtone_t* self, int8_t s16, int32_t decimated_length) {
+#ifdef QRTONE_FIXED_POINT
+    if (s16) {
+        return qrtone_push_samples_buffer(self, NULL, self->decimated_samples_s16, decimated_length);
+    }
+#endif
+    return qrtone_push_samples_buffer(self, self->decimated_samples, NULL, decimated_length);
+}
+
+/**
+ * Band limiting filter of the analyzed sample at the end of the window
+ * @param window last decimator_taps_length input samples from the oldest
+ */
+float qrtone_decimator_filter(const qrtone_profile_t* profile, const float* window) {
+    const int32_t taps_length = profile->decimator_taps_length;
+    // the symmetric taps are folded
+    float value = profile->decimator_center_tap * window[(taps_length - 1) / 2];
+    int32_t j;
+    for (j = 0; j < profile->decimator_folded_length; j++) {
+        const int32_t k = profile->decimator_taps_index[j];
+        value += profile->decimator_taps[j] * (window[k] + window[taps_length - 1 - k]);
+    }
+    return value;
+}
+
+#ifdef QRTONE_FIXED_POINT
+/**
+ * qrtone_decimator_filter of int16 samples with the fixed point taps, the products are accumulated in an int32
+ */
+int16_t qrtone_decimator_filter_s16(const qrtone_profile_t* profile, const int16_t* window) {
+    const int32_t taps_length = profile->decimator_taps_length;
+    int32_t value = profile->decimator_center_tap_fixed * window[(taps_length - 1) / 2];
+    int32_t j;
+    for (j = 0; j < profile->decimator_folded_length; j++) {
+        const int32_t k = profile->decimator_taps_index[j];
+        value += profile->decimator_taps_fixed[j] * (window[k] + window[taps_length - 1 - k]);
+    }
+    // round to the nearest sample
+    return qrtone_fixed_saturate((value + (1 << (profile->decimator_fixed_shift - 1))) >> profile->decimator_fixed_shift);
+}
+#endif
+
+/**
+ * Band limit and decimate the samples, only the kept samples are computed (polyphase decimation).
+ * The decimated samples are analyzed by blocks of QRTONE_DECIMATION_BLOCK samples.
+ * @param samples float samples or NULL
+ * @param samples_s16 int16 samples, used when samples is NULL. They are filtered in fixed point
+ */
+int8_t qrtone_push_samples_decimated(qrtone_t* self, const float* samples, const int16_t* samples_s16, int32_t samples_length) {
+    const qrtone_profile_t* profile = self->profile;
+    const int32_t taps_length = profile->decimator_taps_length;
+    const int32_t decimation = self->decimation;
+    int8_t decoded = 0;
+    int32_t decimated_length = 0;
+    int32_t i;
+    for (i = 0; i < samples_length; i++) {
+#ifdef QRTONE_FIXED_POINT
+        if (samples == NULL) {
+            self->decimator_history_s16[self->decimator_cursor] = samples_s16[i];
+            self->decimator_history_s16[self->decimator_cursor + taps_length] = samples_s16[i];
+        } else
+#endif
+        {
+            self->decimator_history[self->decimator_cursor] = samples[i];
+            self->decimator_history[self->decimator_cursor + taps_length] = samples[i];
+        }
+        self->decimator_cursor = self->decimator_cursor + 1 == taps_length ? 0 : self->decimator_cursor + 1;
+        self->decimator_phase += 1;
+        if (self->decimator_phase < decimation) {
+            continue;
+        }
+        self->decimator_phase = 0;
+#ifdef QRTONE_FIXED_POINT
+        if (samples == NULL) {
+            self->decimated_samples_s16[decimated_length++] = qrtone_decimator_filter_s16(profile, self->decimator_history_s16 + self->decimator_cursor);
+        } else
+#endif
+        {
+            self->decimated_samples[decimated_length++] = qrtone_decimator_filter(profile, self->decimator_history + self->decimator_cursor);
+        }
+        if (decimated_length == QRTONE_DECIMATION_BLOCK) {
+            decoded |= qrtone_push_decimated_block(self, samples == NULL, decimated_length);
+            decimated_length = 0;
+        }
+    }
+    if (decimated_length > 0) {
+        decoded |= qrtone_push_decimated_block(self, samples == NULL, decimated_length);
+    }
+    return decoded;
+}
+
 int8_t qrtone_push_samples(qrtone_t* self,float* samples, int32_t samples_length) {
-    self->pushed_samples += samples_length;
-    if(self->qr_tone_state == QRTONE_WAITING_TRIGGER) {
-        qrtone_feed_trigger_analyzer(self,self->pushed_samples - samples_length, samples, samples_length);
+    if (self->decimation > 1) {
+        return qrtone_push_samples_decimated(self, samples, NULL, samples_length);
     }
-    if(self->qr_tone_state == QRTONE_PARSING_SYMBOLS) {
-        return qrtone_analyze_tones(self, samples, samples_length);
+    return qrtone_push_samples_buffer(self, samples, NULL, samples_length);
+}
+
+#ifdef QRTONE_FIXED_POINT
+int8_t qrtone_push_samples_s16(qrtone_t* self, const int16_t* samples, int32_t samples_length) {
+    if (self->decimation > 1) {
+        return qrtone_push_samples_decimated(self, NULL, samples, samples_length);
     }
-    return 0;
+    return qrtone_push_samples_buffer(self, NULL, samples, samples_length);
 }
+#endif
 
 int8_t* qrtone_get_payload(qrtone_t* self) {
     return self->payload;
@@ -1688,9 +3927,680 @@ int32_t qrtone_get_fixed_errors(qrtone_t* self) {
     return self->fixed_errors;
 }
 
+int32_t qrtone_get_symbols_quality(qrtone_t* self, qrtone_symbol_quality_t* symbols, int32_t symbols_length) {
+    int32_t length = min(symbols_length, self->quality_symbols_length);
+    int32_t i;
+    const qrtone_parser_t* parser = self->quality_parser;
+    for(i = 0; i < length; i++) {
+        symbols[i].level = parser->symbols_level[i] / 256.0f;
+        symbols[i].margin = parser->symbols_margin[i] / 256.0f;
+        symbols[i].runner_up_level = symbols[i].level - symbols[i].margin;
+        symbols[i].noise_level = parser->symbols_noise[i] / 256.0f;
+    }
+    return length;
+}
+
+void qrtone_get_link_quality(qrtone_t* self, qrtone_link_quality_t* quality) {
+    int64_t sum_level = 0;
+    int64_t sum_noise = 0;
+    int64_t sum_margin = 0;
+    int32_t min_margin = 65535;
+    const qrtone_parser_t* parser = self->quality_parser;
+    int32_t i;
+    for(i = 0; i < self->quality_symbols_length; i++) {
+        sum_level += parser->symbols_level[i];
+        sum_noise += parser->symbols_noise[i];
+        sum_margin += parser->symbols_margin[i];
+        min_margin = min(min_margin, parser->symbols_margin[i]);
+    }
+    float length = (float)max(1, self->quality_symbols_length);
+    quality->symbols_length = self->quality_symbols_length;
+    quality->fixed_errors = self->fixed_errors;
+    quality->level = sum_level / 256.0f / length;
+    quality->noise_level = sum_noise / 256.0f / length;
+    quality->snr = quality->level - quality->noise_level;
+    quality->mean_margin = sum_margin / 256.0f / length;
+    quality->min_margin = self->quality_symbols_length > 0 ? min_margin / 256.0f : 0;
+    quality->timing_offset = self->timing_offset * self->decimation;
+}
+
 int64_t qrtone_get_payload_sample_index(qrtone_t* self) {
-    return self->first_tone_sample_index - ((int64_t)(HEADER_SYMBOLS) / 2) * ((int64_t)self->word_length + self->word_silence_length) - self->gate_length * 2;
+    return self->payload_sample_index;
+}
+
+/**
+ * Little endian serialization of the decoder state, bytes are only written while they fit in the buffer
+ */
+typedef struct _qrtone_snapshot_writer_t {
+    uint8_t* data;
+    size_t capacity;
+    size_t length;
+} qrtone_snapshot_writer_t;
+
+typedef struct _qrtone_snapshot_reader_t {
+    const uint8_t* data;
+    size_t length;
+    size_t cursor;
+    int8_t failed; // read past the end or inconsistent value
+} qrtone_snapshot_reader_t;
+
+void qrtone_snapshot_write(qrtone_snapshot_writer_t* self, uint64_t value, int32_t bytes) {
+    int32_t i;
+    for (i = 0; i < bytes; i++) {
+        if (self->length < self->capacity) {
+            self->data[self->length] = (uint8_t)(value >> (8 * i));
+        }
+        self->length++;
+    }
+}
+
+uint64_t qrtone_snapshot_read(qrtone_snapshot_reader_t* self, int32_t bytes) {
+    uint64_t value = 0;
+    if (self->cursor + bytes > self->length) {
+        self->failed = TRUE;
+        return 0;
+    }
+    int32_t i;
+    for (i = 0; i < bytes; i++) {
+        value |= (uint64_t)self->data[self->cursor + i] << (8 * i);
+    }
+    self->cursor += bytes;
+    return value;
+}
+
+void qrtone_snapshot_write_floats(qrtone_snapshot_writer_t* self, const float* values, int32_t values_length) {
+    int32_t i;
+    for (i = 0; i < values_length; i++) {
+        uint32_t bits;
+        memcpy(&bits, values + i, sizeof(bits));
+        qrtone_snapshot_write(self, bits, 4);
+    }
+}
+
+void qrtone_snapshot_read_floats(qrtone_snapshot_reader_t* self, float* values, int32_t values_length) {
+    int32_t i;
+    for (i = 0; i < values_length; i++) {
+        uint32_t bits = (uint32_t)qrtone_snapshot_read(self, 4);
+        memcpy(values + i, &bits, sizeof(bits));
+    }
+}
+
+void qrtone_snapshot_write_int32s(qrtone_snapshot_writer_t* self, const int32_t* values, int32_t values_length) {
+    int32_t i;
+    for (i = 0; i < values_length; i++) {
+        qrtone_snapshot_write(self, (uint32_t)values[i], 4);
+    }
+}
+
+void qrtone_snapshot_read_int32s(qrtone_snapshot_reader_t* self, int32_t* values, int32_t values_length) {
+    int32_t i;
+    for (i = 0; i < values_length; i++) {
+        values[i] = (int32_t)(uint32_t)qrtone_snapshot_read(self, 4);
+    }
+}
+
+/**
+ * Parameters of the state layout, a snapshot is restored only by a decoder with the same parameters
+ */
+void qrtone_snapshot_write_layout(qrtone_t* self, qrtone_snapshot_writer_t* writer) {
+    const qrtone_trigger_analyzer_t* trigger = &(self->trigger_analyzer);
+    int32_t layout[12];
+    layout[0] = self->word_length;
+    layout[1] = self->word_silence_length;
+    layout[2] = self->gate_length;
+    layout[3] = trigger->window_analyze;
+    layout[4] = trigger->window_offset;
+    layout[5] = trigger->sliding_dft.delay_line != NULL ? trigger->sliding_dft.window_size : 0;
+    layout[6] = trigger->spl_history[0].values_length;
+    layout[7] = trigger->background_noise_evaluator.marker_count;
+    layout[8] = self->parsers_length;
+    layout[9] = self->profile->symbols_capacity;
+    layout[10] = self->decimation;
+    layout[11] = self->profile->decimator_taps_length;
+#ifdef QRTONE_FIXED_POINT
+    qrtone_snapshot_write(writer, 1, 1);
+#else
+    qrtone_snapshot_write(writer, 0, 1);
+#endif
+    qrtone_snapshot_write_floats(writer, &(self->sample_rate), 1);
+    qrtone_snapshot_write_int32s(writer, layout, 12);
+}
+
+void qrtone_snapshot_write_goertzel(qrtone_snapshot_writer_t* writer, const qrtone_goertzel_t* goertzel) {
+    qrtone_snapshot_write_floats(writer, &(goertzel->s1), 1);
+    qrtone_snapshot_write_floats(writer, &(goertzel->s2), 1);
+    qrtone_snapshot_write_floats(writer, &(goertzel->last_sample), 1);
+    qrtone_snapshot_write(writer, (uint32_t)goertzel->processed_samples, 4);
+}
+
+void qrtone_snapshot_read_goertzel(qrtone_snapshot_reader_t* reader, qrtone_goertzel_t* goertzel) {
+    qrtone_snapshot_read_floats(reader, &(goertzel->s1), 1);
+    qrtone_snapshot_read_floats(reader, &(goertzel->s2), 1);
+    qrtone_snapshot_read_floats(reader, &(goertzel->last_sample), 1);
+    goertzel->processed_samples = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+}
+
+void qrtone_snapshot_write_trigger(qrtone_snapshot_writer_t* writer, qrtone_trigger_analyzer_t* self) {
+    int32_t i;
+    if (self->sliding_dft.delay_line != NULL) {
+        qrtone_snapshot_write(writer, (uint32_t)self->sliding_remaining, 4);
+        qrtone_snapshot_write(writer, (uint32_t)self->sliding_dft.delay_cursor, 4);
+        qrtone_snapshot_write_floats(writer, self->sliding_dft.delay_line, self->sliding_dft.window_size);
+        qrtone_snapshot_write_floats(writer, self->sliding_dft.s1, QRTONE_SLIDING_DFT_BINS);
+        qrtone_snapshot_write_floats(writer, self->sliding_dft.s2, QRTONE_SLIDING_DFT_BINS);
+    } else {
+        qrtone_snapshot_write(writer, (uint32_t)self->processed_window_alpha, 4);
+        qrtone_snapshot_write(writer, (uint32_t)self->processed_window_beta, 4);
+        qrtone_snapshot_write_floats(writer, &(self->window_energy_alpha), 1);
+        qrtone_snapshot_write_floats(writer, &(self->window_energy_beta), 1);
+#ifdef QRTONE_FIXED_POINT
+        qrtone_snapshot_write(writer, (uint64_t)self->window_energy_s16_alpha, 8);
+        qrtone_snapshot_write(writer, (uint64_t)self->window_energy_s16_beta, 8);
+#endif
+        for (i = 0; i < 2; i++) {
+            qrtone_snapshot_write_goertzel(writer, &(self->frequency_analyzers_alpha[i]));
+            qrtone_snapshot_write_goertzel(writer, &(self->frequency_analyzers_beta[i]));
+#ifdef QRTONE_FIXED_POINT
+            qrtone_snapshot_write_int32s(writer, &(self->fixed_analyzers_alpha[i].s1), 1);
+            qrtone_snapshot_write_int32s(writer, &(self->fixed_analyzers_alpha[i].s2), 1);
+            qrtone_snapshot_write_int32s(writer, &(self->fixed_analyzers_alpha[i].processed_samples), 1);
+            qrtone_snapshot_write_int32s(writer, &(self->fixed_analyzers_beta[i].s1), 1);
+            qrtone_snapshot_write_int32s(writer, &(self->fixed_analyzers_beta[i].s2), 1);
+            qrtone_snapshot_write_int32s(writer, &(self->fixed_analyzers_beta[i].processed_samples), 1);
+#endif
+        }
+    }
+    // P^2 markers of the background noise, restored without the warm-up of the percentile
+    const qrtone_percentile_t* percentile = &(self->background_noise_evaluator);
+    qrtone_snapshot_write(writer, (uint32_t)percentile->count, 4);
+    qrtone_snapshot_write_floats(writer, percentile->q, percentile->marker_count);
+    qrtone_snapshot_write_floats(writer, percentile->dn, percentile->marker_count);
+    qrtone_snapshot_write_floats(writer, percentile->np, percentile->marker_count);
+    qrtone_snapshot_write_int32s(writer, percentile->n, percentile->marker_count);
+    // Levels history from the oldest
+    int32_t id_freq;
+    for (id_freq = 0; id_freq < 2; id_freq++) {
+        qrtone_array_t* history = &(self->spl_history[id_freq]);
+        qrtone_snapshot_write(writer, (uint32_t)qrtone_array_size(history), 4);
+        for (i = 0; i < qrtone_array_size(history); i++) {
+            float value = qrtone_array_get(history, i);
+            qrtone_snapshot_write_floats(writer, &value, 1);
+        }
+    }
+    const qrtone_peak_finder_t* peak_finder = &(self->peak_finder);
+    qrtone_snapshot_write(writer, (uint8_t)peak_finder->increase, 1);
+    qrtone_snapshot_write_floats(writer, &(peak_finder->old_val), 1);
+    qrtone_snapshot_write(writer, (uint64_t)peak_finder->old_index, 8);
+    qrtone_snapshot_write(writer, (uint8_t)peak_finder->added, 1);
+    qrtone_snapshot_write_floats(writer, &(peak_finder->last_peak_value), 1);
+    qrtone_snapshot_write(writer, (uint64_t)peak_finder->last_peak_index, 8);
+    qrtone_snapshot_write(writer, (uint32_t)peak_finder->increase_count, 4);
+    qrtone_snapshot_write(writer, (uint32_t)peak_finder->decrease_count, 4);
+    qrtone_snapshot_write(writer, (uint64_t)self->first_tone_location, 8);
+    qrtone_snapshot_write_floats(writer, &(self->first_tone_offset), 1);
+}
+
+void qrtone_snapshot_read_trigger(qrtone_snapshot_reader_t* reader, qrtone_trigger_analyzer_t* self) {
+    int32_t i;
+    if (self->sliding_dft.delay_line != NULL) {
+        self->sliding_remaining = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+        self->sliding_dft.delay_cursor = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+        qrtone_snapshot_read_floats(reader, self->sliding_dft.delay_line, self->sliding_dft.window_size);
+        qrtone_snapshot_read_floats(reader, self->sliding_dft.s1, QRTONE_SLIDING_DFT_BINS);
+        qrtone_snapshot_read_floats(reader, self->sliding_dft.s2, QRTONE_SLIDING_DFT_BINS);
+        if (self->sliding_remaining < 1 || self->sliding_remaining > self->window_analyze
+            || self->sliding_dft.delay_cursor < 0 || self->sliding_dft.delay_cursor >= self->sliding_dft.window_size) {
+            reader->failed = TRUE;
+        }
+    } else {
+        self->processed_window_alpha = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+        self->processed_window_beta = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+        qrtone_snapshot_read_floats(reader, &(self->window_energy_alpha), 1);
+        qrtone_snapshot_read_floats(reader, &(self->window_energy_beta), 1);
+#ifdef QRTONE_FIXED_POINT
+        self->window_energy_s16_alpha = (int64_t)qrtone_snapshot_read(reader, 8);
+        self->window_energy_s16_beta = (int64_t)qrtone_snapshot_read(reader, 8);
+#endif
+        for (i = 0; i < 2; i++) {
+            qrtone_snapshot_read_goertzel(reader, &(self->frequency_analyzers_alpha[i]));
+            qrtone_snapshot_read_goertzel(reader, &(self->frequency_analyzers_beta[i]));
+#ifdef QRTONE_FIXED_POINT
+            qrtone_snapshot_read_int32s(reader, &(self->fixed_analyzers_alpha[i].s1), 1);
+            qrtone_snapshot_read_int32s(reader, &(self->fixed_analyzers_alpha[i].s2), 1);
+            qrtone_snapshot_read_int32s(reader, &(self->fixed_analyzers_alpha[i].processed_samples), 1);
+            qrtone_snapshot_read_int32s(reader, &(self->fixed_analyzers_beta[i].s1), 1);
+            qrtone_snapshot_read_int32s(reader, &(self->fixed_analyzers_beta[i].s2), 1);
+            qrtone_snapshot_read_int32s(reader, &(self->fixed_analyzers_beta[i].processed_samples), 1);
+#endif
+        }
+        if (self->processed_window_alpha < 0 || self->processed_window_alpha >= self->window_analyze
+            || self->processed_window_beta < 0 || self->processed_window_beta >= self->window_analyze) {
+            reader->failed = TRUE;
+        }
+    }
+    qrtone_percentile_t* percentile = &(self->background_noise_evaluator);
+    percentile->count = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+    if (percentile->count < 0) {
+        reader->failed = TRUE;
+    }
+    qrtone_snapshot_read_floats(reader, percentile->q, percentile->marker_count);
+    qrtone_snapshot_read_floats(reader, percentile->dn, percentile->marker_count);
+    qrtone_snapshot_read_floats(reader, percentile->np, percentile->marker_count);
+    qrtone_snapshot_read_int32s(reader, percentile->n, percentile->marker_count);
+    // the P^2 interpolations divide by the differences of the marker positions
+    if (percentile->count >= percentile->marker_count) {
+        for (i = 1; i < percentile->marker_count; i++) {
+            if (percentile->n[i] <= percentile->n[i - 1]) {
+                reader->failed = TRUE;
+            }
+        }
+    }
+    int32_t id_freq;
+    for (id_freq = 0; id_freq < 2; id_freq++) {
+        qrtone_array_t* history = &(self->spl_history[id_freq]);
+        int32_t size = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+        qrtone_array_clear(history);
+        if (size < 0 || size > history->values_length) {
+            reader->failed = TRUE;
+            return;
+        }
+        for (i = 0; i < size; i++) {
+            float value;
+            qrtone_snapshot_read_floats(reader, &value, 1);
+            qrtone_array_add(history, value);
+        }
+    }
+    qrtone_peak_finder_t* peak_finder = &(self->peak_finder);
+    peak_finder->increase = (int8_t)qrtone_snapshot_read(reader, 1);
+    qrtone_snapshot_read_floats(reader, &(peak_finder->old_val), 1);
+    peak_finder->old_index = (int64_t)qrtone_snapshot_read(reader, 8);
+    peak_finder->added = (int8_t)qrtone_snapshot_read(reader, 1);
+    qrtone_snapshot_read_floats(reader, &(peak_finder->last_peak_value), 1);
+    peak_finder->last_peak_index = (int64_t)qrtone_snapshot_read(reader, 8);
+    peak_finder->increase_count = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+    peak_finder->decrease_count = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+    self->first_tone_location = (int64_t)qrtone_snapshot_read(reader, 8);
+    qrtone_snapshot_read_floats(reader, &(self->first_tone_offset), 1);
+}
+
+/**
+ * Only the written symbols are kept: those of the message being parsed and those of the last message reported by qrtone_get_symbols_quality
+ */
+int32_t qrtone_snapshot_parser_symbols(qrtone_t* self, const qrtone_parser_t* parser) {
+    int32_t symbols_length = parser->state == QRTONE_PARSING_SYMBOLS ? parser->symbol_index * 2 : 0;
+    if (parser == self->quality_parser) {
+        symbols_length = max(symbols_length, self->quality_symbols_length);
+    }
+    return symbols_length;
+}
+
+void qrtone_snapshot_write_parser(qrtone_t* self, qrtone_snapshot_writer_t* writer, const qrtone_parser_t* parser) {
+    int32_t i;
+    int32_t symbols_length = qrtone_snapshot_parser_symbols(self, parser);
+    qrtone_snapshot_write(writer, (uint8_t)parser->state, 1);
+    qrtone_snapshot_write(writer, (uint32_t)symbols_length, 4);
+    for (i = 0; i < symbols_length; i++) {
+        qrtone_snapshot_write(writer, (uint8_t)parser->symbols_cache[i], 1);
+        qrtone_snapshot_write(writer, (uint8_t)parser->symbols_runner_up[i], 1);
+        qrtone_snapshot_write(writer, parser->symbols_margin[i], 2);
+        qrtone_snapshot_write(writer, (uint16_t)parser->symbols_level[i], 2);
+        qrtone_snapshot_write(writer, (uint16_t)parser->symbols_noise[i], 2);
+    }
+    if (parser->state != QRTONE_PARSING_SYMBOLS) {
+        return;
+    }
+    qrtone_snapshot_write(writer, (uint64_t)parser->trigger_location, 8);
+    qrtone_snapshot_write(writer, (uint64_t)parser->first_tone_sample_index, 8);
+    qrtone_snapshot_write(writer, (uint64_t)parser->analyzed_samples, 8);
+    qrtone_snapshot_write(writer, (uint32_t)parser->symbol_index, 4);
+    qrtone_snapshot_write(writer, (uint32_t)parser->symbols_cache_length, 4);
+    qrtone_snapshot_write(writer, (uint32_t)parser->fixed_errors, 4);
+    qrtone_snapshot_write_floats(writer, &(parser->timing_offset), 1);
+    qrtone_snapshot_write(writer, parser->header_cache != NULL, 1);
+    if (parser->header_cache != NULL) {
+        // the other fields are derived by qrtone_header_init
+        const qrtone_header_t* header = parser->header_cache;
+        qrtone_snapshot_write(writer, header->length, 1);
+        qrtone_snapshot_write(writer, (uint8_t)header->crc, 1);
+        qrtone_snapshot_write(writer, (uint8_t)header->ecc_level, 1);
+    }
+    // Goertzel filters of the current word
+    qrtone_snapshot_write_floats(writer, parser->frequency_analyzers.s1, QRTONE_NUM_FREQUENCIES);
+    qrtone_snapshot_write_floats(writer, parser->frequency_analyzers.s2, QRTONE_NUM_FREQUENCIES);
+    qrtone_snapshot_write_floats(writer, parser->frequency_analyzers.window_cos, QRTONE_NUM_FREQUENCIES);
+    qrtone_snapshot_write_floats(writer, parser->frequency_analyzers.window_sin, QRTONE_NUM_FREQUENCIES);
+#ifdef QRTONE_FIXED_POINT
+    qrtone_snapshot_write_int32s(writer, parser->fixed_analyzers.s1, QRTONE_NUM_FREQUENCIES);
+    qrtone_snapshot_write_int32s(writer, parser->fixed_analyzers.s2, QRTONE_NUM_FREQUENCIES);
+#endif
 }
 
+void qrtone_snapshot_read_parser(qrtone_t* self, qrtone_snapshot_reader_t* reader, qrtone_parser_t* parser) {
+    const int32_t symbols_capacity = self->profile->symbols_capacity;
+    int32_t i;
+    qrtone_parser_reset(parser);
+    int8_t state = (int8_t)qrtone_snapshot_read(reader, 1);
+    int32_t symbols_length = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+    if (reader->failed || (state != QRTONE_WAITING_TRIGGER && state != QRTONE_PARSING_SYMBOLS) || symbols_length < 0 || symbols_length > symbols_capacity) {
+        reader->failed = TRUE;
+        return;
+    }
+    for (i = 0; i < symbols_length; i++) {
+        parser->symbols_cache[i] = (int8_t)qrtone_snapshot_read(reader, 1);
+        parser->symbols_runner_up[i] = (int8_t)qrtone_snapshot_read(reader, 1);
+        parser->symbols_margin[i] = (uint16_t)qrtone_snapshot_read(reader, 2);
+        parser->symbols_level[i] = (int16_t)(uint16_t)qrtone_snapshot_read(reader, 2);
+        parser->symbols_noise[i] = (int16_t)(uint16_t)qrtone_snapshot_read(reader, 2);
+    }
+    if (state != QRTONE_PARSING_SYMBOLS) {
+        return;
+    }
+    // not received symbols of the message are zero
+    memset(parser->symbols_cache + symbols_length, 0, (size_t)(symbols_capacity - symbols_length));
+    parser->trigger_location = (int64_t)qrtone_snapshot_read(reader, 8);
+    parser->first_tone_sample_index = (int64_t)qrtone_snapshot_read(reader, 8);
+    parser->analyzed_samples = (int64_t)qrtone_snapshot_read(reader, 8);
+    int32_t symbol_index = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+    int32_t symbols_cache_length = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+    parser->fixed_errors = (int32_t)(uint32_t)qrtone_snapshot_read(reader, 4);
+    qrtone_snapshot_read_floats(reader, &(parser->timing_offset), 1);
+    if (qrtone_snapshot_read(reader, 1)) {
+        uint8_t length = (uint8_t)qrtone_snapshot_read(reader, 1);
+        int8_t crc = (int8_t)qrtone_snapshot_read(reader, 1);
+        int8_t ecc_level = (int8_t)qrtone_snapshot_read(reader, 1);
+        if (crc != FALSE && crc != TRUE) {
+            reader->failed = TRUE;
+        } else if (ecc_level < QRTONE_ECC_L || ecc_level > QRTONE_ECC_H) {
+            reader->failed = TRUE;
+        } else {
+            qrtone_header_init(&(parser->header), length, ECC_SYMBOLS[ecc_level][0], ECC_SYMBOLS[ecc_level][1], crc, ecc_level);
+            parser->header_cache = &(parser->header);
+        }
+    }
+    qrtone_snapshot_read_floats(reader, parser->frequency_analyzers.s1, QRTONE_NUM_FREQUENCIES);
+    qrtone_snapshot_read_floats(reader, parser->frequency_analyzers.s2, QRTONE_NUM_FREQUENCIES);
+    qrtone_snapshot_read_floats(reader, parser->frequency_analyzers.window_cos, QRTONE_NUM_FREQUENCIES);
+    qrtone_snapshot_read_floats(reader, parser->frequency_analyzers.window_sin, QRTONE_NUM_FREQUENCIES);
+#ifdef QRTONE_FIXED_POINT
+    qrtone_snapshot_read_int32s(reader, parser->fixed_analyzers.s1, QRTONE_NUM_FREQUENCIES);
+    qrtone_snapshot_read_int32s(reader, parser->fixed_analyzers.s2, QRTONE_NUM_FREQUENCIES);
+#endif
+    if (reader->failed || symbols_cache_length > symbols_capacity || symbol_index < 0 || symbol_index * 2 > symbols_cache_length
+        || symbol_index * 2 > symbols_length || (parser->header_cache != NULL && parser->header_cache->number_of_symbols != symbols_cache_length)) {
+        reader->failed = TRUE;
+        qrtone_parser_reset(parser);
+        return;
+    }
+    parser->symbol_index = symbol_index;
+    parser->symbols_cache_length = symbols_cache_length;
+    parser->state = QRTONE_PARSING_SYMBOLS;
+}
 
+size_t qrtone_snapshot(qrtone_t* self, void* buffer, size_t buffer_size) {
+    qrtone_snapshot_writer_t writer;
+    writer.data = (uint8_t*)buffer;
+    writer.capacity = buffer != NULL ? buffer_size : 0;
+    writer.length = 0;
+    qrtone_snapshot_write(&writer, QRTONE_SNAPSHOT_MAGIC, 4);
+    qrtone_snapshot_write(&writer, QRTONE_SNAPSHOT_VERSION, 1);
+    qrtone_snapshot_write_layout(self, &writer);
+    if (self->decimation > 1) {
+        // filter history from the oldest sample
+        const int32_t taps_length = self->profile->decimator_taps_length;
+        qrtone_snapshot_write(&writer, (uint32_t)self->decimator_phase, 4);
+        qrtone_snapshot_write_floats(&writer, self->decimator_history + self->decimator_cursor, taps_length);
+#ifdef QRTONE_FIXED_POINT
+        int32_t i;
+        for (i = 0; i < taps_length; i++) {
+            qrtone_snapshot_write(&writer, (uint16_t)self->decimator_history_s16[self->decimator_cursor + i], 2);
+        }
+#endif
+    }
+    qrtone_snapshot_write_trigger(&writer, &(self->trigger_analyzer));
+    qrtone_snapshot_write(&writer, (uint64_t)self->pushed_samples, 8);
+    qrtone_snapshot_write(&writer, (uint64_t)self->parsed_samples, 8);
+    qrtone_snapshot_write(&writer, (uint64_t)self->payload_sample_index, 8);
+    qrtone_snapshot_write(&writer, (uint32_t)self->fixed_errors, 4);
+    qrtone_snapshot_write_floats(&writer, &(self->timing_offset), 1);
+    qrtone_snapshot_write(&writer, (uint32_t)(self->quality_parser - self->parsers), 4);
+    qrtone_snapshot_write(&writer, (uint32_t)self->quality_symbols_length, 4);
+    qrtone_snapshot_write(&writer, (uint32_t)self->payload_length, 4);
+    qrtone_snapshot_write(&writer, self->payload != NULL, 1);
+    if (self->payload != NULL) {
+        int32_t i;
+        for (i = 0; i < self->payload_length; i++) {
+            qrtone_snapshot_write(&writer, (uint8_t)self->payload[i], 1);
+        }
+    }
+    int32_t id_parser;
+    for (id_parser = 0; id_parser < self->parsers_length; id_parser++) {
+        qrtone_snapshot_write_parser(self, &writer, &(self->parsers[id_parser]));
+    }
+    if (writer.length + 2 <= writer.capacity) {
+        qrtone_crc16_t crc;
+        qrtone_crc16_init(&crc);
+        qrtone_crc16_add_array(&crc, (const int8_t*)buffer, (int32_t)writer.length);
+        qrtone_snapshot_write(&writer, (uint16_t)qrtone_crc16_get(&crc), 2);
+    } else {
+        writer.length += 2;
+    }
+    return writer.length;
+}
 
+int8_t qrtone_restore(qrtone_t* self, const void* snapshot, size_t snapshot_length) {
+    if (snapshot == NULL || snapshot_length < 6) {
+        return FALSE;
+    }
+    qrtone_snapshot_reader_t reader;
+    reader.data = (const uint8_t*)snapshot;
+    reader.length = snapshot_length - 2;
+    reader.cursor = 0;
+    reader.failed = FALSE;
+    if (qrtone_snapshot_read(&reader, 4) != QRTONE_SNAPSHOT_MAGIC || qrtone_snapshot_read(&reader, 1) != QRTONE_SNAPSHOT_VERSION) {
+        return FALSE;
+    }
+    qrtone_crc16_t crc;
+    qrtone_crc16_init(&crc);
+    qrtone_crc16_add_array(&crc, (const int8_t*)snapshot, (int32_t)reader.length);
+    if ((uint16_t)qrtone_crc16_get(&crc) != (reader.data[reader.length] | (reader.data[reader.length + 1] << 8))) {
+        return FALSE;
+    }
+    // The layout of the snapshot must match the configuration of this decoder
+    uint8_t layout[64];
+    qrtone_snapshot_writer_t writer;
+    writer.data = layout;
+    writer.capacity = sizeof(layout);
+    writer.length = 0;
+    qrtone_snapshot_write_layout(self, &writer);
+    if (reader.cursor + writer.length > reader.length || memcmp(reader.data + reader.cursor, layout, writer.length) != 0) {
+        return FALSE;
+    }
+    reader.cursor += writer.length;
+    // The decoder is modified from here, an inconsistent snapshot resets the receiver
+    if (self->decimation > 1) {
+        const int32_t taps_length = self->profile->decimator_taps_length;
+        self->decimator_phase = (int32_t)(uint32_t)qrtone_snapshot_read(&reader, 4);
+        self->decimator_cursor = 0;
+        qrtone_snapshot_read_floats(&reader, self->decimator_history, taps_length);
+        memcpy(self->decimator_history + taps_length, self->decimator_history, sizeof(float) * taps_length);
+#ifdef QRTONE_FIXED_POINT
+        int32_t i;
+        for (i = 0; i < taps_length; i++) {
+            self->decimator_history_s16[i] = (int16_t)(uint16_t)qrtone_snapshot_read(&reader, 2);
+        }
+        memcpy(self->decimator_history_s16 + taps_length, self->decimator_history_s16, sizeof(int16_t) * taps_length);
+#endif
+        if (self->decimator_phase < 0 || self->decimator_phase >= self->decimation) {
+            self->decimator_phase = 0;
+            reader.failed = TRUE;
+        }
+    }
+    qrtone_snapshot_read_trigger(&reader, &(self->trigger_analyzer));
+    self->pushed_samples = (int64_t)qrtone_snapshot_read(&reader, 8);
+    self->parsed_samples = (int64_t)qrtone_snapshot_read(&reader, 8);
+    self->payload_sample_index = (int64_t)qrtone_snapshot_read(&reader, 8);
+    self->fixed_errors = (int32_t)(uint32_t)qrtone_snapshot_read(&reader, 4);
+    qrtone_snapshot_read_floats(&reader, &(self->timing_offset), 1);
+    int32_t quality_parser = (int32_t)(uint32_t)qrtone_snapshot_read(&reader, 4);
+    int32_t quality_symbols_length = (int32_t)(uint32_t)qrtone_snapshot_read(&reader, 4);
+    self->payload_length = (int32_t)(uint32_t)qrtone_snapshot_read(&reader, 4);
+    self->payload = NULL;
+    if (self->payload_length < 0 || self->payload_length > QRTONE_MAX_PAYLOAD_LENGTH) {
+        reader.failed = TRUE;
+    } else if (qrtone_snapshot_read(&reader, 1)) {
+        int32_t i;
+        for (i = 0; i < self->payload_length; i++) {
+            self->payload_buffer[i] = (int8_t)qrtone_snapshot_read(&reader, 1);
+        }
+        self->payload = self->payload_buffer;
+    }
+    if (quality_parser < 0 || quality_parser >= self->parsers_length || quality_symbols_length < 0 || quality_symbols_length > self->profile->symbols_capacity) {
+        reader.failed = TRUE;
+    } else {
+        self->quality_parser = &(self->parsers[quality_parser]);
+        self->quality_symbols_length = quality_symbols_length;
+    }
+    int32_t id_parser;
+    for (id_parser = 0; id_parser < self->parsers_length; id_parser++) {
+        if (reader.failed) {
+            qrtone_parser_reset(&(self->parsers[id_parser]));
+        } else {
+            qrtone_snapshot_read_parser(self, &reader, &(self->parsers[id_parser]));
+        }
+    }
+    if (reader.failed || reader.cursor != reader.length) {
+        qrtone_trigger_analyzer_reset(&(self->trigger_analyzer));
+        self->trigger_analyzer.background_noise_evaluator.count = 0;
+        for (id_parser = 0; id_parser < self->parsers_length; id_parser++) {
+            qrtone_parser_reset(&(self->parsers[id_parser]));
+        }
+        self->quality_symbols_length = 0;
+        self->payload = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+int8_t qrtone_ring_init(qrtone_ring_t* self, float* samples, int32_t capacity) {
+    if (samples == NULL || capacity < 2 || capacity > (1 << 30) || (capacity & (capacity - 1)) != 0) {
+        return FALSE;
+    }
+    memset(self, 0, sizeof(qrtone_ring_t));
+    self->samples = samples;
+    self->capacity = (uint32_t)capacity;
+    self->mask = (uint32_t)capacity - 1;
+    return TRUE;
+}
+
+float* qrtone_ring_write_region(qrtone_ring_t* self, int32_t* length) {
+    const uint32_t write_index = self->write_index;
+    const uint32_t position = write_index & self->mask;
+    const uint32_t contiguous = self->capacity - position;
+    uint32_t free_space = self->capacity - (write_index - self->producer_read_index);
+    // The read index of the consumer is loaded again only when its last value limits the region
+    if (free_space < contiguous) {
+        self->producer_read_index = QRTONE_RING_LOAD_ACQUIRE(&(self->read_index));
+        free_space = self->capacity - (write_index - self->producer_read_index);
+    }
+    *length = (int32_t)min(free_space, contiguous);
+    return self->samples + position;
+}
+
+void qrtone_ring_commit(qrtone_ring_t* self, int32_t samples_length, int32_t dropped_samples) {
+    const uint32_t write_index = self->write_index + (uint32_t)samples_length;
+    QRTONE_RING_STORE_RELEASE(&(self->write_index), write_index);
+    if (dropped_samples > 0) {
+        QRTONE_RING_STORE(&(self->overruns), self->overruns + 1);
+        QRTONE_RING_STORE(&(self->dropped_samples), self->dropped_samples + (uint32_t)dropped_samples);
+    }
+    // The peak is only raised with a fresh read index
+    if (write_index - self->producer_read_index > self->peak_fill) {
+        self->producer_read_index = QRTONE_RING_LOAD_ACQUIRE(&(self->read_index));
+        const uint32_t fill = write_index - self->producer_read_index;
+        if (fill > self->peak_fill) {
+            QRTONE_RING_STORE(&(self->peak_fill), fill);
+        }
+    }
+}
+
+int32_t qrtone_ring_write(qrtone_ring_t* self, const float* samples, int32_t samples_length) {
+    int32_t written = 0;
+    int32_t id_region;
+    // The free space wraps at most once around the end of the buffer
+    for (id_region = 0; id_region < 2 && written < samples_length; id_region++) {
+        int32_t region_length;
+        float* region = qrtone_ring_write_region(self, &region_length);
+        region_length = min(region_length, samples_length - written);
+        memcpy(region, samples + written, sizeof(float) * (size_t)region_length);
+        qrtone_ring_commit(self, region_length, 0);
+        written += region_length;
+    }
+    if (written < samples_length) {
+        qrtone_ring_commit(self, 0, samples_length - written);
+    }
+    return written;
+}
+
+int32_t qrtone_ring_write_s16(qrtone_ring_t* self, const int16_t* samples, int32_t samples_length, int32_t stride) {
+    int32_t written = 0;
+    int32_t id_region;
+    for (id_region = 0; id_region < 2 && written < samples_length; id_region++) {
+        int32_t region_length;
+        float* region = qrtone_ring_write_region(self, &region_length);
+        region_length = min(region_length, samples_length - written);
+        const int16_t* input = samples + (size_t)written * (size_t)stride;
+        int32_t i;
+        for (i = 0; i < region_length; i++) {
+            region[i] = input[(size_t)i * (size_t)stride] / 32768.0f;
+        }
+        qrtone_ring_commit(self, region_length, 0);
+        written += region_length;
+    }
+    if (written < samples_length) {
+        qrtone_ring_commit(self, 0, samples_length - written);
+    }
+    return written;
+}
+
+float* qrtone_ring_read_region(qrtone_ring_t* self, int32_t* length) {
+    const uint32_t read_index = self->read_index;
+    const uint32_t position = read_index & self->mask;
+    const uint32_t contiguous = self->capacity - position;
+    uint32_t available = self->consumer_write_index - read_index;
+    // The write index of the producer is loaded again only when its last value limits the region
+    if (available < contiguous) {
+        self->consumer_write_index = QRTONE_RING_LOAD_ACQUIRE(&(self->write_index));
+        available = self->consumer_write_index - read_index;
+    }
+    *length = (int32_t)min(available, contiguous);
+    return self->samples + position;
+}
+
+void qrtone_ring_release(qrtone_ring_t* self, int32_t samples_length) {
+    QRTONE_RING_STORE_RELEASE(&(self->read_index), self->read_index + (uint32_t)samples_length);
+}
+
+int8_t qrtone_ring_drain(qrtone_ring_t* self, qrtone_t* qrtone) {
+    int8_t received = FALSE;
+    int32_t id_region;
+    // At most two regions, a producer writing as fast as the decoder does not hold the caller
+    for (id_region = 0; id_region < 2; id_region++) {
+        int32_t region_length;
+        float* region = qrtone_ring_read_region(self, &region_length);
+        if (region_length == 0) {
+            break;
+        }
+        if (qrtone_push_samples(qrtone, region, region_length)) {
+            received = TRUE;
+        }
+        qrtone_ring_release(self, region_length);
+    }
+    return received;
+}
+
+void qrtone_ring_get_stats(qrtone_ring_t* self, qrtone_ring_stats_t* stats) {
+    stats->available = (int32_t)(QRTONE_RING_LOAD_ACQUIRE(&(self->write_index)) - QRTONE_RING_LOAD(&(self->read_index)));
+    stats->peak_fill = (int32_t)QRTONE_RING_LOAD(&(self->peak_fill));
+    stats->overruns = QRTONE_RING_LOAD(&(self->overruns));
+    stats->dropped_samples = QRTONE_RING_LOAD(&(self->dropped_samples));
+}
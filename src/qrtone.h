@@ -40,8 +40,8 @@
  * Audio to Message:
  * 1. Declare instance of qrtone_t with qrtone_new
  * 2. Init with qrtone_init
- * 3. Get maximal expected window length with qrtone_get_maximum_length
- * 4. Push window samples with qrtone_push_samples
+ * 3. Optionally set a callback receiving each payload with qrtone_set_payload_callback
+ * 4. Push audio buffers of any size with qrtone_push_samples
  * 5. When qrtone_push_samples return 1 then retrieve payload with qrtone_get_payload and qrtone_get_payload_length
  * Message to Audio
  * 1. Declare instance of qrtone_t with qrtone_new
@@ -58,6 +58,16 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stddef.h>
+
+/**
+ * QRTONE_FIXED_POINT builds the int16 methods qrtone_push_samples_s16 and qrtone_get_samples_s16, for targets without FPU.
+ * CMake defines it with the QRTONE_FIXED_POINT option (ON by default). The Arduino IDE cannot pass compiler flags to a library,
+ * so Arduino builds enable it here unless QRTONE_NO_FIXED_POINT is defined.
+ */
+#if defined(ARDUINO) && !defined(QRTONE_FIXED_POINT) && !defined(QRTONE_NO_FIXED_POINT)
+#define QRTONE_FIXED_POINT
+#endif
 
 /**
  * Error correction level parameter
@@ -68,11 +78,26 @@ extern "C" {
  */
 enum QRTONE_ECC_LEVEL { QRTONE_ECC_L = 0, QRTONE_ECC_M = 1, QRTONE_ECC_Q = 2, QRTONE_ECC_H = 3};
 
+/**
+ * Maximum number of bytes of a payload (the length is stored on one byte in the header), size of the buffers given to qrtone_set_payload_buffer
+ */
+#define QRTONE_MAX_PAYLOAD_LENGTH 255
+
+/**
+ * Version of the format written by qrtone_snapshot, a snapshot of another version is rejected by qrtone_restore
+ */
+#define QRTONE_SNAPSHOT_VERSION 5
+
 /**
  * @brief Main QRTone structure
  */
 typedef struct _qrtone_t qrtone_t;
 
+/**
+ * @brief Constant parameters of a sample rate, shared by qrtone_t instances
+ */
+typedef struct _qrtone_profile_t qrtone_profile_t;
+
 ///////////////////////
 // INITIALIZATION
 ///////////////////////
@@ -96,26 +121,217 @@ void qrtone_init(qrtone_t* qrtone, float sample_rate);
  */
 void qrtone_free(qrtone_t* qrtone);
 
+/**
+ * @brief Custom memory allocator
+ */
+typedef struct _qrtone_allocator_t {
+    void* (*malloc_fn)(void* ptr, size_t size); /**< Allocate size bytes aligned for any type. Return NULL on failure */
+    void (*free_fn)(void* ptr, void* memory);   /**< Release memory returned by malloc_fn */
+    void* ptr;                                  /**< User data provided to malloc_fn and free_fn */
+} qrtone_allocator_t;
+
+/**
+ * Initialization of the internal attributes of a qrtone_t instance using a custom allocator. Must only be called once.
+ * @param qrtone A pointer to the qrtone structure.
+ * @param sample_rate Sample rate in Hz.
+ * @param allocator Allocator used for all internal buffers. It is copied. NULL to use malloc.
+ * @return 1 on success, 0 if an allocation failed. qrtone_free must be called in both cases.
+ */
+int8_t qrtone_init_allocator(qrtone_t* qrtone, float sample_rate, const qrtone_allocator_t* allocator);
+
+/**
+ * @brief Modulation parameters. The sender and the receiver must use the same configuration.
+ */
+typedef struct _qrtone_config_t {
+    float sample_rate;          /**< Sample rate in Hz */
+    float first_frequency;      /**< Frequency of the lowest tone in Hz */
+    float frequency_increment;  /**< If not 0, tones are linearly spaced by this step in Hz and frequency_multiplier is ignored */
+    float frequency_multiplier; /**< Ratio between two consecutive tone frequencies */
+    float word_time;            /**< Duration of a tone in seconds */
+    float word_silence_time;    /**< Silence between two tones in seconds */
+    float gate_time;            /**< Duration of each of the two gate tones in seconds */
+    float trigger_snr;          /**< Minimum signal to noise ratio of the gate tones in dB */
+    float trigger_hop_ratio;    /**< 0 to analyze the gate tones with two Goertzel passes at 50% overlap. Otherwise the gate levels are computed
+                                     by a sliding DFT every trigger_hop_ratio x gate window length (1/16 to 1/2), at a constant cost per sample.
+                                     The sliding DFT runs in float, the int16 samples of qrtone_push_samples_s16 are converted: on a target
+                                     without FPU prefer the Goertzel passes, which have a fixed point path */
+    float trigger_idle_level;   /**< Receiver only. 0 to analyze every gate window. Otherwise a level in dB (negative, as given to the level callback):
+                                     the Goertzel passes skip the samples of a gate window while their energy is below this level, the
+                                     levels of an idle window are the levels of white noise of the same energy. Set it far below the expected
+                                     tone level, the skipped samples are analyzed as silence. Not used by the sliding DFT */
+    float erasure_margin;       /**< When a message cannot be decoded, symbols whose tone exceeds the second highest tone by less than
+                                     this margin in dB are decoded again as erasures. 0 to disable */
+    int32_t soft_decision_budget; /**< When a payload with crc still cannot be decoded, maximum number of decoding attempts with the least reliable
+                                       symbols replaced by their second highest tone, most likely substitutions first. 0 to disable */
+    int32_t parsers;            /**< Maximum number of messages parsed at the same time (1 to 8). The gate tones found while a message is parsed
+                                     start another parser, a false trigger does not hide a message starting during its header */
+    int32_t decimation;         /**< Receiver only. 1 to analyze the samples at sample_rate. Otherwise the samples are band limited by a polyphase
+                                     FIR and analyzed at sample_rate / decimation (2 to 8), 0 to use the largest factor that keeps the band of the
+                                     tones. The int16 samples of qrtone_push_samples_s16 are filtered in fixed point. Sample indices are
+                                     still given at sample_rate */
+} qrtone_config_t;
+
+/**
+ * Default configuration, used by qrtone_init. Audible tones from 1720 Hz, about 50 bit/s.
+ * @param config A pointer to the configuration structure.
+ * @param sample_rate Sample rate in Hz.
+ */
+void qrtone_config_audible(qrtone_config_t* config, float sample_rate);
+
+/**
+ * Same tones as qrtone_config_audible with shorter words, silences and gates, about 100 bit/s.
+ * Shorter words reduce the frequency resolution, use it for quiet short range links.
+ * @param config A pointer to the configuration structure.
+ * @param sample_rate Sample rate in Hz.
+ */
+void qrtone_config_fast(qrtone_config_t* config, float sample_rate);
+
+/**
+ * Near-ultrasonic tones from 18200 Hz to 19750 Hz with a linear 50 Hz step, same rate as qrtone_config_audible.
+ * Requires a sample rate of at least 44100 Hz. The playback and recording devices must not filter this band.
+ * @param config A pointer to the configuration structure.
+ * @param sample_rate Sample rate in Hz.
+ */
+void qrtone_config_inaudible(qrtone_config_t* config, float sample_rate);
+
+/**
+ * Check that the tones are below the Nyquist frequency and that words and gates are long enough to be analyzed.
+ * @param config A pointer to the configuration structure.
+ * @return 1 if the configuration can be used, 0 otherwise.
+ */
+int8_t qrtone_config_check(const qrtone_config_t* config);
+
+/**
+ * Initialization of the internal attributes of a qrtone_t instance with a custom configuration. Must only be called once.
+ * @param qrtone A pointer to the qrtone structure.
+ * @param config Modulation parameters, they are copied.
+ * @param allocator Allocator used for all internal buffers. It is copied. NULL to use malloc.
+ * @return 1 on success, 0 if the configuration is not valid or if an allocation failed. qrtone_free must be called in both cases.
+ */
+int8_t qrtone_init_config(qrtone_t* qrtone, const qrtone_config_t* config, const qrtone_allocator_t* allocator);
+
+/**
+ * Number of bytes required by qrtone_init_arena for the provided sample rate.
+ * @param sample_rate Sample rate in Hz.
+ * @return Arena size in bytes
+ */
+size_t qrtone_required_memory(float sample_rate);
+
+/**
+ * Create and initialize a qrtone_t instance in a caller-owned memory block. The instance does not use the heap.
+ * Arena instances are receive only, qrtone_set_payload returns 0.
+ * Call qrtone_free before releasing the arena, do not free the returned pointer.
+ * @param arena Memory block aligned for any type (ex: returned by malloc)
+ * @param arena_size Size of the memory block, should be at least qrtone_required_memory(sample_rate)
+ * @param sample_rate Sample rate in Hz.
+ * @return A pointer to the qrtone structure located in the arena or NULL if the arena is too small.
+ */
+qrtone_t* qrtone_init_arena(void* arena, size_t arena_size, float sample_rate);
+
+/**
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @return Number of bytes currently allocated by this instance, allocator bookkeeping included
+ */
+size_t qrtone_get_memory_usage(qrtone_t* qrtone);
+
+/**
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @return Highest number of bytes allocated at the same time by this instance, allocator bookkeeping included
+ */
+size_t qrtone_get_memory_peak(qrtone_t* qrtone);
+
+/**
+ * Allocation memory for a qrtone_profile_t instance.
+ * @return A pointer to the profile structure.
+ */
+qrtone_profile_t* qrtone_profile_new(void);
+
+/**
+ * Compute the frequencies, filter coefficients and Reed-Solomon generators of a sample rate. Must only be called once.
+ * The profile is read only once initialized, it can be shared by qrtone_t instances running in different threads.
+ * @param profile A pointer to the profile structure.
+ * @param sample_rate Sample rate in Hz.
+ * @return 1 on success, 0 if an allocation failed. qrtone_profile_free must be called in both cases.
+ */
+int8_t qrtone_profile_init(qrtone_profile_t* profile, float sample_rate);
+
+/**
+ * Compute the constant parameters of a custom configuration. Must only be called once.
+ * @param profile A pointer to the profile structure.
+ * @param config Modulation parameters, they are copied.
+ * @return 1 on success, 0 if the configuration is not valid or if an allocation failed. qrtone_profile_free must be called in both cases.
+ */
+int8_t qrtone_profile_init_config(qrtone_profile_t* profile, const qrtone_config_t* config);
+
+/**
+ * Free allocated memory for a qrtone_profile_t instance. All qrtone_t instances using it must be freed before.
+ * @param profile A pointer to the initialized profile structure.
+ */
+void qrtone_profile_free(qrtone_profile_t* profile);
+
+/**
+ * Initialization of a qrtone_t instance using a shared profile. Only the stream state is allocated. Must only be called once.
+ * @param qrtone A pointer to the qrtone structure.
+ * @param profile Initialized profile, must remain valid until qrtone_free.
+ * @param allocator Allocator used for all internal buffers. It is copied. NULL to use malloc.
+ * @return 1 on success, 0 if an allocation failed. qrtone_free must be called in both cases.
+ */
+int8_t qrtone_init_profile(qrtone_t* qrtone, const qrtone_profile_t* profile, const qrtone_allocator_t* allocator);
+
+/**
+ * Number of bytes required by qrtone_init_arena_profile for the provided profile.
+ * @param profile Initialized profile
+ * @return Arena size in bytes
+ */
+size_t qrtone_required_memory_profile(const qrtone_profile_t* profile);
+
+/**
+ * Create and initialize a qrtone_t instance using a shared profile in a caller-owned memory block.
+ * Same restrictions as qrtone_init_arena.
+ * @param arena Memory block aligned for any type (ex: returned by malloc)
+ * @param arena_size Size of the memory block, should be at least qrtone_required_memory_profile(profile)
+ * @param profile Initialized profile, must remain valid until qrtone_free.
+ * @return A pointer to the qrtone structure located in the arena or NULL if the arena is too small.
+ */
+qrtone_t* qrtone_init_arena_profile(void* arena, size_t arena_size, const qrtone_profile_t* profile);
+
 ////////////////////////
 // Receive payload
 ////////////////////////
 
 /**
- * Compute the maximum samples_length to feed with the method `qrtone_push_samples`
+ * Compute the samples_length that ends the current analysis window of `qrtone_push_samples`. Pushes can be of any size, shorter
+ * pushes only reduce the latency of the decoding.
  * @param qrtone A pointer to the initialized qrtone structure.
- * @return The maximum samples_length to feed with the method `qrtone_push_samples`
+ * @return The samples_length that ends the current analysis window
  */
 int32_t qrtone_get_maximum_length(qrtone_t* qrtone);
 
 /**
  * Process audio samples in order to find payload in tones.
+ * The gate tones are looked for in all samples, also while a message is parsed and after its end, so messages can be sent back to back.
+ * The samples are analyzed in windows, the received messages do not depend on the size of the pushes.
  * @param qrtone A pointer to the initialized qrtone structure.
  * @param samples Audio samples array in float. All tests have been done with values between -1 and 1.
- * @param samples_length Size Audio samples array. The size should be inferior or equal to `qrtone_get_maximum_length`.
- * @return 1 if a payload has been received, 0 otherwise.
+ * @param samples_length Size Audio samples array, any size.
+ * @return 1 if a payload has been received, 0 otherwise. When several payloads are received only the last one is returned by
+ * `qrtone_get_payload`, all of them are given to the callback set by `qrtone_set_payload_callback`.
  */
 int8_t qrtone_push_samples(qrtone_t* qrtone, float* samples, int32_t samples_length);
 
+#ifdef QRTONE_FIXED_POINT
+/**
+ * Process int16 audio samples in order to find payload in tones. Filters and symbol decisions use integer arithmetic only,
+ * for targets without FPU. Do not mix with `qrtone_push_samples` on the same instance.
+ * Available when the library is built with QRTONE_FIXED_POINT defined.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @param samples Audio samples array, 32767 is full scale.
+ * @param samples_length Size Audio samples array, any size.
+ * @return 1 if a payload has been received, 0 otherwise, see `qrtone_push_samples`.
+ */
+int8_t qrtone_push_samples_s16(qrtone_t* qrtone, const int16_t* samples, int32_t samples_length);
+#endif
+
 /**
  * Fetch stored payload. Call this function only when `qrtone_push_samples` return 1.
  * @param qrtone A pointer to the initialized qrtone structure.
@@ -138,6 +354,13 @@ int32_t qrtone_get_payload_length(qrtone_t* qrtone);
  */
 int64_t qrtone_get_payload_sample_index(qrtone_t* self);
 
+/**
+ * Number of audio samples of one gate tone. A message starts with two gate tones.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @return Gate length in samples
+ */
+int32_t qrtone_get_gate_length(qrtone_t* qrtone);
+
 /**
  * When there is not enough signal/noise ratio, some bytes could be error corrected by Reed-Solomon code.
  * @param qrtone A pointer to the initialized qrtone structure.
@@ -147,7 +370,50 @@ int64_t qrtone_get_payload_sample_index(qrtone_t* self);
 int32_t qrtone_get_fixed_errors(qrtone_t* qrtone);
 
 /**
- * Function callback called while awaiting a message. It can be usefull in order to display if the microphone is working.
+ * @brief Reception quality of a symbol
+ */
+typedef struct _qrtone_symbol_quality_t {
+    float level;            /**< Level of the decoded tone in dBFS */
+    float runner_up_level;  /**< Level of the second highest tone of the same half of the frequencies in dBFS */
+    float noise_level;      /**< Mean level of the 14 other tones of the same half of the frequencies in dBFS */
+    float margin;           /**< level - runner_up_level in dB, symbols with a low margin are the most likely errors */
+} qrtone_symbol_quality_t;
+
+/**
+ * @brief Reception quality of the last message
+ */
+typedef struct _qrtone_link_quality_t {
+    int32_t symbols_length; /**< Number of analyzed symbols, 0 if no message has been received */
+    int32_t fixed_errors;   /**< Same as qrtone_get_fixed_errors */
+    float level;            /**< Mean level of the decoded tones in dBFS */
+    float noise_level;      /**< Mean noise level of the symbols in dBFS */
+    float snr;              /**< Mean signal to noise ratio of the symbols in dB */
+    float mean_margin;      /**< Mean margin of the symbols in dB */
+    float min_margin;       /**< Lowest margin of the symbols in dB */
+    float timing_offset;    /**< Offset in samples of the interpolated gate peak from the location used to align the words */
+} qrtone_link_quality_t;
+
+/**
+ * Copy the reception quality of each symbol of the last message, decoded or not. These are the payload symbols, or the header symbols
+ * if the header could not be decoded. Quality levels are stored on decoding, this call does not allocate memory.
+ * The values are available until the symbols of the next message are analyzed, read them when `qrtone_push_samples` returns 1.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @param symbols Array receiving the quality of the first symbols_length symbols
+ * @param symbols_length Length of symbols
+ * @return Number of copied symbols
+ */
+int32_t qrtone_get_symbols_quality(qrtone_t* qrtone, qrtone_symbol_quality_t* symbols, int32_t symbols_length);
+
+/**
+ * Aggregate the reception quality of the symbols of the last message, see qrtone_get_symbols_quality.
+ * Use it to choose the ecc level and the emission power, or to monitor a link without recording audio.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @param quality Structure receiving the quality of the link
+ */
+void qrtone_get_link_quality(qrtone_t* qrtone, qrtone_link_quality_t* quality);
+
+/**
+ * Function callback called for each level of the gate frequencies, also while a message is parsed. It can be usefull in order to display if the microphone is working.
  * @ptr Pointer provided when calling qrtone_tone_set_level_callback.
  * @processed_samples Number of processed samples
  * @global_level Leq of signal. Expressed in dBFS (https://en.wikipedia.org/wiki/DBFS)
@@ -157,13 +423,202 @@ int32_t qrtone_get_fixed_errors(qrtone_t* qrtone);
 typedef void (*qrtone_level_callback_t)(void *ptr, int64_t processed_samples, float first_tone_level, float second_tone_level, int32_t triggered);
 
 /**
- * @brief Set callback method called while awaiting a message.
+ * @brief Set callback method called for each level of the gate frequencies.
  * 
  * @param qrtone A pointer to the initialized qrtone structure.
  * @param data ptr to use when calling the callback method
  * @param lvl_callback Pointer to the method to call
  */
 void qrtone_set_level_callback(qrtone_t* self, void* data, qrtone_level_callback_t lvl_callback);
+
+/**
+ * Message received by `qrtone_push_samples`
+ */
+typedef struct _qrtone_message_t {
+    int8_t* payload;        /**< Payload bytes, in the buffer set by `qrtone_set_payload_buffer`. Only valid during the callback unless this buffer is replaced */
+    int32_t payload_length; /**< Number of bytes of payload */
+    int64_t sample_index;   /**< Index of the audio sample of the beginning of the message, see `qrtone_get_payload_sample_index` */
+    qrtone_link_quality_t quality; /**< Fixed errors and confidence of the symbols of the message, see `qrtone_get_link_quality` */
+} qrtone_message_t;
+
+/**
+ * Function callback called for each payload received, a push of many samples can receive several payloads.
+ * Messages can be delivered by the callback only, without checking the value returned by `qrtone_push_samples`.
+ * @ptr Pointer provided when calling qrtone_set_payload_callback.
+ * @message Received message, the getters of the last message can also be used while the callback runs.
+ */
+typedef void (*qrtone_payload_callback_t)(void* ptr, const qrtone_message_t* message);
+
+/**
+ * @brief Set callback method called for each received payload.
+ *
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @param data ptr to use when calling the callback method
+ * @param payload_callback Pointer to the method to call, NULL to only use the return value of `qrtone_push_samples`
+ */
+void qrtone_set_payload_callback(qrtone_t* self, void* data, qrtone_payload_callback_t payload_callback);
+
+/**
+ * @brief Set the buffer receiving the next decoded payloads.
+ * Called from the payload callback with a new buffer, the receiver takes the ownership of message->payload without copying it:
+ * the decoder no longer writes into the previous buffer.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @param payload_buffer Buffer of QRTONE_MAX_PAYLOAD_LENGTH bytes owned by the caller, valid until it is replaced or qrtone_free is called.
+ * NULL to use the internal buffer of qrtone.
+ */
+void qrtone_set_payload_buffer(qrtone_t* self, int8_t* payload_buffer);
+
+///////////////////////////
+// Decoder state snapshot
+///////////////////////////
+
+/**
+ * @brief Write the state of the receiver into a buffer, without allocating memory.
+ * The snapshot holds the decimation filter, the trigger analyzer (levels history, background noise percentile, peak finder, filters),
+ * the messages being parsed and the last received message. A stream can then be moved to another decoder, on the same or
+ * another host, without losing a message in flight and without the warm-up of the background noise evaluation.
+ * Callbacks, payload buffer and the state of the emitter are not part of the snapshot.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @param buffer Buffer receiving the snapshot, NULL to only compute the snapshot length.
+ * @param buffer_size Size of buffer in bytes.
+ * @return Length of the snapshot in bytes. The snapshot is complete only if it is not greater than buffer_size.
+ */
+size_t qrtone_snapshot(qrtone_t* qrtone, void* buffer, size_t buffer_size);
+
+/**
+ * @brief Restore a state written by qrtone_snapshot.
+ * The decoder must have been initialized with the same configuration and sample rate as the decoder of the snapshot.
+ * The next pushed samples must follow the samples pushed before the snapshot.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @param snapshot Snapshot written by qrtone_snapshot.
+ * @param snapshot_length Length of the snapshot returned by qrtone_snapshot.
+ * @return 1 if the state has been restored. 0 if the version, the configuration or the checksum do not match, the decoder is then unchanged.
+ * A snapshot with a valid checksum but an inconsistent content also returns 0 and resets the receiver.
+ */
+int8_t qrtone_restore(qrtone_t* qrtone, const void* snapshot, size_t snapshot_length);
+
+///////////////////////////
+// Audio capture ring
+///////////////////////////
+
+#ifndef QRTONE_CACHE_LINE_SIZE
+/**
+ * Distance in bytes between the fields written by the producer and the fields written by the consumer of a qrtone_ring_t.
+ * Define a smaller value (at least 1) on targets without data cache to save memory, with the same value for the library and its users.
+ */
+#define QRTONE_CACHE_LINE_SIZE 64
+#endif
+
+/**
+ * @brief Single producer, single consumer ring of float samples, without lock and without allocation.
+ * Hands the samples of an audio capture callback (interrupt or real-time thread) to the thread running the decoder.
+ * The producer never waits: samples that do not fit are dropped and counted. The indices are free running 32 bits counters.
+ * The fields are private, use the qrtone_ring_ functions. Loads and stores of the indices use acquire and release ordering
+ * with GCC and Clang, other compilers use volatile accesses that are only ordered on a single core target.
+ */
+typedef struct _qrtone_ring_t {
+    float* samples;
+    uint32_t capacity;
+    uint32_t mask;
+    char shared_padding[QRTONE_CACHE_LINE_SIZE];
+    // Written by the producer
+    uint32_t write_index;
+    uint32_t producer_read_index;
+    uint32_t overruns;
+    uint32_t dropped_samples;
+    uint32_t peak_fill;
+    char producer_padding[QRTONE_CACHE_LINE_SIZE];
+    // Written by the consumer
+    uint32_t read_index;
+    uint32_t consumer_write_index;
+    char consumer_padding[QRTONE_CACHE_LINE_SIZE];
+} qrtone_ring_t;
+
+/**
+ * @brief Counters of a ring
+ */
+typedef struct _qrtone_ring_stats_t {
+    int32_t available;                 /**< Samples waiting to be read */
+    int32_t peak_fill;                 /**< Largest number of samples waiting in the ring after a write, to size the ring */
+    uint32_t overruns;                 /**< Writes that did not fit entirely in the ring */
+    uint32_t dropped_samples;          /**< Samples dropped by these writes, wraps around after 2^32 samples */
+} qrtone_ring_stats_t;
+
+/**
+ * Initialize an empty ring on a caller provided buffer. Must not be called while the ring is used.
+ * @param ring A pointer to the ring structure.
+ * @param samples Buffer of capacity floats, valid as long as the ring is used.
+ * @param capacity Number of samples of the buffer, a power of two from 2 to 2^30.
+ * @return 1 if the ring is initialized, 0 if capacity is not a power of two.
+ */
+int8_t qrtone_ring_init(qrtone_ring_t* ring, float* samples, int32_t capacity);
+
+/**
+ * Copy samples into the ring. Producer side: call from the capture callback only.
+ * @param ring A pointer to the initialized ring.
+ * @param samples Audio samples, 1.0 is full scale.
+ * @param samples_length Number of samples.
+ * @return Number of copied samples. The samples that did not fit are dropped and counted as an overrun.
+ */
+int32_t qrtone_ring_write(qrtone_ring_t* ring, const float* samples, int32_t samples_length);
+
+/**
+ * Convert int16 samples into the ring. Producer side.
+ * @see qrtone_ring_write
+ * @param samples Interleaved audio frames, 32767 is full scale.
+ * @param samples_length Number of samples to write.
+ * @param stride Distance in int16 between two samples, 1 for mono input, the channel count to take one channel of interleaved input.
+ */
+int32_t qrtone_ring_write_s16(qrtone_ring_t* ring, const int16_t* samples, int32_t samples_length, int32_t stride);
+
+/**
+ * Get the free space that follows the written samples, without wrapping, for a zero-copy write (conversion or DMA).
+ * Producer side. Fill the region then call qrtone_ring_commit.
+ * @param ring A pointer to the initialized ring.
+ * @param length Receives the number of samples of the region, 0 if the ring is full.
+ * @return First sample of the region.
+ */
+float* qrtone_ring_write_region(qrtone_ring_t* ring, int32_t* length);
+
+/**
+ * Publish samples written into the region returned by qrtone_ring_write_region. Producer side.
+ * @param ring A pointer to the initialized ring.
+ * @param samples_length Number of written samples, not greater than the region length.
+ * @param dropped_samples Number of samples the producer could not write, counted as an overrun if not 0.
+ */
+void qrtone_ring_commit(qrtone_ring_t* ring, int32_t samples_length, int32_t dropped_samples);
+
+/**
+ * Get the oldest samples of the ring that are contiguous in the buffer. Consumer side: call from the decoding thread only.
+ * The samples can be given to qrtone_push_samples without copy, then call qrtone_ring_release.
+ * @param ring A pointer to the initialized ring.
+ * @param length Receives the number of samples of the region, 0 if the ring is empty. When the samples wrap around the end of
+ * the buffer, the remaining samples are in the next region.
+ * @return First sample of the region.
+ */
+float* qrtone_ring_read_region(qrtone_ring_t* ring, int32_t* length);
+
+/**
+ * Give the space of read samples back to the producer. Consumer side.
+ * @param ring A pointer to the initialized ring.
+ * @param samples_length Number of read samples, not greater than the region length.
+ */
+void qrtone_ring_release(qrtone_ring_t* ring, int32_t samples_length);
+
+/**
+ * Push all the samples waiting in the ring into a decoder, without copy, then release them. Consumer side.
+ * @param ring A pointer to the initialized ring.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @return 1 if a payload has been received, see `qrtone_push_samples`.
+ */
+int8_t qrtone_ring_drain(qrtone_ring_t* ring, qrtone_t* qrtone);
+
+/**
+ * Read the counters of the ring. Consumer side, or any thread when the ring is not written.
+ * @param ring A pointer to the initialized ring.
+ * @param stats Receives the counters.
+ */
+void qrtone_ring_get_stats(qrtone_ring_t* ring, qrtone_ring_stats_t* stats);
 ///////////////////////////
 // Send payload
 ///////////////////////////
@@ -173,10 +628,20 @@ void qrtone_set_level_callback(qrtone_t* self, void* data, qrtone_level_callback
  * @param qrtone A pointer to the initialized qrtone structure.
  * @param payload Byte array to send.
  * @param payload Byte array length. Should be less than 255 bytes.
- * @return The number of audio samples to send.
+ * @return The number of audio samples to send, 0 if the message could not be set, see qrtone_set_payload_ext.
  */
 int32_t qrtone_set_payload(qrtone_t* qrtone, int8_t* payload, uint8_t payload_length);
 
+/**
+ * Compute the number of audio samples of a message, without encoding it.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @param payload_length Byte array length.
+ * @param ecc_level Error correction level `QRTONE_ECC_LEVEL`.
+ * @param add_crc 1 if a crc16 code is appended to the payload.
+ * @return The number of audio samples of the message, 0 if ecc_level is not valid.
+ */
+int32_t qrtone_get_message_length(qrtone_t* qrtone, uint8_t payload_length, int8_t ecc_level, int8_t add_crc);
+
 /**
  * Set the message to send, with additional parameters.
  * @param qrtone A pointer to the initialized qrtone structure.
@@ -184,7 +649,8 @@ int32_t qrtone_set_payload(qrtone_t* qrtone, int8_t* payload, uint8_t payload_le
  * @param payload Byte array length. Should be less than 255 bytes.
  * @param ecc_level Error correction level `QRTONE_ECC_LEVEL`. Error correction level add robustness at the cost of tone length.
  * @param add_crc If 1 ,add a crc16 code in order to check if the message has not been altered on the receiver side.
- * @return The number of audio samples to send.
+ * @return The number of audio samples to send, 0 if the message could not be set (invalid ecc_level, arena initialized
+ * decoder or allocation failure).
  */
 int32_t qrtone_set_payload_ext(qrtone_t* qrtone, int8_t* payload, uint8_t payload_length, int8_t ecc_level, int8_t add_crc);
 
@@ -197,6 +663,20 @@ int32_t qrtone_set_payload_ext(qrtone_t* qrtone, int8_t* payload, uint8_t payloa
  */
 void qrtone_get_samples(qrtone_t* qrtone, float* samples, int32_t samples_length, float power);
 
+#ifdef QRTONE_FIXED_POINT
+/**
+ * Integer version of `qrtone_get_samples`, tones and windows are generated with phase accumulators and Q15 tables.
+ * Samples are within 16 LSB of the exact waveform, `qrtone_get_samples` scaled to int16 differs by at most 2.5% of power
+ * because of its float recurrences. Use only one of the two methods for a message.
+ * Available when the library is built with QRTONE_FIXED_POINT defined.
+ * @param qrtone A pointer to the initialized qrtone structure.
+ * @param samples Pre-allocated array of samples_length length. Tones are added to the array values, with saturation.
+ * @param samples_length array length. samples_length + offset should be equal or inferior than the total number of audio samples.
+ * @param power Peak amplitude of the audio tones, 32767 is full scale.
+ */
+void qrtone_get_samples_s16(qrtone_t* qrtone, int16_t* samples, int32_t samples_length, int16_t power);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,6 +42,18 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Vector instructions used by the GF(16) batch decoder. Define QRTONE_NO_SIMD to force the scalar code path.
+#if !defined(QRTONE_NO_SIMD) && (defined(__SSSE3__) || defined(__AVX2__))
+#include <tmmintrin.h>
+#define ECC_SIMD_SSSE3
+#elif !defined(QRTONE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define ECC_SIMD_SSE2
+#elif !defined(QRTONE_NO_SIMD) && defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define ECC_SIMD_NEON
+#endif
+
 // @link https://github.com/zxing/zxing/tree/master/core/src/main/java/com/google/zxing/common/reedsolomon
 
 
@@ -55,8 +67,24 @@
  * Reference algorithm is the ZXing QR-Code Apache License source code.
  */
 
+void* ecc_malloc(const ecc_allocator_t* allocator, size_t size) {
+    if (allocator == NULL) {
+        return malloc(size);
+    }
+    return allocator->malloc_fn(allocator->ptr, size);
+}
+
+void ecc_free(const ecc_allocator_t* allocator, void* memory) {
+    if (allocator == NULL) {
+        free(memory);
+    } else if (memory != NULL) {
+        allocator->free_fn(allocator->ptr, memory);
+    }
+}
+
 void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t* other) {
-    self->coefficients = malloc(sizeof(int32_t) * other->coefficients_length);
+    self->allocator = other->allocator;
+    self->coefficients = ecc_malloc(self->allocator, sizeof(int32_t) * other->coefficients_length);
     memcpy(self->coefficients, other->coefficients, other->coefficients_length * sizeof(int32_t));
     self->coefficients_length = other->coefficients_length;
 }
@@ -67,7 +95,8 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
  * @author Sean Owen (java version)
  * @author David Olivier (java version)
  */
- void ecc_generic_gf_poly_init(ecc_generic_gf_poly_t* self, int32_t* coefficients, int32_t coefficients_length) {
+ void ecc_generic_gf_poly_init_allocator(ecc_generic_gf_poly_t* self, int32_t* coefficients, int32_t coefficients_length, const ecc_allocator_t* allocator) {
+    self->allocator = allocator;
     if (coefficients_length == 0) {
       return;
     }
@@ -78,39 +107,43 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
         firstNonZero++;
       }
       if (firstNonZero == coefficients_length) {
-          self->coefficients = malloc(sizeof(int32_t) * 1);
+          self->coefficients = ecc_malloc(allocator, sizeof(int32_t) * 1);
           self->coefficients_length = 1;
           self->coefficients[0] = 0;
       } else {
         self->coefficients_length = coefficients_length - firstNonZero;
-        self->coefficients = malloc(sizeof(int32_t) * self->coefficients_length);
+        self->coefficients = ecc_malloc(allocator, sizeof(int32_t) * self->coefficients_length);
         memcpy(self->coefficients, coefficients + firstNonZero, sizeof(int32_t) * self->coefficients_length);
       }
     } else {
-        self->coefficients = malloc(sizeof(int32_t) * coefficients_length);
+        self->coefficients = ecc_malloc(allocator, sizeof(int32_t) * coefficients_length);
         self->coefficients_length = coefficients_length;
         memcpy(self->coefficients, coefficients, sizeof(int32_t) * coefficients_length);
     }	 
  }
 
+ void ecc_generic_gf_poly_init(ecc_generic_gf_poly_t* self, int32_t* coefficients, int32_t coefficients_length) {
+     ecc_generic_gf_poly_init_allocator(self, coefficients, coefficients_length, NULL);
+ }
+
  int32_t ecc_generic_gf_poly_multiply_by_monomial(ecc_generic_gf_poly_t* self, ecc_generic_gf_t* field, int32_t degree, int32_t coefficient, ecc_generic_gf_poly_t* result) {
      if (degree < 0) {
          return ECC_ILLEGAL_ARGUMENT;
      }
      if (coefficient == 0) {
          int32_t zero[1] = { 0 };
-         ecc_generic_gf_poly_init(result, zero, 1);
+         ecc_generic_gf_poly_init_allocator(result, zero, 1, self->allocator);
          return ECC_NO_ERRORS;
      }
      int32_t product_length = self->coefficients_length + degree;
-     int32_t* product = malloc(sizeof(int32_t) * product_length);
+     int32_t* product = ecc_malloc(self->allocator, sizeof(int32_t) * product_length);
      memset(product, 0, sizeof(int32_t) * product_length);
      int32_t i;
      for (i = 0; i < self->coefficients_length; i++) {
          product[i] = ecc_generic_gf_multiply(field, self->coefficients[i], coefficient);
      }
-     ecc_generic_gf_poly_init(result, product, product_length);
-     free(product);
+     ecc_generic_gf_poly_init_allocator(result, product, product_length, self->allocator);
+     ecc_free(self->allocator, product);
      return ECC_NO_ERRORS;
  }
 
@@ -145,15 +178,19 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
  }
 
  void ecc_generic_gf_poly_free(ecc_generic_gf_poly_t* self) {
-     free(self->coefficients);
+     ecc_free(self->allocator, self->coefficients);
  }
 
- void ecc_generic_gf_init(ecc_generic_gf_t* self, int32_t primitive, int32_t size, int32_t b) {
+ void ecc_generic_gf_init_allocator(ecc_generic_gf_t* self, int32_t primitive, int32_t size, int32_t b, const ecc_allocator_t* allocator) {
+     self->allocator = allocator;
      self->primitive = primitive;
      self->size = size;
      self->generator_base = b;
-     self->exp_table = malloc(sizeof(int32_t) * size);
-     self->log_table = malloc(sizeof(int32_t) * size);
+     self->exp_table = ecc_malloc(allocator, sizeof(int32_t) * size);
+     self->log_table = ecc_malloc(allocator, sizeof(int32_t) * size);
+     if (self->exp_table == NULL || self->log_table == NULL) {
+         return;
+     }
      memset(self->log_table, 0, sizeof(int32_t) * size);
      int32_t x = 1;
      int32_t i;
@@ -170,39 +207,47 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
      }
      // logTable[0] == 0 but self should never be used
      int32_t zero[1] = { 0 };
-     ecc_generic_gf_poly_init(&(self->zero), zero, 1);
+     ecc_generic_gf_poly_init_allocator(&(self->zero), zero, 1, allocator);
      int32_t one[1] = { 1 };
-     ecc_generic_gf_poly_init(&(self->one), one, 1);
+     ecc_generic_gf_poly_init_allocator(&(self->one), one, 1, allocator);
+ }
+
+ void ecc_generic_gf_init(ecc_generic_gf_t* self, int32_t primitive, int32_t size, int32_t b) {
+     ecc_generic_gf_init_allocator(self, primitive, size, b, NULL);
  }
 
  void ecc_generic_gf_free(ecc_generic_gf_t* self) {
-     free(self->exp_table);
-     free(self->log_table);
+     ecc_free(self->allocator, self->exp_table);
+     ecc_free(self->allocator, self->log_table);
      ecc_generic_gf_poly_free(&(self->zero));
      ecc_generic_gf_poly_free(&(self->one));
  }
 
- int32_t ecc_generic_gf_build_monomial(ecc_generic_gf_poly_t* poly, int32_t degree, int32_t coefficient) {
+ int32_t ecc_generic_gf_build_monomial_allocator(ecc_generic_gf_poly_t* poly, int32_t degree, int32_t coefficient, const ecc_allocator_t* allocator) {
      if (degree < 0) {
          return ECC_ILLEGAL_ARGUMENT;
      }
      if (coefficient == 0) {
          int32_t zero[1] = { 0 };
-         ecc_generic_gf_poly_init(poly, zero, 1);
+         ecc_generic_gf_poly_init_allocator(poly, zero, 1, allocator);
          return ECC_NO_ERRORS;
      }
-     int32_t* coefficients = malloc(sizeof(int32_t) * ((size_t)degree + 1));
+     int32_t* coefficients = ecc_malloc(allocator, sizeof(int32_t) * ((size_t)degree + 1));
      memset(coefficients, 0, sizeof(int32_t) * ((size_t)degree + 1));
      coefficients[0] = coefficient;
-     ecc_generic_gf_poly_init(poly, coefficients, degree + 1);
-     free(coefficients);
+     ecc_generic_gf_poly_init_allocator(poly, coefficients, degree + 1, allocator);
+     ecc_free(allocator, coefficients);
      return ECC_NO_ERRORS;
  }
 
+ int32_t ecc_generic_gf_build_monomial(ecc_generic_gf_poly_t* poly, int32_t degree, int32_t coefficient) {
+     return ecc_generic_gf_build_monomial_allocator(poly, degree, coefficient, NULL);
+ }
+
  void ecc_generic_gf_poly_multiply(ecc_generic_gf_poly_t* self, ecc_generic_gf_t* field, int32_t scalar, ecc_generic_gf_poly_t* result) {
      if (scalar == 0) {
          int32_t zero[1] = { 0 };
-         ecc_generic_gf_poly_init(result, zero, 1);
+         ecc_generic_gf_poly_init_allocator(result, zero, 1, self->allocator);
          return;
      }
      if (scalar == 1) {
@@ -210,12 +255,12 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
          return;
      }
      int32_t i;
-     int32_t* product = malloc(sizeof(int32_t) * self->coefficients_length);
+     int32_t* product = ecc_malloc(self->allocator, sizeof(int32_t) * self->coefficients_length);
      for (i = 0; i < self->coefficients_length; i++) {
          product[i] = ecc_generic_gf_multiply(field, self->coefficients[i], scalar);
      }
-     ecc_generic_gf_poly_init(result, product, self->coefficients_length);
-     free(product);
+     ecc_generic_gf_poly_init_allocator(result, product, self->coefficients_length, self->allocator);
+     ecc_free(self->allocator, product);
  }
 
  int32_t ecc_generic_gf_multiply(ecc_generic_gf_t* self, int32_t a, int32_t b) {
@@ -258,7 +303,7 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
          larger_coefficients_length = self->coefficients_length;
      }
 
-     int32_t* sum_diff = malloc(sizeof(int32_t) * larger_coefficients_length);
+     int32_t* sum_diff = ecc_malloc(self->allocator, sizeof(int32_t) * larger_coefficients_length);
      memset(sum_diff, 0, sizeof(int32_t) * larger_coefficients_length);
      int32_t length_diff = larger_coefficients_length - smaller_coefficients_length;
 
@@ -270,8 +315,8 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
          sum_diff[i] = ecc_generic_gf_add_or_substract(smaller_coefficients[i - length_diff], larger_coefficients[i]);
      }
 
-     ecc_generic_gf_poly_init(result, sum_diff, larger_coefficients_length);
-     free(sum_diff);
+     ecc_generic_gf_poly_init_allocator(result, sum_diff, larger_coefficients_length, self->allocator);
+     ecc_free(self->allocator, sum_diff);
  }
 
  int32_t ecc_generic_gf_poly_is_zero(ecc_generic_gf_poly_t* self) {
@@ -281,11 +326,11 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
  void ecc_generic_gf_poly_multiply_other(ecc_generic_gf_poly_t* self, ecc_generic_gf_t* field, ecc_generic_gf_poly_t* other, ecc_generic_gf_poly_t* result) {
     if (ecc_generic_gf_poly_is_zero(self) || ecc_generic_gf_poly_is_zero(other)) {
         int32_t zero[1] = { 0 };
-        ecc_generic_gf_poly_init(result, zero, 1);
+        ecc_generic_gf_poly_init_allocator(result, zero, 1, self->allocator);
         return;
     }
     int32_t product_length = self->coefficients_length + other->coefficients_length - 1;
-    int32_t* product = malloc(sizeof(int32_t) * product_length);
+    int32_t* product = ecc_malloc(self->allocator, sizeof(int32_t) * product_length);
     memset(product, 0, sizeof(int32_t) * product_length);
     int32_t i;
     int32_t j;
@@ -294,8 +339,8 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
             product[i + j] = ecc_generic_gf_add_or_substract(product[i + j], ecc_generic_gf_multiply(field, self->coefficients[i], other->coefficients[j]));
         }
     }
-    ecc_generic_gf_poly_init(result, product, product_length);
-    free(product);
+    ecc_generic_gf_poly_init_allocator(result, product, product_length, self->allocator);
+    ecc_free(self->allocator, product);
  }
 
  int32_t ecc_generic_gf_inverse(ecc_generic_gf_t* self, int32_t a) {
@@ -326,22 +371,24 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
 
  void ecc_reed_solomon_encoder_add(ecc_reed_solomon_encoder_t* self, ecc_generic_gf_poly_t* el) {
      ecc_reed_solomon_cached_generator_t* last = self->cached_generators;
-     self->cached_generators = malloc(sizeof(ecc_reed_solomon_cached_generator_t));
+     self->cached_generators = ecc_malloc(self->field.allocator, sizeof(ecc_reed_solomon_cached_generator_t));
      self->cached_generators->index = last->index + 1;
      self->cached_generators->value = el;
      self->cached_generators->previous = last;
  }
 
  void ecc_reed_solomon_encoder_free(ecc_reed_solomon_encoder_t* self) {
-     ecc_generic_gf_free(&(self->field));
      ecc_reed_solomon_cached_generator_t* previous = self->cached_generators;
      while (previous != NULL) {
-         ecc_generic_gf_poly_free(previous->value);
-         free(previous->value);
+         if (previous->value != NULL) {
+             ecc_generic_gf_poly_free(previous->value);
+             ecc_free(self->field.allocator, previous->value);
+         }
          ecc_reed_solomon_cached_generator_t* to_free = previous;
          previous = previous->previous;
-         free(to_free);
+         ecc_free(self->field.allocator, to_free);
      }
+     ecc_generic_gf_free(&(self->field));
  }
 
  ecc_generic_gf_poly_t* ecc_reed_solomon_encoder_get(ecc_reed_solomon_encoder_t* self, int32_t index) {
@@ -356,14 +403,23 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
      return NULL;
  }
 
- void ecc_reed_solomon_encoder_init(ecc_reed_solomon_encoder_t* self, int32_t primitive, int32_t size, int32_t b) {
-     ecc_generic_gf_init(&(self->field), primitive, size, b);
-     self->cached_generators = malloc(sizeof(ecc_reed_solomon_cached_generator_t));
+ void ecc_reed_solomon_encoder_init_allocator(ecc_reed_solomon_encoder_t* self, int32_t primitive, int32_t size, int32_t b, const ecc_allocator_t* allocator) {
+     ecc_generic_gf_init_allocator(&(self->field), primitive, size, b, allocator);
+     self->cached_generators = ecc_malloc(allocator, sizeof(ecc_reed_solomon_cached_generator_t));
+     if (self->cached_generators == NULL) {
+         return;
+     }
      self->cached_generators->index = 0;
      self->cached_generators->previous = NULL;
      int32_t one[1] = { 1 };
-     self->cached_generators->value = malloc(sizeof(ecc_generic_gf_poly_t));
-     ecc_generic_gf_poly_init(self->cached_generators->value, one, 1);
+     self->cached_generators->value = ecc_malloc(allocator, sizeof(ecc_generic_gf_poly_t));
+     if (self->cached_generators->value != NULL) {
+         ecc_generic_gf_poly_init_allocator(self->cached_generators->value, one, 1, allocator);
+     }
+ }
+
+ void ecc_reed_solomon_encoder_init(ecc_reed_solomon_encoder_t* self, int32_t primitive, int32_t size, int32_t b) {
+     ecc_reed_solomon_encoder_init_allocator(self, primitive, size, b, NULL);
  }
 
  ecc_generic_gf_poly_t* ecc_reed_solomon_encoder_build_generator(ecc_reed_solomon_encoder_t* self, int32_t degree) {
@@ -371,13 +427,12 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
         ecc_generic_gf_poly_t* last_generator = self->cached_generators->value;
         int32_t d;
         for (d = self->cached_generators->index + 1; d <= degree; d++) {
-            ecc_generic_gf_poly_t* next_generator = malloc(sizeof(ecc_generic_gf_poly_t));
+            ecc_generic_gf_poly_t* next_generator = ecc_malloc(self->field.allocator, sizeof(ecc_generic_gf_poly_t));
             ecc_generic_gf_poly_t gen;
-            int32_t* data = malloc(sizeof(int32_t) * 2);
+            int32_t data[2];
             data[0] = 1;
             data[1] = self->field.exp_table[d - 1 + self->field.generator_base];
-            ecc_generic_gf_poly_init(&gen, data, 2);
-            free(data);
+            ecc_generic_gf_poly_init_allocator(&gen, data, 2, self->field.allocator);
             ecc_generic_gf_poly_multiply_other(last_generator, &(self->field), &gen, next_generator);
             ecc_generic_gf_poly_free(&gen);
             ecc_reed_solomon_encoder_add(self, next_generator);
@@ -388,13 +443,15 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
  }
 
  void ecc_reed_solomon_encoder_encode(ecc_reed_solomon_encoder_t* self, int32_t* to_encode, int32_t to_encode_length, int32_t ec_bytes) {
+     if (self->field.size == 16 && self->field.primitive == ECC_GF16_PRIMITIVE && to_encode_length <= ECC_GF16_MAX_LENGTH) {
+         // table driven, the cached generators are not used
+         ecc_reed_solomon_gf16_encode(self->field.generator_base, to_encode, to_encode_length, ec_bytes);
+         return;
+     }
      int32_t data_bytes = to_encode_length - ec_bytes;
      ecc_generic_gf_poly_t* generator = ecc_reed_solomon_encoder_build_generator(self, ec_bytes);
-     int32_t* info_coefficients = malloc(sizeof(int32_t) * data_bytes);
-     memcpy(info_coefficients, to_encode, data_bytes * sizeof(int32_t));
      ecc_generic_gf_poly_t info;
-     ecc_generic_gf_poly_init(&info, info_coefficients, data_bytes);
-     free(info_coefficients);
+     ecc_generic_gf_poly_init_allocator(&info, to_encode, data_bytes, self->field.allocator);
      ecc_generic_gf_poly_t monomial_result;
      ecc_generic_gf_poly_multiply_by_monomial(&info,&(self->field), ec_bytes, 1, &monomial_result);
      ecc_generic_gf_poly_free(&info);
@@ -461,7 +518,7 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
                  int32_t degree_diff = ecc_generic_gf_poly_get_degree(&r) - ecc_generic_gf_poly_get_degree(&r_last);
                  int32_t scale = ecc_generic_gf_multiply(field, ecc_generic_gf_poly_get_coefficient(&r, ecc_generic_gf_poly_get_degree(&r)), dlt_inverse);
                  ecc_generic_gf_poly_t other;
-                 ecc_generic_gf_build_monomial(&other, degree_diff, scale);
+                 ecc_generic_gf_build_monomial_allocator(&other, degree_diff, scale, field->allocator);
                  ecc_generic_gf_poly_t new_value;
                  ecc_generic_gf_poly_add_or_substract(&q, &other, &new_value);
                  ecc_generic_gf_poly_free(&other);
@@ -545,18 +602,584 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
              }
          }
          result[i] = ecc_generic_gf_multiply(field, ecc_generic_gf_poly_evaluate_at(error_locator, field, xi_inverse), ecc_generic_gf_inverse(field, denominator));
-         if (field->generator_base != 0) {
+         // Codes of generator base b scale the magnitudes by X^-b
+         for (j = 0; j < field->generator_base; j++) {
              result[i] = ecc_generic_gf_multiply(field, result[i], xi_inverse);
          }
      }
  }
 
+ /**
+  * Polynomial stored in a fixed size array, used by the decoder to avoid heap allocations
+  * coefficients are arranged from the x^0 term to the x^degree term
+  */
+ typedef struct _ecc_bounded_poly_t {
+     int32_t coefficients[ECC_BOUNDED_MAX_EC_BYTES + 1];
+     int32_t degree;
+ } ecc_bounded_poly_t;
+
+ void ecc_bounded_poly_set_monomial(ecc_bounded_poly_t* self, int32_t degree, int32_t coefficient) {
+     memset(self->coefficients, 0, sizeof(self->coefficients));
+     self->coefficients[degree] = coefficient;
+     self->degree = coefficient == 0 ? 0 : degree;
+ }
+
+ int32_t ecc_bounded_poly_is_zero(ecc_bounded_poly_t* self) {
+     return self->degree == 0 && self->coefficients[0] == 0;
+ }
+
+ void ecc_bounded_poly_normalize(ecc_bounded_poly_t* self) {
+     while (self->degree > 0 && self->coefficients[self->degree] == 0) {
+         self->degree--;
+     }
+ }
+
+ int32_t ecc_bounded_poly_evaluate_at(ecc_bounded_poly_t* self, ecc_generic_gf_t* field, int32_t a) {
+     int32_t result = 0;
+     int32_t i;
+     for (i = self->degree; i >= 0; i--) {
+         result = ecc_generic_gf_add_or_substract(ecc_generic_gf_multiply(field, a, result), self->coefficients[i]);
+     }
+     return result;
+ }
+
+ /**
+  * self = self + other * scale * x^degree
+  */
+ void ecc_bounded_poly_add_scaled_monomial(ecc_bounded_poly_t* self, ecc_bounded_poly_t* other, ecc_generic_gf_t* field, int32_t degree, int32_t scale) {
+     int32_t i;
+     for (i = 0; i <= other->degree; i++) {
+         self->coefficients[i + degree] ^= ecc_generic_gf_multiply(field, other->coefficients[i], scale);
+     }
+     if (other->degree + degree > self->degree) {
+         self->degree = other->degree + degree;
+     }
+     ecc_bounded_poly_normalize(self);
+ }
+
+ void ecc_bounded_poly_multiply(ecc_bounded_poly_t* self, ecc_generic_gf_t* field, int32_t scalar) {
+     int32_t i;
+     for (i = 0; i <= self->degree; i++) {
+         self->coefficients[i] = ecc_generic_gf_multiply(field, self->coefficients[i], scalar);
+     }
+     ecc_bounded_poly_normalize(self);
+ }
+
+ int32_t ecc_reed_solomon_decoder_run_bounded_euclidean_algorithm(ecc_generic_gf_t* field, ecc_bounded_poly_t* syndrome, int32_t r_degree,
+     ecc_bounded_poly_t* sigma, ecc_bounded_poly_t* omega) {
+     ecc_bounded_poly_t r_last;
+     ecc_bounded_poly_t r;
+     ecc_bounded_poly_t t_last;
+     ecc_bounded_poly_t t;
+     ecc_bounded_poly_t r_last_last;
+     ecc_bounded_poly_t t_last_last;
+     ecc_bounded_poly_t q;
+     // syndrome degree is always lower than R
+     ecc_bounded_poly_set_monomial(&r_last, r_degree, 1);
+     r = *syndrome;
+     ecc_bounded_poly_set_monomial(&t_last, 0, 0);
+     ecc_bounded_poly_set_monomial(&t, 0, 1);
+
+     // Run Euclidean algorithm until r's degree is less than R/2
+     while (r.degree >= r_degree / 2) {
+         r_last_last = r_last;
+         t_last_last = t_last;
+         r_last = r;
+         t_last = t;
+         if (ecc_bounded_poly_is_zero(&r_last)) {
+             // Oops, Euclidean algorithm already terminated?
+             return ECC_REED_SOLOMON_ERROR;
+         }
+         r = r_last_last;
+         ecc_bounded_poly_set_monomial(&q, 0, 0);
+         int32_t dlt_inverse = ecc_generic_gf_inverse(field, r_last.coefficients[r_last.degree]);
+         while (r.degree >= r_last.degree && !ecc_bounded_poly_is_zero(&r)) {
+             int32_t degree_diff = r.degree - r_last.degree;
+             int32_t scale = ecc_generic_gf_multiply(field, r.coefficients[r.degree], dlt_inverse);
+             q.coefficients[degree_diff] ^= scale;
+             q.degree = degree_diff > q.degree ? degree_diff : q.degree;
+             ecc_bounded_poly_add_scaled_monomial(&r, &r_last, field, degree_diff, scale);
+         }
+         if (q.degree + t_last.degree > r_degree) {
+             return ECC_ILLEGAL_STATE_EXCEPTION;
+         }
+         // t = q * t_last + t_last_last
+         t = t_last_last;
+         int32_t i;
+         for (i = 0; i <= q.degree; i++) {
+             if (q.coefficients[i] != 0) {
+                 ecc_bounded_poly_add_scaled_monomial(&t, &t_last, field, i, q.coefficients[i]);
+             }
+         }
+         if (r.degree >= r_last.degree) {
+             // Division algorithm failed to reduce polynomial?
+             return ECC_ILLEGAL_STATE_EXCEPTION;
+         }
+     }
+     int32_t sigma_tilde_at_zero = t.coefficients[0];
+     if (sigma_tilde_at_zero == 0) {
+         return ECC_REED_SOLOMON_ERROR;
+     }
+     int32_t inverse = ecc_generic_gf_inverse(field, sigma_tilde_at_zero);
+     *sigma = t;
+     ecc_bounded_poly_multiply(sigma, field, inverse);
+     *omega = r;
+     ecc_bounded_poly_multiply(omega, field, inverse);
+     return ECC_NO_ERRORS;
+ }
+
+ int32_t ecc_reed_solomon_decoder_decode_bounded(ecc_generic_gf_t* field, int32_t* to_decode, int32_t to_decode_length, int32_t ec_bytes, int32_t* fixedErrors) {
+     ecc_bounded_poly_t syndrome;
+     ecc_bounded_poly_set_monomial(&syndrome, 0, 0);
+     int32_t no_error = 1;
+     int32_t i;
+     int32_t j;
+     for (i = 0; i < ec_bytes; i++) {
+         // Evaluate received polynomial at alpha^(i+b)
+         int32_t a = field->exp_table[i + field->generator_base];
+         int32_t eval = 0;
+         for (j = 0; j < to_decode_length; j++) {
+             eval = ecc_generic_gf_add_or_substract(ecc_generic_gf_multiply(field, a, eval), to_decode[j]);
+         }
+         syndrome.coefficients[i] = eval;
+         if (eval != 0) {
+             no_error = 0;
+         }
+     }
+     if (no_error) {
+         return ECC_NO_ERRORS;
+     }
+     syndrome.degree = ec_bytes - 1;
+     ecc_bounded_poly_normalize(&syndrome);
+     ecc_bounded_poly_t sigma;
+     ecc_bounded_poly_t omega;
+     int32_t ret = ecc_reed_solomon_decoder_run_bounded_euclidean_algorithm(field, &syndrome, ec_bytes, &sigma, &omega);
+     if (ret != ECC_NO_ERRORS) {
+         return ret;
+     }
+     // Find error locations (Chien search)
+     int32_t number_of_errors = sigma.degree;
+     int32_t error_locations[ECC_BOUNDED_MAX_EC_BYTES];
+     if (number_of_errors == 1) {
+         error_locations[0] = sigma.coefficients[1];
+     } else {
+         int32_t e = 0;
+         for (i = 1; i < field->size && e < number_of_errors; i++) {
+             if (ecc_bounded_poly_evaluate_at(&sigma, field, i) == 0) {
+                 error_locations[e++] = ecc_generic_gf_inverse(field, i);
+             }
+         }
+         if (e != number_of_errors) {
+             return ECC_REED_SOLOMON_ERROR;
+         }
+     }
+     // Find error magnitudes (Forney) and fix symbols
+     int32_t error_magnitudes[ECC_BOUNDED_MAX_EC_BYTES];
+     for (i = 0; i < number_of_errors; i++) {
+         int32_t position = to_decode_length - 1 - field->log_table[error_locations[i]];
+         if (position < 0) {
+             return ECC_REED_SOLOMON_ERROR; // Bad error location
+         }
+         int32_t xi_inverse = ecc_generic_gf_inverse(field, error_locations[i]);
+         int32_t denominator = 1;
+         for (j = 0; j < number_of_errors; j++) {
+             if (i != j) {
+                 denominator = ecc_generic_gf_multiply(field, denominator,
+                     ecc_generic_gf_add_or_substract(1, ecc_generic_gf_multiply(field, error_locations[j], xi_inverse)));
+             }
+         }
+         error_magnitudes[i] = ecc_generic_gf_multiply(field, ecc_bounded_poly_evaluate_at(&omega, field, xi_inverse), ecc_generic_gf_inverse(field, denominator));
+         // Codes of generator base b scale the magnitudes by X^-b
+         for (j = 0; j < field->generator_base; j++) {
+             error_magnitudes[i] = ecc_generic_gf_multiply(field, error_magnitudes[i], xi_inverse);
+         }
+     }
+     for (i = 0; i < number_of_errors; i++) {
+         int32_t position = to_decode_length - 1 - field->log_table[error_locations[i]];
+         to_decode[position] = ecc_generic_gf_add_or_substract(to_decode[position], error_magnitudes[i]);
+     }
+     if (fixedErrors != NULL) {
+         *fixedErrors += number_of_errors;
+     }
+     return ECC_NO_ERRORS;
+ }
+
+ /**
+  * GF(16) tables of the x^4 + x + 1 (0x13) primitive polynomial
+  * exp table is doubled so that exp[log[a] + log[b]] does not need a modulo
+  */
+ static const uint8_t ecc_gf16_exp[30] = { 1, 2, 4, 8, 3, 6, 12, 11, 5, 10, 7, 14, 15, 13, 9,
+     1, 2, 4, 8, 3, 6, 12, 11, 5, 10, 7, 14, 15, 13, 9 };
+
+ static const uint8_t ecc_gf16_log[16] = { 0, 0, 1, 4, 2, 8, 5, 10, 3, 14, 9, 7, 6, 13, 11, 12 };
+
+ static const uint8_t ecc_gf16_inverse[16] = { 0, 1, 9, 14, 13, 11, 7, 6, 15, 2, 12, 5, 10, 4, 3, 8 };
+
+ static const uint8_t ecc_gf16_mul[16][16] = {
+     { 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+     { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+     { 0,  2,  4,  6,  8, 10, 12, 14,  3,  1,  7,  5, 11,  9, 15, 13},
+     { 0,  3,  6,  5, 12, 15, 10,  9, 11,  8, 13, 14,  7,  4,  1,  2},
+     { 0,  4,  8, 12,  3,  7, 11, 15,  6,  2, 14, 10,  5,  1, 13,  9},
+     { 0,  5, 10, 15,  7,  2, 13,  8, 14, 11,  4,  1,  9, 12,  3,  6},
+     { 0,  6, 12, 10, 11, 13,  7,  1,  5,  3,  9, 15, 14,  8,  2,  4},
+     { 0,  7, 14,  9, 15,  8,  1,  6, 13, 10,  3,  4,  2,  5, 12, 11},
+     { 0,  8,  3, 11,  6, 14,  5, 13, 12,  4, 15,  7, 10,  2,  9,  1},
+     { 0,  9,  1,  8,  2, 11,  3, 10,  4, 13,  5, 12,  6, 15,  7, 14},
+     { 0, 10,  7, 13, 14,  4,  9,  3, 15,  5,  8,  2,  1, 11,  6, 12},
+     { 0, 11,  5, 14, 10,  1, 15,  4,  7, 12,  2,  9, 13,  6,  8,  3},
+     { 0, 12, 11,  7,  5,  9, 14,  2, 10,  6,  1, 13, 15,  3,  4,  8},
+     { 0, 13,  9,  4,  1, 12,  8,  5,  2, 15, 11,  6,  3, 14, 10,  7},
+     { 0, 14, 15,  1, 13,  3,  2, 12,  9,  7,  6,  8,  4, 10, 11,  5},
+     { 0, 15, 13,  2,  9,  6,  4, 11,  1, 14, 12,  3,  8,  7,  5, 10}
+ };
+
+ /**
+  * Generators of the QRTone codes (generator base 1) with 2, 4 and 6 parity symbols
+  * coefficients from x^(ec_bytes-1) to x^0, the leading x^ec_bytes term is 1
+  */
+ static const uint8_t ecc_gf16_generator_2[2] = { 6, 8 };
+ static const uint8_t ecc_gf16_generator_4[4] = { 13, 12, 8, 7 };
+ static const uint8_t ecc_gf16_generator_6[6] = { 7, 9, 3, 12, 10, 12 };
+
+ int32_t ecc_reed_solomon_gf16_encode(int32_t generator_base, int32_t* to_encode, int32_t to_encode_length, int32_t ec_bytes) {
+     if (to_encode_length > ECC_GF16_MAX_LENGTH || ec_bytes <= 0 || ec_bytes > to_encode_length) {
+         return ECC_ILLEGAL_ARGUMENT;
+     }
+     uint8_t built_generator[ECC_GF16_MAX_LENGTH + 1];
+     const uint8_t* generator;
+     int32_t i;
+     int32_t d;
+     if (generator_base == 1 && ec_bytes == 2) {
+         generator = ecc_gf16_generator_2;
+     } else if (generator_base == 1 && ec_bytes == 4) {
+         generator = ecc_gf16_generator_4;
+     } else if (generator_base == 1 && ec_bytes == 6) {
+         generator = ecc_gf16_generator_6;
+     } else {
+         // product of (x + alpha^(d+b)), built_generator[0] is the leading term
+         memset(built_generator, 0, sizeof(built_generator));
+         built_generator[0] = 1;
+         for (d = 0; d < ec_bytes; d++) {
+             const uint8_t* mul_root = ecc_gf16_mul[ecc_gf16_exp[(d + generator_base) % 15]];
+             for (i = d + 1; i >= 1; i--) {
+                 built_generator[i] ^= mul_root[built_generator[i - 1]];
+             }
+         }
+         generator = built_generator + 1;
+     }
+     // Division by the generator with a linear feedback shift register, parity[0] is the highest degree
+     uint8_t parity[ECC_GF16_MAX_LENGTH] = { 0 };
+     int32_t data_bytes = to_encode_length - ec_bytes;
+     for (d = 0; d < data_bytes; d++) {
+         const uint8_t* mul_feedback = ecc_gf16_mul[((uint8_t)to_encode[d] ^ parity[0]) & 0x0F];
+         for (i = 0; i < ec_bytes - 1; i++) {
+             parity[i] = parity[i + 1] ^ mul_feedback[generator[i]];
+         }
+         parity[ec_bytes - 1] = mul_feedback[generator[ec_bytes - 1]];
+     }
+     for (i = 0; i < ec_bytes; i++) {
+         to_encode[data_bytes + i] = parity[i];
+     }
+     return ECC_NO_ERRORS;
+ }
+
+ /**
+  * Berlekamp-Massey, Chien search and Forney from the syndromes of a block with at least one non-zero syndrome
+  * @param erasures Index of the symbols known to be unreliable, or NULL
+  * @param error_positions Index of the erroneous symbols in the block
+  * @param error_magnitudes Value to add to the erroneous symbols
+  * @return number of errors and erasures, -ECC_REED_SOLOMON_ERROR if the block can't be fixed
+  */
+ static int32_t ecc_gf16_find_errors(int32_t generator_base, const uint8_t* syndromes, int32_t to_decode_length, int32_t ec_bytes,
+     const int32_t* erasures, int32_t erasures_length, int32_t* error_positions, uint8_t* error_magnitudes) {
+     int32_t i;
+     int32_t j;
+     // Berlekamp-Massey initialized with the erasure locator, lambda is the error and erasure locator with lambda[0] = 1
+     uint8_t lambda[ECC_GF16_MAX_LENGTH + 1] = { 1 };
+     uint8_t previous[ECC_GF16_MAX_LENGTH + 1];
+     uint8_t temp[ECC_GF16_MAX_LENGTH + 1];
+     for (j = 0; j < erasures_length; j++) {
+         // multiply by (1 + X x), X = alpha^(length - 1 - position)
+         const uint8_t* mul_location = ecc_gf16_mul[ecc_gf16_exp[to_decode_length - 1 - erasures[j]]];
+         for (i = j + 1; i >= 1; i--) {
+             lambda[i] ^= mul_location[lambda[i - 1]];
+         }
+     }
+     memcpy(previous, lambda, sizeof(previous));
+     int32_t number_of_errors = erasures_length;
+     int32_t shift = 1;
+     uint8_t previous_discrepancy = 1;
+     int32_t n;
+     for (n = erasures_length; n < ec_bytes; n++) {
+         uint8_t discrepancy = 0;
+         for (i = 0; i <= n; i++) {
+             discrepancy ^= ecc_gf16_mul[lambda[i]][syndromes[n - i]];
+         }
+         if (discrepancy == 0) {
+             shift++;
+             continue;
+         }
+         const uint8_t* mul_scale = ecc_gf16_mul[ecc_gf16_mul[discrepancy][ecc_gf16_inverse[previous_discrepancy]]];
+         if (2 * number_of_errors <= n + erasures_length) {
+             memcpy(temp, lambda, sizeof(lambda));
+             for (i = 0; i + shift <= ec_bytes; i++) {
+                 lambda[i + shift] ^= mul_scale[previous[i]];
+             }
+             number_of_errors = n + 1 + erasures_length - number_of_errors;
+             memcpy(previous, temp, sizeof(previous));
+             previous_discrepancy = discrepancy;
+             shift = 1;
+         } else {
+             for (i = 0; i + shift <= ec_bytes; i++) {
+                 lambda[i + shift] ^= mul_scale[previous[i]];
+             }
+             shift++;
+         }
+     }
+     // each error costs two parity symbols, each erasure one
+     if (2 * number_of_errors - erasures_length > ec_bytes) {
+         return -ECC_REED_SOLOMON_ERROR;
+     }
+     for (i = number_of_errors + 1; i <= ec_bytes; i++) {
+         if (lambda[i] != 0) {
+             return -ECC_REED_SOLOMON_ERROR;
+         }
+     }
+     // Chien search, symbol j has the location alpha^(length - 1 - j)
+     uint8_t error_locations_inverse[ECC_GF16_MAX_LENGTH];
+     int32_t e = 0;
+     int32_t power;
+     for (power = 0; power < to_decode_length && e < number_of_errors; power++) {
+         uint8_t x_inverse = ecc_gf16_exp[(15 - power) % 15];
+         uint8_t eval = 0;
+         for (i = number_of_errors; i >= 0; i--) {
+             eval = ecc_gf16_mul[x_inverse][eval] ^ lambda[i];
+         }
+         if (eval == 0) {
+             error_positions[e] = to_decode_length - 1 - power;
+             error_locations_inverse[e] = x_inverse;
+             e++;
+         }
+     }
+     if (e != number_of_errors) {
+         return -ECC_REED_SOLOMON_ERROR;
+     }
+     // omega = syndromes * lambda mod x^ec_bytes
+     uint8_t omega[ECC_GF16_MAX_LENGTH];
+     for (i = 0; i < ec_bytes; i++) {
+         uint8_t sum = 0;
+         for (j = 0; j <= i && j <= number_of_errors; j++) {
+             sum ^= ecc_gf16_mul[lambda[j]][syndromes[i - j]];
+         }
+         omega[i] = sum;
+     }
+     // Forney, magnitude = x^(1-b) * omega(x^-1) / lambda'(x^-1)
+     for (e = 0; e < number_of_errors; e++) {
+         const uint8_t* mul_x_inverse = ecc_gf16_mul[error_locations_inverse[e]];
+         uint8_t omega_eval = 0;
+         for (i = ec_bytes - 1; i >= 0; i--) {
+             omega_eval = mul_x_inverse[omega_eval] ^ omega[i];
+         }
+         // formal derivative keeps the odd terms only
+         uint8_t x_inverse_squared = mul_x_inverse[error_locations_inverse[e]];
+         uint8_t derivative_eval = 0;
+         for (i = number_of_errors - (number_of_errors % 2 == 0 ? 1 : 0); i >= 1; i -= 2) {
+             derivative_eval = ecc_gf16_mul[x_inverse_squared][derivative_eval] ^ lambda[i];
+         }
+         if (derivative_eval == 0) {
+             return -ECC_REED_SOLOMON_ERROR;
+         }
+         uint8_t magnitude = ecc_gf16_mul[omega_eval][ecc_gf16_inverse[derivative_eval]];
+         // x^(1-b) = (x^-1)^(b-1)
+         int32_t x_inverse_log = ecc_gf16_log[error_locations_inverse[e]];
+         error_magnitudes[e] = ecc_gf16_mul[magnitude][ecc_gf16_exp[(x_inverse_log * ((generator_base + 14) % 15)) % 15]];
+     }
+     return number_of_errors;
+ }
+
+ int32_t ecc_reed_solomon_gf16_decode_erasures(int32_t generator_base, int32_t* to_decode, int32_t to_decode_length, int32_t ec_bytes, const int32_t* erasures, int32_t erasures_length, int32_t* fixedErrors) {
+     if (to_decode_length > ECC_GF16_MAX_LENGTH || ec_bytes < 0 || ec_bytes > to_decode_length || erasures_length < 0 || erasures_length > ec_bytes) {
+         return ECC_ILLEGAL_ARGUMENT;
+     }
+     int32_t i;
+     int32_t j;
+     for (i = 0; i < erasures_length; i++) {
+         if (erasures[i] < 0 || erasures[i] >= to_decode_length) {
+             return ECC_ILLEGAL_ARGUMENT;
+         }
+     }
+     uint8_t syndromes[ECC_GF16_MAX_LENGTH];
+     uint8_t no_error = 1;
+     for (i = 0; i < ec_bytes; i++) {
+         // Evaluate received polynomial at alpha^(i+b)
+         const uint8_t* mul_a = ecc_gf16_mul[ecc_gf16_exp[(i + generator_base) % 15]];
+         uint8_t eval = 0;
+         for (j = 0; j < to_decode_length; j++) {
+             eval = mul_a[eval] ^ (uint8_t)to_decode[j];
+         }
+         syndromes[i] = eval;
+         no_error &= eval == 0;
+     }
+     if (no_error) {
+         return ECC_NO_ERRORS;
+     }
+     int32_t error_positions[ECC_GF16_MAX_LENGTH];
+     uint8_t error_magnitudes[ECC_GF16_MAX_LENGTH];
+     int32_t number_of_errors = ecc_gf16_find_errors(generator_base, syndromes, to_decode_length, ec_bytes, erasures, erasures_length, error_positions, error_magnitudes);
+     if (number_of_errors < 0) {
+         return -number_of_errors;
+     }
+     int32_t fixed = 0;
+     for (i = 0; i < number_of_errors; i++) {
+         // an erased symbol may be right
+         to_decode[error_positions[i]] ^= error_magnitudes[i];
+         fixed += error_magnitudes[i] != 0;
+     }
+     if (fixedErrors != NULL) {
+         *fixedErrors += fixed;
+     }
+     return ECC_NO_ERRORS;
+ }
+
+ int32_t ecc_reed_solomon_gf16_decode(int32_t generator_base, int32_t* to_decode, int32_t to_decode_length, int32_t ec_bytes, int32_t* fixedErrors) {
+     return ecc_reed_solomon_gf16_decode_erasures(generator_base, to_decode, to_decode_length, ec_bytes, NULL, 0, fixedErrors);
+ }
+
+ /**
+  * Compute the syndromes of ECC_GF16_BATCH_LANES blocks
+  * @param columns Symbol j of lane k is columns[j * stride + k]
+  * @param syndromes Syndrome i of lane k is syndromes[i * ECC_GF16_BATCH_LANES + k]
+  */
+ static void ecc_gf16_batch_syndromes(int32_t generator_base, const uint8_t* columns, int32_t stride, int32_t block_length, int32_t ec_bytes, uint8_t* syndromes) {
+     int32_t i;
+     int32_t j;
+     for (i = 0; i < ec_bytes; i++) {
+         // Evaluate the received polynomials at alpha^(i+b), the products by a are the 16 entries of a multiply table row
+         const int32_t a = ecc_gf16_exp[(i + generator_base) % 15];
+#if defined(ECC_SIMD_SSSE3)
+         const __m128i table = _mm_loadu_si128((const __m128i*)ecc_gf16_mul[a]);
+         const __m128i low_nibble = _mm_set1_epi8(0x0F);
+         __m128i eval = _mm_setzero_si128();
+         for (j = 0; j < block_length; j++) {
+             __m128i symbols = _mm_and_si128(_mm_loadu_si128((const __m128i*)(columns + j * stride)), low_nibble);
+             eval = _mm_xor_si128(_mm_shuffle_epi8(table, eval), symbols);
+         }
+         _mm_storeu_si128((__m128i*)(syndromes + i * ECC_GF16_BATCH_LANES), eval);
+#elif defined(ECC_SIMD_SSE2)
+         // no byte shuffle, sum of eval * x^k for the bits k of a, eval * x is a shift with the 0x13 reduction
+         const __m128i low_nibble = _mm_set1_epi8(0x0F);
+         const __m128i seven = _mm_set1_epi8(7);
+         const __m128i reduction = _mm_set1_epi8(0x03);
+         __m128i eval = _mm_setzero_si128();
+         for (j = 0; j < block_length; j++) {
+             __m128i product = _mm_setzero_si128();
+             __m128i power = eval;
+             int32_t k;
+             for (k = 0; k < 4; k++) {
+                 if (a & (1 << k)) {
+                     product = _mm_xor_si128(product, power);
+                 }
+                 power = _mm_xor_si128(_mm_and_si128(_mm_add_epi8(power, power), low_nibble), _mm_and_si128(_mm_cmpgt_epi8(power, seven), reduction));
+             }
+             __m128i symbols = _mm_and_si128(_mm_loadu_si128((const __m128i*)(columns + j * stride)), low_nibble);
+             eval = _mm_xor_si128(product, symbols);
+         }
+         _mm_storeu_si128((__m128i*)(syndromes + i * ECC_GF16_BATCH_LANES), eval);
+#elif defined(ECC_SIMD_NEON)
+         const uint8x16_t table = vld1q_u8(ecc_gf16_mul[a]);
+         const uint8x16_t low_nibble = vdupq_n_u8(0x0F);
+         uint8x16_t eval = vdupq_n_u8(0);
+         for (j = 0; j < block_length; j++) {
+             uint8x16_t symbols = vandq_u8(vld1q_u8(columns + j * stride), low_nibble);
+             eval = veorq_u8(vqtbl1q_u8(table, eval), symbols);
+         }
+         vst1q_u8(syndromes + i * ECC_GF16_BATCH_LANES, eval);
+#else
+         const uint8_t* mul_a = ecc_gf16_mul[a];
+         uint8_t eval[ECC_GF16_BATCH_LANES] = { 0 };
+         int32_t k;
+         for (j = 0; j < block_length; j++) {
+             const uint8_t* symbols = columns + j * stride;
+             for (k = 0; k < ECC_GF16_BATCH_LANES; k++) {
+                 eval[k] = mul_a[eval[k]] ^ (symbols[k] & 0x0F);
+             }
+         }
+         memcpy(syndromes + i * ECC_GF16_BATCH_LANES, eval, ECC_GF16_BATCH_LANES);
+#endif
+     }
+ }
+
+ int32_t ecc_reed_solomon_gf16_decode_batch(int32_t generator_base, uint8_t* blocks, int32_t number_of_blocks, int32_t block_length, int32_t ec_bytes, int8_t* status, int32_t* fixedErrors) {
+     if (block_length > ECC_GF16_MAX_LENGTH || ec_bytes < 0 || ec_bytes > block_length || number_of_blocks < 0) {
+         if (status != NULL && number_of_blocks > 0) {
+             memset(status, ECC_ILLEGAL_ARGUMENT, number_of_blocks);
+         }
+         return number_of_blocks;
+     }
+     int32_t failed_blocks = 0;
+     uint8_t syndromes[ECC_GF16_MAX_LENGTH * ECC_GF16_BATCH_LANES];
+     uint8_t tail[ECC_GF16_MAX_LENGTH * ECC_GF16_BATCH_LANES];
+     int32_t first_block;
+     int32_t i;
+     int32_t k;
+     for (first_block = 0; first_block < number_of_blocks; first_block += ECC_GF16_BATCH_LANES) {
+         int32_t lanes = number_of_blocks - first_block;
+         if (lanes >= ECC_GF16_BATCH_LANES) {
+             lanes = ECC_GF16_BATCH_LANES;
+             ecc_gf16_batch_syndromes(generator_base, blocks + first_block, number_of_blocks, block_length, ec_bytes, syndromes);
+         } else {
+             // last lanes are read from a zero padded copy
+             memset(tail, 0, sizeof(tail));
+             for (i = 0; i < block_length; i++) {
+                 memcpy(tail + i * ECC_GF16_BATCH_LANES, blocks + i * number_of_blocks + first_block, lanes);
+             }
+             ecc_gf16_batch_syndromes(generator_base, tail, ECC_GF16_BATCH_LANES, block_length, ec_bytes, syndromes);
+         }
+         for (k = 0; k < lanes; k++) {
+             int8_t ret = ECC_NO_ERRORS;
+             uint8_t block_syndromes[ECC_GF16_MAX_LENGTH];
+             uint8_t no_error = 1;
+             for (i = 0; i < ec_bytes; i++) {
+                 block_syndromes[i] = syndromes[i * ECC_GF16_BATCH_LANES + k];
+                 no_error &= block_syndromes[i] == 0;
+             }
+             if (!no_error) {
+                 int32_t error_positions[ECC_GF16_MAX_LENGTH];
+                 uint8_t error_magnitudes[ECC_GF16_MAX_LENGTH];
+                 int32_t number_of_errors = ecc_gf16_find_errors(generator_base, block_syndromes, block_length, ec_bytes, NULL, 0, error_positions, error_magnitudes);
+                 if (number_of_errors < 0) {
+                     ret = (int8_t)-number_of_errors;
+                     failed_blocks++;
+                 } else {
+                     for (i = 0; i < number_of_errors; i++) {
+                         blocks[error_positions[i] * number_of_blocks + first_block + k] ^= error_magnitudes[i];
+                     }
+                     if (fixedErrors != NULL) {
+                         *fixedErrors += number_of_errors;
+                     }
+                 }
+             }
+             if (status != NULL) {
+                 status[first_block + k] = ret;
+             }
+         }
+     }
+     return failed_blocks;
+ }
+
  int32_t ecc_reed_solomon_decoder_decode(ecc_generic_gf_t* field, int32_t* to_decode, int32_t to_decode_length, int32_t ec_bytes, int32_t* fixedErrors) {
+     if (field->size == 16 && field->primitive == ECC_GF16_PRIMITIVE && to_decode_length <= ECC_GF16_MAX_LENGTH) {
+         return ecc_reed_solomon_gf16_decode(field->generator_base, to_decode, to_decode_length, ec_bytes, fixedErrors);
+     }
+     if (ec_bytes <= ECC_BOUNDED_MAX_EC_BYTES) {
+         return ecc_reed_solomon_decoder_decode_bounded(field, to_decode, to_decode_length, ec_bytes, fixedErrors);
+     }
      int32_t ret = ECC_NO_ERRORS;
      ecc_generic_gf_poly_t poly;
-     ecc_generic_gf_poly_init(&poly, to_decode, to_decode_length);
+     ecc_generic_gf_poly_init_allocator(&poly, to_decode, to_decode_length, field->allocator);
      int32_t syndrome_coefficients_length = ec_bytes;
-     int32_t* syndrome_coefficients = malloc(sizeof(int32_t) * syndrome_coefficients_length);
+     int32_t* syndrome_coefficients = ecc_malloc(field->allocator, sizeof(int32_t) * syndrome_coefficients_length);
      memset(syndrome_coefficients, 0, sizeof(int32_t) * syndrome_coefficients_length);
      int32_t no_error = 1;
      int32_t i;
@@ -570,17 +1193,17 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
      }
      if (no_error == 0) {
          ecc_generic_gf_poly_t syndrome;
-         ecc_generic_gf_poly_init(&syndrome, syndrome_coefficients, syndrome_coefficients_length);
+         ecc_generic_gf_poly_init_allocator(&syndrome, syndrome_coefficients, syndrome_coefficients_length, field->allocator);
          ecc_generic_gf_poly_t sigma;
          ecc_generic_gf_poly_t omega;
          ecc_generic_gf_poly_t mono;
-         ecc_generic_gf_build_monomial(&mono, ec_bytes, 1);
+         ecc_generic_gf_build_monomial_allocator(&mono, ec_bytes, 1, field->allocator);
          ret = ecc_reed_solomon_decoder_run_euclidean_algorithm(field, &mono, &syndrome, ec_bytes, &sigma, &omega);
          ecc_generic_gf_poly_free(&mono);
          if (ret == ECC_NO_ERRORS) {
              number_of_errors = ecc_generic_gf_poly_get_degree(&sigma);
-             int32_t* error_locations = malloc(sizeof(int32_t) * number_of_errors);
-             int32_t* error_magnitude = malloc(sizeof(int32_t) * number_of_errors);
+             int32_t* error_locations = ecc_malloc(field->allocator, sizeof(int32_t) * number_of_errors);
+             int32_t* error_magnitude = ecc_malloc(field->allocator, sizeof(int32_t) * number_of_errors);
              ret = ecc_reed_solomon_decoder_find_error_locations(&sigma, field, error_locations);
              ecc_generic_gf_poly_free(&sigma);
              if (ret == ECC_NO_ERRORS) {
@@ -594,12 +1217,12 @@ void ecc_generic_gf_poly_copy(ecc_generic_gf_poly_t* self, ecc_generic_gf_poly_t
                      to_decode[position] = ecc_generic_gf_add_or_substract(to_decode[position], error_magnitude[i]);
                  }
              }
-             free(error_locations);
-             free(error_magnitude);
+             ecc_free(field->allocator, error_locations);
+             ecc_free(field->allocator, error_magnitude);
          }
          ecc_generic_gf_poly_free(&syndrome);
      }
-     free(syndrome_coefficients);
+     ecc_free(field->allocator, syndrome_coefficients);
      ecc_generic_gf_poly_free(&poly);
      if(ret == ECC_NO_ERRORS && fixedErrors != NULL) {
          *fixedErrors += number_of_errors;
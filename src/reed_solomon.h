@@ -51,13 +51,44 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stddef.h>
 
 enum ECC_ERROR_CODES { ECC_NO_ERRORS = 0, ECC_ILLEGAL_ARGUMENT = 1, ECC_DIVIDE_BY_ZERO = 2, ECC_REED_SOLOMON_ERROR
  = 3, ECC_ILLEGAL_STATE_EXCEPTION = 4};
 
+/**
+ * Maximum number of ecc symbols decoded using stack memory only
+ */
+#define ECC_BOUNDED_MAX_EC_BYTES 16
+
+/**
+ * Primitive polynomial x^4 + x + 1 of the GF(16) field used by QRTone
+ */
+#define ECC_GF16_PRIMITIVE 0x13
+
+/**
+ * Maximum length of a GF(16) Reed-Solomon block
+ */
+#define ECC_GF16_MAX_LENGTH 15
+
+/**
+ * Number of GF(16) blocks sharing the syndrome computation of ecc_reed_solomon_gf16_decode_batch
+ */
+#define ECC_GF16_BATCH_LANES 16
+
+/**
+ * Memory allocator, NULL allocator pointers use malloc and free
+ */
+typedef struct _ecc_allocator_t {
+	void* (*malloc_fn)(void* ptr, size_t size); /**< Allocate size bytes */
+	void (*free_fn)(void* ptr, void* memory);   /**< Release memory allocated by malloc_fn */
+	void* ptr;                                  /**< User data provided to malloc_fn and free_fn */
+} ecc_allocator_t;
+
 typedef struct _ecc_generic_gf_poly_t {
 	int32_t* coefficients;             /**< coefficients as ints representing elements of GF(size), arranged from most significant (highest-power term) coefficient to least significant */
 	int32_t coefficients_length;      /**< Length of message attached to distance*/
+	const ecc_allocator_t* allocator;  /**< Allocator of coefficients, inherited by derived polynomials */
 } ecc_generic_gf_poly_t;
 
 typedef struct _ecc_generic_gf_t {
@@ -68,6 +99,7 @@ typedef struct _ecc_generic_gf_t {
     int32_t generator_base;
 	ecc_generic_gf_poly_t zero;
 	ecc_generic_gf_poly_t one;
+	const ecc_allocator_t* allocator;
 } ecc_generic_gf_t;
 
 typedef struct _ecc_reed_solomon_cached_generator_t {
@@ -83,14 +115,24 @@ typedef struct _ecc_reed_solomon_encoder_t {
 
 void ecc_generic_gf_poly_init(ecc_generic_gf_poly_t* self, int32_t* coefficients, int32_t coefficients_length);
 
+void ecc_generic_gf_poly_init_allocator(ecc_generic_gf_poly_t* self, int32_t* coefficients, int32_t coefficients_length, const ecc_allocator_t* allocator);
+
 void ecc_generic_gf_init(ecc_generic_gf_t* self, int32_t primitive, int32_t size, int32_t b);
 
+/**
+ * Init field, tables and polynomials derived from this field are allocated with the provided allocator
+ * @param allocator Allocator, must remain valid until ecc_generic_gf_free. NULL to use malloc
+ */
+void ecc_generic_gf_init_allocator(ecc_generic_gf_t* self, int32_t primitive, int32_t size, int32_t b, const ecc_allocator_t* allocator);
+
 void ecc_generic_gf_free(ecc_generic_gf_t* self);
 
 void ecc_generic_gf_poly_free(ecc_generic_gf_poly_t* self);
 
 int32_t ecc_generic_gf_build_monomial(ecc_generic_gf_poly_t* poly, int32_t degree, int32_t coefficient);
 
+int32_t ecc_generic_gf_build_monomial_allocator(ecc_generic_gf_poly_t* poly, int32_t degree, int32_t coefficient, const ecc_allocator_t* allocator);
+
 void ecc_generic_gf_poly_multiply(ecc_generic_gf_poly_t* self, ecc_generic_gf_t* field, int32_t scalar, ecc_generic_gf_poly_t* result);
 
 int32_t ecc_generic_gf_poly_is_zero(ecc_generic_gf_poly_t* self);
@@ -119,13 +161,85 @@ void ecc_reed_solomon_encoder_free(ecc_reed_solomon_encoder_t* self);
 
 void ecc_reed_solomon_encoder_init(ecc_reed_solomon_encoder_t* self, int32_t primitive, int32_t size, int32_t b);
 
+/**
+ * Init encoder, the field and the cached generators are allocated with the provided allocator
+ * @param allocator Allocator, must remain valid until ecc_reed_solomon_encoder_free. NULL to use malloc
+ */
+void ecc_reed_solomon_encoder_init_allocator(ecc_reed_solomon_encoder_t* self, int32_t primitive, int32_t size, int32_t b, const ecc_allocator_t* allocator);
+
+/**
+ * Build and cache the generators up to the provided degree. Encoding with ec_bytes not greater than degree then does not modify the encoder.
+ * @return generator of the provided degree
+ */
+ecc_generic_gf_poly_t* ecc_reed_solomon_encoder_build_generator(ecc_reed_solomon_encoder_t* self, int32_t degree);
+
+/**
+ * Compute the ec_bytes parity symbols at the end of to_encode.
+ * GF(16) fields use ecc_reed_solomon_gf16_encode, the encoder is then not modified and can be shared between threads.
+ */
 void ecc_reed_solomon_encoder_encode(ecc_reed_solomon_encoder_t* self, int32_t* to_encode, int32_t to_encode_length, int32_t ec_bytes);
 
 /**
+ * Compute the ec_bytes parity symbols of a GF(16) block of the ECC_GF16_PRIMITIVE field at the end of to_encode.
+ * A linear feedback shift register divides by the generator. Generators of the QRTone codes are constant,
+ * others are built on the stack. This method is reentrant.
+ * @param generator_base Generator base b of the code
+ * @param to_encode Data symbols in [0, 15] followed by ec_bytes symbols receiving the parity
+ * @param to_encode_length Block length, not greater than ECC_GF16_MAX_LENGTH
+ * @return ecc_ERROR_CODES
+ */
+int32_t ecc_reed_solomon_gf16_encode(int32_t generator_base, int32_t* to_encode, int32_t to_encode_length, int32_t ec_bytes);
+
+/**
+ * Decode the message and fix errors in place.
+ * When ec_bytes is not greater than ECC_BOUNDED_MAX_EC_BYTES the decoding does not allocate memory.
  * @return ecc_ERROR_CODES
  */
 int32_t ecc_reed_solomon_decoder_decode(ecc_generic_gf_t* field, int32_t* to_decode, int32_t to_decode_length, int32_t ec_bytes, int32_t* fixedErrors);
 
+/**
+ * Decode the message of any field and fix errors in place, with the Euclidean algorithm on stack arrays.
+ * ecc_reed_solomon_decoder_decode uses this method for fields other than GF(16).
+ * @param ec_bytes Number of ecc symbols, not greater than ECC_BOUNDED_MAX_EC_BYTES
+ * @return ecc_ERROR_CODES
+ */
+int32_t ecc_reed_solomon_decoder_decode_bounded(ecc_generic_gf_t* field, int32_t* to_decode, int32_t to_decode_length, int32_t ec_bytes, int32_t* fixedErrors);
+
+/**
+ * Decode a GF(16) block of the ECC_GF16_PRIMITIVE field and fix errors in place.
+ * Berlekamp-Massey, Chien search and Forney run on stack arrays with constant multiply tables, the field tables are not used.
+ * ecc_reed_solomon_decoder_decode uses this method for GF(16) fields.
+ * @param generator_base Generator base b of the code
+ * @param to_decode Symbols in [0, 15]
+ * @param to_decode_length Block length, not greater than ECC_GF16_MAX_LENGTH
+ * @return ecc_ERROR_CODES
+ */
+int32_t ecc_reed_solomon_gf16_decode(int32_t generator_base, int32_t* to_decode, int32_t to_decode_length, int32_t ec_bytes, int32_t* fixedErrors);
+
+/**
+ * Same as ecc_reed_solomon_gf16_decode with symbols known to be unreliable.
+ * The block is fixed if 2 * errors + erasures is not greater than ec_bytes.
+ * @param erasures Distinct index of the erased symbols in to_decode
+ * @param erasures_length Number of erasures, not greater than ec_bytes
+ * @param fixedErrors NULL or incremented by the number of modified symbols
+ * @return ecc_ERROR_CODES
+ */
+int32_t ecc_reed_solomon_gf16_decode_erasures(int32_t generator_base, int32_t* to_decode, int32_t to_decode_length, int32_t ec_bytes, const int32_t* erasures, int32_t erasures_length, int32_t* fixedErrors);
+
+/**
+ * Decode number_of_blocks GF(16) blocks of the ECC_GF16_PRIMITIVE field and fix errors in place.
+ * Syndromes of ECC_GF16_BATCH_LANES blocks are computed at once with byte shuffle instructions (SSSE3 or NEON), or SSE2, when available.
+ * A failing block does not stop the decoding of the other blocks.
+ * @param generator_base Generator base b of the code
+ * @param blocks Symbols in [0, 15], symbol j of block k is blocks[j * number_of_blocks + k]
+ * @param block_length Length of all blocks, not greater than ECC_GF16_MAX_LENGTH
+ * @param status NULL or array of number_of_blocks receiving the ecc_ERROR_CODES of each block, all ECC_ILLEGAL_ARGUMENT if
+ * block_length or ec_bytes is not valid
+ * @param fixedErrors NULL or incremented by the number of errors fixed in the decoded blocks
+ * @return number of blocks that could not be decoded, number_of_blocks if the arguments are not valid
+ */
+int32_t ecc_reed_solomon_gf16_decode_batch(int32_t generator_base, uint8_t* blocks, int32_t number_of_blocks, int32_t block_length, int32_t ec_bytes, int8_t* status, int32_t* fixedErrors);
+
 
 
 
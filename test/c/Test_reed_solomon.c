@@ -42,6 +42,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 #include <stdio.h>
@@ -637,6 +638,205 @@ MU_TEST(testGF16) {
 	ecc_generic_gf_free(&field);
 }
 
+// GF(16) decoder with other generator bases, and detection of uncorrectable blocks
+MU_TEST(testGF16GeneratorBase) {
+	int32_t b;
+	for (b = 0; b < 3; b++) {
+		ecc_reed_solomon_encoder_t encoder;
+		ecc_reed_solomon_encoder_init(&encoder, ECC_GF16_PRIMITIVE, 16, b);
+
+		int32_t message[15] = { 11, 3, 7, 4, 11, 10, 11, 15, 6 };
+		ecc_reed_solomon_encoder_encode(&encoder, message, 15, 6);
+		testDecode(&(encoder.field), message, 15, 6);
+
+		// 4 errors exceed the capacity, decoding must fail or return a valid codeword
+		int32_t decoded[15];
+		memcpy(decoded, message, sizeof(decoded));
+		decoded[0] ^= 1;
+		decoded[4] ^= 7;
+		decoded[9] ^= 12;
+		decoded[14] ^= 5;
+		if (ecc_reed_solomon_gf16_decode(b, decoded, 15, 6, NULL) == ECC_NO_ERRORS) {
+			int32_t fixed_errors = 0;
+			mu_assert_int_eq(ECC_NO_ERRORS, ecc_reed_solomon_gf16_decode(b, decoded, 15, 6, &fixed_errors));
+			mu_assert_int_eq(0, fixed_errors);
+		}
+		ecc_reed_solomon_encoder_free(&encoder);
+	}
+}
+
+// Random blocks with up to one error more than the capacity are decoded the same way by the GF(16) and the generic decoder
+MU_TEST(testGF16RandomEquivalence) {
+	int32_t configurations[][2] = { {15, 2}, {14, 2}, {14, 4}, {12, 4}, {12, 6}, {10, 6}, {15, 8} };
+	srand(42);
+	int32_t b;
+	for (b = 0; b < 3; b++) {
+		ecc_reed_solomon_encoder_t encoder;
+		ecc_reed_solomon_encoder_init(&encoder, ECC_GF16_PRIMITIVE, 16, b);
+		int32_t c;
+		for (c = 0; c < 7; c++) {
+			int32_t block_length = configurations[c][0];
+			int32_t ec_bytes = configurations[c][1];
+			int32_t trial;
+			for (trial = 0; trial < 200; trial++) {
+				int32_t message[15];
+				int32_t j;
+				for (j = 0; j < block_length - ec_bytes; j++) {
+					message[j] = rand() % 16;
+				}
+				ecc_reed_solomon_encoder_encode(&encoder, message, block_length, ec_bytes);
+				int32_t expected[15];
+				memcpy(expected, message, sizeof(int32_t) * block_length);
+				// Distinct error locations with non zero magnitudes
+				int32_t number_of_errors = trial % (ec_bytes / 2 + 2);
+				int32_t e;
+				for (e = 0; e < number_of_errors; e++) {
+					int32_t position = rand() % block_length;
+					while (message[position] != expected[position]) {
+						position = (position + 1) % block_length;
+					}
+					message[position] ^= 1 + rand() % 15;
+				}
+				int32_t generic[15];
+				memcpy(generic, message, sizeof(int32_t) * block_length);
+				int32_t fixed_errors = 0;
+				int32_t generic_fixed_errors = 0;
+				int32_t ret = ecc_reed_solomon_gf16_decode(b, message, block_length, ec_bytes, &fixed_errors);
+				int32_t generic_ret = ecc_reed_solomon_decoder_decode_bounded(&(encoder.field), generic, block_length, ec_bytes, &generic_fixed_errors);
+				if (number_of_errors <= ec_bytes / 2) {
+					mu_assert_int_eq(ECC_NO_ERRORS, ret);
+					mu_assert_int_array_eq(expected, block_length, message, block_length);
+				}
+				if (ret == ECC_NO_ERRORS) {
+					mu_assert_int_eq(ECC_NO_ERRORS, generic_ret);
+					mu_assert_int_array_eq(generic, block_length, message, block_length);
+					mu_assert_int_eq(generic_fixed_errors, fixed_errors);
+				} else if (generic_ret == ECC_NO_ERRORS) {
+					// The euclidean algorithm may stop with a locator of too low degree, the generic result is then not a codeword
+					mu_check(ecc_reed_solomon_gf16_decode(b, generic, block_length, ec_bytes, NULL) != ECC_NO_ERRORS);
+				}
+			}
+		}
+		ecc_reed_solomon_encoder_free(&encoder);
+	}
+}
+
+// QRTone block configurations, the encoder must not be modified
+MU_TEST(testGF16Encoder) {
+	ecc_reed_solomon_encoder_t encoder;
+	ecc_reed_solomon_encoder_init(&encoder, ECC_GF16_PRIMITIVE, 16, 1);
+	int32_t configurations[][2] = { {14, 2}, {14, 4}, {12, 6}, {10, 6}, {6, 2} };
+	int32_t c;
+	for (c = 0; c < 5; c++) {
+		int32_t message[15] = { 5, 12, 0, 15, 9, 3, 1, 14, 7, 2, 11, 6 };
+		ecc_reed_solomon_encoder_encode(&encoder, message, configurations[c][0], configurations[c][1]);
+		int32_t fixed_errors = 0;
+		mu_assert_int_eq(ECC_NO_ERRORS, ecc_reed_solomon_decoder_decode(&(encoder.field), message, configurations[c][0], configurations[c][1], &fixed_errors));
+		mu_assert_int_eq(0, fixed_errors);
+	}
+	mu_assert_int_eq(0, encoder.cached_generators->index);
+	ecc_reed_solomon_encoder_free(&encoder);
+}
+
+// Blocks with errors, uncorrectable blocks and a partial last group of lanes
+MU_TEST(testGF16DecodeBatch) {
+	ecc_reed_solomon_encoder_t encoder;
+	ecc_reed_solomon_encoder_init(&encoder, ECC_GF16_PRIMITIVE, 16, 1);
+	const int32_t number_of_blocks = ECC_GF16_BATCH_LANES * 2 + 5;
+	const int32_t block_length = 12;
+	const int32_t ec_bytes = 6;
+	uint8_t* blocks = malloc((size_t)number_of_blocks * block_length);
+	uint8_t* expected = malloc((size_t)number_of_blocks * block_length);
+	int8_t* status = malloc(number_of_blocks);
+	int32_t block_id;
+	int32_t j;
+	for (block_id = 0; block_id < number_of_blocks; block_id++) {
+		int32_t message[15];
+		for (j = 0; j < block_length - ec_bytes; j++) {
+			message[j] = (block_id * 7 + j * 3) % 16;
+		}
+		ecc_reed_solomon_encoder_encode(&encoder, message, block_length, ec_bytes);
+		for (j = 0; j < block_length; j++) {
+			expected[j * number_of_blocks + block_id] = (uint8_t)message[j];
+			blocks[j * number_of_blocks + block_id] = (uint8_t)message[j];
+		}
+		// block_id % 5 errors, blocks with 4 errors can't be fixed
+		for (j = 0; j < block_id % 5; j++) {
+			blocks[((block_id + j * 5) % block_length) * number_of_blocks + block_id] ^= (uint8_t)(1 + (block_id + j) % 15);
+		}
+	}
+	int32_t fixed_errors = 0;
+	int32_t failed_blocks = ecc_reed_solomon_gf16_decode_batch(1, blocks, number_of_blocks, block_length, ec_bytes, status, &fixed_errors);
+	int32_t expected_failed = 0;
+	int32_t expected_fixed = 0;
+	for (block_id = 0; block_id < number_of_blocks; block_id++) {
+		if (block_id % 5 == 4) {
+			expected_failed++;
+			mu_check(status[block_id] != ECC_NO_ERRORS);
+		} else {
+			expected_fixed += block_id % 5;
+			mu_assert_int_eq(ECC_NO_ERRORS, status[block_id]);
+			for (j = 0; j < block_length; j++) {
+				mu_assert_int_eq(expected[j * number_of_blocks + block_id], blocks[j * number_of_blocks + block_id]);
+			}
+		}
+	}
+	mu_assert_int_eq(expected_failed, failed_blocks);
+	mu_assert_int_eq(expected_fixed, fixed_errors);
+	// invalid arguments, every block is reported as failed
+	memset(status, ECC_NO_ERRORS, number_of_blocks);
+	mu_assert_int_eq(number_of_blocks, ecc_reed_solomon_gf16_decode_batch(1, blocks, number_of_blocks, block_length, block_length + 1, status, NULL));
+	for (block_id = 0; block_id < number_of_blocks; block_id++) {
+		mu_assert_int_eq(ECC_ILLEGAL_ARGUMENT, status[block_id]);
+	}
+	free(blocks);
+	free(expected);
+	free(status);
+	ecc_reed_solomon_encoder_free(&encoder);
+}
+
+MU_TEST(testGF16Erasures) {
+	ecc_reed_solomon_encoder_t encoder;
+	ecc_reed_solomon_encoder_init(&encoder, ECC_GF16_PRIMITIVE, 16, 1);
+	const int32_t block_length = 12;
+	const int32_t ec_bytes = 6;
+	int32_t expected[15];
+	int32_t message[15];
+	int32_t j;
+	for (j = 0; j < block_length - ec_bytes; j++) {
+		expected[j] = (j * 5 + 3) % 16;
+	}
+	ecc_reed_solomon_encoder_encode(&encoder, expected, block_length, ec_bytes);
+	// 6 erasures, twice the error capacity
+	int32_t erasures[] = { 0, 2, 4, 7, 9, 11 };
+	memcpy(message, expected, sizeof(int32_t) * block_length);
+	for (j = 0; j < 6; j++) {
+		message[erasures[j]] ^= 1 + j;
+	}
+	mu_check(ecc_reed_solomon_gf16_decode(1, message, block_length, ec_bytes, NULL) != ECC_NO_ERRORS);
+	int32_t fixed_errors = 0;
+	mu_assert_int_eq(ECC_NO_ERRORS, ecc_reed_solomon_gf16_decode_erasures(1, message, block_length, ec_bytes, erasures, 6, &fixed_errors));
+	mu_assert_int_array_eq(expected, block_length, message, block_length);
+	mu_assert_int_eq(6, fixed_errors);
+	// 2 erasures, one of them correct, and 2 errors
+	memcpy(message, expected, sizeof(int32_t) * block_length);
+	message[0] ^= 3;
+	message[5] ^= 7;
+	message[8] ^= 9;
+	fixed_errors = 0;
+	mu_assert_int_eq(ECC_NO_ERRORS, ecc_reed_solomon_gf16_decode_erasures(1, message, block_length, ec_bytes, erasures, 2, &fixed_errors));
+	mu_assert_int_array_eq(expected, block_length, message, block_length);
+	mu_assert_int_eq(3, fixed_errors);
+	// 2 erasures and 3 errors exceed the capacity
+	memcpy(message, expected, sizeof(int32_t) * block_length);
+	message[0] ^= 3;
+	message[5] ^= 7;
+	message[6] ^= 2;
+	message[8] ^= 9;
+	mu_check(ecc_reed_solomon_gf16_decode_erasures(1, message, block_length, ec_bytes, erasures, 2, NULL) != ECC_NO_ERRORS);
+	ecc_reed_solomon_encoder_free(&encoder);
+}
+
 MU_TEST_SUITE(test_suite) {
 	MU_RUN_TEST(testEvaluate);
 	MU_RUN_TEST(testPolynomial);
@@ -653,6 +853,11 @@ MU_TEST_SUITE(test_suite) {
 	MU_RUN_TEST(testAztec6);
 	MU_RUN_TEST(testAztec7);
 	MU_RUN_TEST(testGF16);
+	MU_RUN_TEST(testGF16GeneratorBase);
+	MU_RUN_TEST(testGF16RandomEquivalence);
+	MU_RUN_TEST(testGF16Encoder);
+	MU_RUN_TEST(testGF16DecodeBatch);
+	MU_RUN_TEST(testGF16Erasures);
 }
 
 int main(int argc, char** argv) {
@@ -0,0 +1,228 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) Unité Mixte de Recherche en Acoustique Environnementale (univ-gustave-eiffel)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *  Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ *  Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "qrtone.h"
+#include "qrtone_pool.h"
+#include "minunit.h"
+
+#define POOL_SAMPLE_RATE 16000
+#define POOL_STREAMS 16
+#define POOL_PRODUCERS 3
+#define POOL_MESSAGES 2
+
+static int8_t POOL_PAYLOAD[] = { 0, 0, -117, -93, -50, 2, 52, 26 };
+
+typedef struct _pool_stream_t {
+	float* signal;
+	int16_t* signal_s16;
+	int32_t signal_length;
+	int64_t message_index[POOL_MESSAGES];
+	int32_t received;
+	int8_t payload[POOL_MESSAGES][sizeof(POOL_PAYLOAD)];
+	int64_t sample_index[POOL_MESSAGES];
+} pool_stream_t;
+
+typedef struct _pool_producer_t {
+	qrtone_pool_t* pool;
+	pool_stream_t* streams;
+	int32_t first_stream;
+} pool_producer_t;
+
+static uint32_t noise_state = 1;
+
+// Deterministic noise in [-1, 1]
+static float pool_noise(void) {
+	noise_state = noise_state * 1664525u + 1013904223u;
+	return ((int32_t)(noise_state >> 8) - (1 << 23)) / (float)(1 << 23);
+}
+
+static void pool_generate_streams(pool_stream_t* streams) {
+	int32_t id_stream;
+	for (id_stream = 0; id_stream < POOL_STREAMS; id_stream++) {
+		pool_stream_t* stream = &(streams[id_stream]);
+		memset(stream, 0, sizeof(pool_stream_t));
+		stream->signal_length = POOL_SAMPLE_RATE * 12;
+		stream->signal = calloc((size_t)stream->signal_length, sizeof(float));
+		stream->signal_s16 = malloc(sizeof(int16_t) * (size_t)stream->signal_length);
+		int32_t id_message;
+		for (id_message = 0; id_message < POOL_MESSAGES; id_message++) {
+			qrtone_t* qrtone = qrtone_new();
+			qrtone_init(qrtone, POOL_SAMPLE_RATE);
+			POOL_PAYLOAD[0] = (int8_t)id_stream;
+			POOL_PAYLOAD[1] = (int8_t)id_message;
+			int32_t message_length = qrtone_set_payload(qrtone, POOL_PAYLOAD, sizeof(POOL_PAYLOAD));
+			// Messages of the streams are not aligned
+			stream->message_index[id_message] = POOL_SAMPLE_RATE / 2 + id_stream * (POOL_SAMPLE_RATE / 20) + id_message * POOL_SAMPLE_RATE * 5;
+			qrtone_get_samples(qrtone, stream->signal + stream->message_index[id_message], message_length, 0.1f);
+			qrtone_free(qrtone);
+			free(qrtone);
+		}
+		int32_t i;
+		for (i = 0; i < stream->signal_length; i++) {
+			stream->signal[i] += pool_noise() * 0.0001f;
+			stream->signal_s16[i] = (int16_t)(stream->signal[i] * 32767);
+		}
+	}
+}
+
+static void pool_on_payload(void* ptr, int32_t stream, const qrtone_message_t* message) {
+	pool_stream_t* pool_stream = &(((pool_stream_t*)ptr)[stream]);
+	// Calls of a stream are never concurrent
+	if (pool_stream->received < POOL_MESSAGES && message->payload_length == sizeof(POOL_PAYLOAD)) {
+		memcpy(pool_stream->payload[pool_stream->received], message->payload, sizeof(POOL_PAYLOAD));
+		pool_stream->sample_index[pool_stream->received] = message->sample_index;
+	}
+	pool_stream->received++;
+}
+
+/**
+ * Push the streams of the producer by interleaved pieces of various lengths, odd streams are pushed as int16
+ */
+static void* pool_producer(void* data) {
+	pool_producer_t* producer = (pool_producer_t*)data;
+	int32_t cursors[POOL_STREAMS] = { 0 };
+	int32_t remaining = 1;
+	int32_t round = 0;
+	while (remaining) {
+		remaining = 0;
+		int32_t id_stream;
+		for (id_stream = producer->first_stream; id_stream < POOL_STREAMS; id_stream += POOL_PRODUCERS) {
+			pool_stream_t* stream = &(producer->streams[id_stream]);
+			int32_t length = 300 + ((round * 7 + id_stream * 13) % 5) * 250;
+			if (length > stream->signal_length - cursors[id_stream]) {
+				length = stream->signal_length - cursors[id_stream];
+			}
+			if (id_stream % 2 == 0) {
+				cursors[id_stream] += qrtone_pool_push(producer->pool, id_stream, stream->signal + cursors[id_stream], length);
+			} else {
+				cursors[id_stream] += qrtone_pool_push_s16(producer->pool, id_stream, stream->signal_s16 + cursors[id_stream], length);
+			}
+			if (cursors[id_stream] < stream->signal_length) {
+				remaining = 1;
+			}
+		}
+		round++;
+		// The queues are full, let the workers decode
+		sched_yield();
+	}
+	return NULL;
+}
+
+MU_TEST(testPoolStreams) {
+	pool_stream_t* streams = malloc(sizeof(pool_stream_t) * POOL_STREAMS);
+	pool_generate_streams(streams);
+	qrtone_pool_options_t options;
+	qrtone_pool_options_init(&options);
+	options.threads = 4;
+	options.block_length = 512;
+	options.queue_blocks = 4;
+	qrtone_pool_t* pool = qrtone_pool_new(POOL_STREAMS, POOL_SAMPLE_RATE, &options, streams, pool_on_payload);
+	mu_check(pool != NULL);
+	pool_producer_t producers[POOL_PRODUCERS];
+	pthread_t threads[POOL_PRODUCERS];
+	int32_t i;
+	for (i = 0; i < POOL_PRODUCERS; i++) {
+		producers[i].pool = pool;
+		producers[i].streams = streams;
+		producers[i].first_stream = i;
+		mu_check(pthread_create(&(threads[i]), NULL, pool_producer, &(producers[i])) == 0);
+	}
+	for (i = 0; i < POOL_PRODUCERS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	qrtone_pool_flush(pool);
+	qrtone_pool_stats_t stats;
+	qrtone_pool_get_stats(pool, &stats);
+	mu_assert_int_eq(POOL_STREAMS * POOL_MESSAGES, (int32_t)stats.messages);
+	mu_check(stats.samples == (int64_t)POOL_STREAMS * streams[0].signal_length);
+	qrtone_pool_free(pool);
+	int32_t id_stream;
+	for (id_stream = 0; id_stream < POOL_STREAMS; id_stream++) {
+		pool_stream_t* stream = &(streams[id_stream]);
+		mu_assert_int_eq(POOL_MESSAGES, stream->received);
+		int32_t id_message;
+		for (id_message = 0; id_message < POOL_MESSAGES && id_message < stream->received; id_message++) {
+			// Messages of a stream are received in order
+			POOL_PAYLOAD[0] = (int8_t)id_stream;
+			POOL_PAYLOAD[1] = (int8_t)id_message;
+			mu_assert_int_array_eq(POOL_PAYLOAD, sizeof(POOL_PAYLOAD), stream->payload[id_message], sizeof(POOL_PAYLOAD));
+			mu_check(llabs(stream->sample_index[id_message] - stream->message_index[id_message]) < POOL_SAMPLE_RATE / 100);
+		}
+		free(stream->signal);
+		free(stream->signal_s16);
+	}
+	free(streams);
+}
+
+MU_TEST(testPoolFullQueue) {
+	qrtone_pool_options_t options;
+	qrtone_pool_options_init(&options);
+	options.threads = 1;
+	options.block_length = 100;
+	options.queue_blocks = 3;
+	// no decoder for an invalid stream count or sample rate
+	mu_check(qrtone_pool_new(0, POOL_SAMPLE_RATE, &options, NULL, pool_on_payload) == NULL);
+	mu_check(qrtone_pool_new(1, 1000, &options, NULL, pool_on_payload) == NULL);
+	pool_stream_t stream;
+	memset(&stream, 0, sizeof(pool_stream_t));
+	qrtone_pool_t* pool = qrtone_pool_new(1, POOL_SAMPLE_RATE, &options, &stream, pool_on_payload);
+	mu_check(pool != NULL);
+	float* samples = calloc(POOL_SAMPLE_RATE, sizeof(float));
+	// The queue holds 4 blocks, a push never blocks
+	int32_t pushed = qrtone_pool_push(pool, 0, samples, POOL_SAMPLE_RATE);
+	mu_check(pushed >= 400 && pushed < POOL_SAMPLE_RATE);
+	mu_assert_int_eq(0, qrtone_pool_push(pool, 1, samples, POOL_SAMPLE_RATE));
+	qrtone_pool_flush(pool);
+	// The decoded blocks are free again
+	mu_assert_int_eq(400, qrtone_pool_push(pool, 0, samples + pushed, POOL_SAMPLE_RATE - pushed));
+	qrtone_pool_free(pool);
+	free(samples);
+}
+
+MU_TEST_SUITE(test_suite) {
+	MU_RUN_TEST(testPoolStreams);
+	MU_RUN_TEST(testPoolFullQueue);
+}
+
+int main(int argc, char** argv) {
+	MU_RUN_SUITE(test_suite);
+	MU_REPORT();
+	return minunit_status == 1 || minunit_fail > 0 ? -1 : 0;
+}
@@ -80,6 +80,10 @@ typedef struct _qrtone_crc16_t qrtone_crc16_t;
 
 typedef struct _qrtone_goertzel_t qrtone_goertzel_t;
 
+typedef struct _qrtone_goertzel_bank_t qrtone_goertzel_bank_t;
+
+typedef struct _qrtone_goertzel_bank_coefficients_t qrtone_goertzel_bank_coefficients_t;
+
 typedef struct _qrtone_percentile_t qrtone_percentile_t;
 
 typedef struct _qrtone_array_t qrtone_array_t;
@@ -114,10 +118,38 @@ void qrtone_goertzel_reset(qrtone_goertzel_t * this);
 
 void qrtone_goertzel_init(qrtone_goertzel_t * this, float sample_rate, float frequency, int32_t window_size, int8_t hann_window);
 
-void qrtone_goertzel_process_samples(qrtone_goertzel_t * this, float* samples, int32_t samples_len);
+void qrtone_goertzel_process_samples(qrtone_goertzel_t * this, const float* samples, int32_t samples_len);
 
 float qrtone_goertzel_compute_rms(qrtone_goertzel_t * this);
 
+void qrtone_goertzel_free(qrtone_goertzel_t * this);
+
+qrtone_goertzel_bank_t* qrtone_goertzel_bank_new(void);
+
+qrtone_goertzel_bank_coefficients_t* qrtone_goertzel_bank_coefficients_new(void);
+
+void qrtone_goertzel_bank_coefficients_init(qrtone_goertzel_bank_coefficients_t * this, float sample_rate, const float* frequencies, const int32_t * window_sizes, int32_t word_length);
+
+void qrtone_goertzel_bank_init(qrtone_goertzel_bank_t * this, const qrtone_goertzel_bank_coefficients_t * coefficients);
+
+void qrtone_goertzel_bank_process_samples(qrtone_goertzel_bank_t * this, const float* samples, int32_t samples_len, int32_t position);
+
+void qrtone_goertzel_bank_compute_rms(qrtone_goertzel_bank_t * this, float* rms);
+
+#ifdef QRTONE_FIXED_POINT
+typedef struct _qrtone_goertzel_bank_fixed_t qrtone_goertzel_bank_fixed_t;
+
+qrtone_goertzel_bank_fixed_t* qrtone_goertzel_bank_fixed_new(void);
+
+void qrtone_goertzel_bank_fixed_init(qrtone_goertzel_bank_fixed_t * this, const qrtone_goertzel_bank_coefficients_t * coefficients);
+
+void qrtone_goertzel_bank_fixed_process_samples(qrtone_goertzel_bank_fixed_t * this, const int16_t* samples, int32_t samples_len, int32_t position);
+
+void qrtone_goertzel_bank_fixed_compute_levels(qrtone_goertzel_bank_fixed_t * this, int32_t* levels);
+
+float qrtone_fixed_level_to_db(int32_t level);
+#endif
+
 qrtone_percentile_t* qrtone_percentile_new(void);
 
 void qrtone_percentile_free(qrtone_percentile_t * this);
@@ -188,7 +220,18 @@ int32_t qrtone_header_get_number_of_symbols(qrtone_header_t* this);
 
 int8_t* qrtone_symbols_to_payload(qrtone_t * this, int8_t * symbols, int32_t symbols_length, int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t has_crc);
 
-void qrtone_payload_to_symbols(qrtone_t * this, int8_t * payload, uint8_t payload_length, int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t has_crc, int8_t * symbols);
+int8_t qrtone_symbols_to_payload_buffer(qrtone_t * this, int8_t * symbols, const uint16_t * symbols_margin, int32_t symbols_length, int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t has_crc, int8_t * symbols_scratch, int8_t * payload);
+
+int8_t qrtone_symbols_soft_decision(qrtone_t * this, int8_t * symbols, const int8_t * symbols_runner_up, const uint16_t * symbols_margin, int32_t symbols_length,
+	int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t * symbols_scratch, int8_t * payload);
+
+int8_t qrtone_payload_to_symbols(qrtone_t * this, int8_t * payload, uint8_t payload_length, int32_t block_symbols_size, int32_t block_ecc_symbols, int8_t has_crc, int8_t * symbols);
+
+float qrtone_decimator_filter(const qrtone_profile_t* profile, const float* window);
+
+#ifdef QRTONE_FIXED_POINT
+int16_t qrtone_decimator_filter_s16(const qrtone_profile_t* profile, const int16_t* window);
+#endif
 
 
 MU_TEST(testCRC8) {
@@ -277,6 +320,112 @@ MU_TEST(test1khzIterative) {
 	free(goertzel);
 }
 
+#define BANK_FREQUENCIES 32
+
+float gaussrand();
+
+MU_TEST(testGoertzelBank) {
+	const float sample_rate = 44100;
+	const int32_t word_length = (int32_t)(sample_rate * 0.06f);
+	float frequencies[BANK_FREQUENCIES];
+	int32_t window_sizes[BANK_FREQUENCIES];
+	int32_t i;
+	for (i = 0; i < BANK_FREQUENCIES; i++) {
+		frequencies[i] = 1720.0f * powf(1.0472941228206267f, (float)i);
+		window_sizes[i] = word_length - 45 * i;
+	}
+	float* audio = malloc(sizeof(float) * word_length);
+	int s;
+	for (s = 0; s < word_length; s++) {
+		float t = s * (1 / (float)sample_rate);
+		audio[s] = (float)(sin(2 * M_PI * frequencies[3] * t) * 0.1 + sin(2 * M_PI * frequencies[20] * t) * 0.01 + gaussrand() * 0.001);
+	}
+
+	qrtone_goertzel_bank_coefficients_t* coefficients = qrtone_goertzel_bank_coefficients_new();
+	qrtone_goertzel_bank_coefficients_init(coefficients, sample_rate, frequencies, window_sizes, word_length);
+	qrtone_goertzel_bank_t* bank = qrtone_goertzel_bank_new();
+	qrtone_goertzel_bank_init(bank, coefficients);
+
+	int32_t cursor = 0;
+	while (cursor < word_length) {
+		int32_t window_size = MIN((rand() % 115) + 20, word_length - cursor);
+		qrtone_goertzel_bank_process_samples(bank, audio + cursor, window_size, cursor);
+		cursor += window_size;
+	}
+	float rms[BANK_FREQUENCIES];
+	qrtone_goertzel_bank_compute_rms(bank, rms);
+
+	// Compare with the reference implementation
+	qrtone_goertzel_t* goertzel = qrtone_goertzel_new();
+	for (i = 0; i < BANK_FREQUENCIES; i++) {
+		qrtone_goertzel_init(goertzel, sample_rate, frequencies[i], window_sizes[i], 1);
+		qrtone_goertzel_process_samples(goertzel, audio + word_length / 2 - window_sizes[i] / 2, window_sizes[i]);
+		float expected_rms = qrtone_goertzel_compute_rms(goertzel);
+		mu_assert_double_eq(20 * log10(expected_rms), 20 * log10(rms[i]), 0.05);
+		qrtone_goertzel_free(goertzel);
+	}
+
+	free(goertzel);
+	free(bank);
+	free(coefficients);
+	free(audio);
+}
+
+#ifdef QRTONE_FIXED_POINT
+MU_TEST(testGoertzelBankFixed) {
+	const float sample_rate = 44100;
+	const int32_t word_length = (int32_t)(sample_rate * 0.06f);
+	float frequencies[BANK_FREQUENCIES];
+	int32_t window_sizes[BANK_FREQUENCIES];
+	int32_t i;
+	for (i = 0; i < BANK_FREQUENCIES; i++) {
+		frequencies[i] = 1720.0f * powf(1.0472941228206267f, (float)i);
+		window_sizes[i] = word_length - 45 * i;
+	}
+	float* audio = malloc(sizeof(float) * word_length);
+	int16_t* audio_s16 = malloc(sizeof(int16_t) * word_length);
+	int s;
+	for (s = 0; s < word_length; s++) {
+		float t = s * (1 / (float)sample_rate);
+		audio_s16[s] = (int16_t)((sin(2 * M_PI * frequencies[3] * t) * 0.1 + sin(2 * M_PI * frequencies[20] * t) * 0.01 + gaussrand() * 0.001) * 32767);
+		audio[s] = audio_s16[s] / 32768.0f;
+	}
+
+	qrtone_goertzel_bank_coefficients_t* coefficients = qrtone_goertzel_bank_coefficients_new();
+	qrtone_goertzel_bank_coefficients_init(coefficients, sample_rate, frequencies, window_sizes, word_length);
+	qrtone_goertzel_bank_t* bank = qrtone_goertzel_bank_new();
+	qrtone_goertzel_bank_init(bank, coefficients);
+	qrtone_goertzel_bank_fixed_t* bank_fixed = qrtone_goertzel_bank_fixed_new();
+	qrtone_goertzel_bank_fixed_init(bank_fixed, coefficients);
+
+	int32_t cursor = 0;
+	while (cursor < word_length) {
+		int32_t window_size = MIN((rand() % 115) + 20, word_length - cursor);
+		qrtone_goertzel_bank_process_samples(bank, audio + cursor, window_size, cursor);
+		qrtone_goertzel_bank_fixed_process_samples(bank_fixed, audio_s16 + cursor, window_size, cursor);
+		cursor += window_size;
+	}
+	float rms[BANK_FREQUENCIES];
+	int32_t levels[BANK_FREQUENCIES];
+	qrtone_goertzel_bank_compute_rms(bank, rms);
+	qrtone_goertzel_bank_fixed_compute_levels(bank_fixed, levels);
+
+	// Tones are matched, quantization noise only affects bins below the -60 dB noise floor
+	for (i = 0; i < BANK_FREQUENCIES; i++) {
+		if (i == 3 || i == 20) {
+			mu_assert_double_eq(20 * log10(rms[i]), qrtone_fixed_level_to_db(levels[i]), 0.01);
+		} else {
+			mu_check(qrtone_fixed_level_to_db(levels[i]) < -70);
+		}
+	}
+
+	free(bank_fixed);
+	free(bank);
+	free(coefficients);
+	free(audio_s16);
+	free(audio);
+}
+#endif
 
 MU_TEST(testPercentile) {
 	qrtone_percentile_t* percentile = qrtone_percentile_new();
@@ -737,6 +886,234 @@ MU_TEST(testSymbolsEncodingDecodingWithError) {
 
 
 
+MU_TEST(testSymbolsDecodingWithErasures) {
+	qrtone_t* qrtone = qrtone_new();
+	float sample_rate = 44100;
+	qrtone_init(qrtone, sample_rate);
+
+	int8_t payload[] = { 0x00, 0x04, 'n', 'i' , 'c' , 'o', 0x01, 0x05, 'h', 'e', 'l', 'l', 'o' };
+
+	int32_t block_symbols_size = 14;
+	int32_t block_ecc_symbols = 2;
+
+	qrtone_header_t* header = qrtone_header_new();
+	qrtone_header_init(header, sizeof(payload), block_symbols_size, block_ecc_symbols, 1, 0);
+	int32_t number_of_symbols = qrtone_header_get_number_of_symbols(header);
+
+	int8_t* symbols = malloc(number_of_symbols);
+	uint16_t* symbols_margin = malloc(sizeof(uint16_t) * number_of_symbols);
+	int8_t* symbols_scratch = malloc(number_of_symbols + block_symbols_size);
+	int8_t decoded_payload[sizeof(payload)];
+
+	qrtone_payload_to_symbols(qrtone, payload, sizeof(payload), block_symbols_size, block_ecc_symbols, qrtone_header_get_crc(header), symbols);
+
+	// Two errors in the first block, one more than the error capacity
+	int32_t i;
+	for (i = 0; i < number_of_symbols; i++) {
+		symbols_margin[i] = 0xFFFF;
+	}
+	symbols[0] = (symbols[0] + 5) % 16;
+	symbols[3] = (symbols[3] + 9) % 16;
+
+	mu_check(!qrtone_symbols_to_payload_buffer(qrtone, symbols, NULL, number_of_symbols, block_symbols_size, block_ecc_symbols, qrtone_header_get_crc(header), symbols_scratch, decoded_payload));
+
+	// Tones of the erroneous symbols were close to another tone
+	symbols_margin[0] = 128;
+	symbols_margin[3] = 256;
+
+	mu_check(qrtone_symbols_to_payload_buffer(qrtone, symbols, symbols_margin, number_of_symbols, block_symbols_size, block_ecc_symbols, qrtone_header_get_crc(header), symbols_scratch, decoded_payload));
+
+	mu_assert_int_array_eq(payload, sizeof(payload), decoded_payload, qrtone_header_get_length(header));
+
+	free(symbols);
+	free(symbols_margin);
+	free(symbols_scratch);
+	qrtone_free(qrtone);
+
+	free(qrtone);
+	free(header);
+}
+
+
+MU_TEST(testSymbolsSoftDecision) {
+	qrtone_t* qrtone = qrtone_new();
+	qrtone_init(qrtone, 44100);
+
+	int8_t payload[] = { 0x00, 0x04, 'n', 'i' , 'c' , 'o', 0x01, 0x05, 'h', 'e', 'l', 'l', 'o' };
+
+	int32_t block_symbols_size = 14;
+	int32_t block_ecc_symbols = 2;
+
+	qrtone_header_t* header = qrtone_header_new();
+	qrtone_header_init(header, sizeof(payload), block_symbols_size, block_ecc_symbols, 1, 0);
+	int32_t number_of_symbols = qrtone_header_get_number_of_symbols(header);
+
+	int8_t* symbols = malloc(number_of_symbols);
+	int8_t* symbols_runner_up = malloc(number_of_symbols);
+	uint16_t* symbols_margin = malloc(sizeof(uint16_t) * number_of_symbols);
+	int8_t* symbols_scratch = malloc(number_of_symbols + block_symbols_size);
+	int8_t decoded_payload[sizeof(payload)];
+
+	qrtone_payload_to_symbols(qrtone, payload, sizeof(payload), block_symbols_size, block_ecc_symbols, qrtone_header_get_crc(header), symbols);
+
+	// Three errors in the first block, one more than erasures could fix.
+	// Runner-up tones of the least reliable symbols were the transmitted ones
+	int32_t i;
+	for (i = 0; i < number_of_symbols; i++) {
+		symbols_runner_up[i] = (symbols[i] + 1) % 16;
+		symbols_margin[i] = (uint16_t)(2000 + i * 100);
+	}
+	int32_t errors[] = { 3, 0, 6 };
+	for (i = 0; i < 3; i++) {
+		symbols_runner_up[errors[i]] = symbols[errors[i]];
+		symbols[errors[i]] = (symbols[errors[i]] + 7) % 16;
+		symbols_margin[errors[i]] = (uint16_t)(200 + i * 100);
+	}
+
+	mu_check(!qrtone_symbols_to_payload_buffer(qrtone, symbols, symbols_margin, number_of_symbols, block_symbols_size, block_ecc_symbols, 1, symbols_scratch, decoded_payload));
+
+	int32_t fixed_errors = qrtone_get_fixed_errors(qrtone);
+
+	mu_check(qrtone_symbols_soft_decision(qrtone, symbols, symbols_runner_up, symbols_margin, number_of_symbols, block_symbols_size, block_ecc_symbols, symbols_scratch, decoded_payload));
+
+	mu_assert_int_array_eq(payload, sizeof(payload), decoded_payload, sizeof(payload));
+
+	// two substitutions and one error fixed by Reed-Solomon
+	mu_assert_int_eq(fixed_errors + 3, qrtone_get_fixed_errors(qrtone));
+
+	// hard decision symbols are restored
+	for (i = 0; i < 3; i++) {
+		mu_assert_int_eq((symbols_runner_up[errors[i]] + 7) % 16, symbols[errors[i]]);
+	}
+
+	free(symbols);
+	free(symbols_runner_up);
+	free(symbols_margin);
+	free(symbols_scratch);
+	qrtone_free(qrtone);
+	free(qrtone);
+	free(header);
+}
+
+
+typedef struct _test_messages_t {
+	int32_t length;
+	int32_t payload_length[3];
+	int8_t payload[3][64];
+	int64_t sample_index[3];
+} test_messages_t;
+
+void test_payload_callback(void* ptr, const qrtone_message_t* message) {
+	test_messages_t* messages = (test_messages_t*)ptr;
+	if (messages->length < 3) {
+		messages->payload_length[messages->length] = message->payload_length;
+		memcpy(messages->payload[messages->length], message->payload, message->payload_length);
+		messages->sample_index[messages->length] = message->sample_index;
+	}
+	messages->length++;
+}
+
+/**
+ * Generate messages sent one after the other at 0.1 of full scale, with offset_before samples before the first message and after the last one
+ * @param config Configuration of the emitter, NULL for the audible configuration
+ * @param noise_peak Peak of the pitch noise added to the signal, 0 to keep digital silence around the messages
+ * @param offsets Receives the first sample of each message, may be NULL
+ * @param total_length Receives the number of samples of the signal
+ * @return The signal, to free
+ */
+static float* test_generate_messages(float sample_rate, const qrtone_config_t* config, int8_t** payloads, const int32_t* payloads_length, int32_t messages_length, int32_t offset_before, float noise_peak, int32_t* offsets, int32_t* total_length) {
+	qrtone_t* qrtone = qrtone_new();
+	if (config != NULL) {
+		qrtone_init_config(qrtone, config, NULL);
+	} else {
+		qrtone_init(qrtone, sample_rate);
+	}
+	int32_t length = offset_before;
+	int32_t i;
+	for (i = 0; i < messages_length; i++) {
+		if (offsets != NULL) {
+			offsets[i] = length;
+		}
+		length += qrtone_get_message_length(qrtone, (uint8_t)payloads_length[i], QRTONE_ECC_Q, 1);
+	}
+	length += offset_before;
+	float* signal = calloc(length, sizeof(float));
+	int32_t cursor = offset_before;
+	for (i = 0; i < messages_length; i++) {
+		int32_t samples_length = qrtone_set_payload(qrtone, payloads[i], (uint8_t)payloads_length[i]);
+		qrtone_get_samples(qrtone, signal + cursor, samples_length, 0.1f);
+		cursor += samples_length;
+	}
+	if (noise_peak > 0) {
+		qrtone_generate_pitch(signal, length, 0, sample_rate, 125.0f, noise_peak);
+	}
+	qrtone_free(qrtone);
+	free(qrtone);
+	*total_length = length;
+	return signal;
+}
+
+/**
+ * Generate IPFS_PAYLOAD after offset_before samples, in pitch noise
+ * @see test_generate_messages
+ */
+static float* test_generate_message(float sample_rate, const qrtone_config_t* config, int32_t offset_before, float noise_peak, int32_t* total_length) {
+	int8_t* payloads[1] = { IPFS_PAYLOAD };
+	int32_t payloads_length[1] = { sizeof(IPFS_PAYLOAD) };
+	return test_generate_messages(sample_rate, config, payloads, payloads_length, 1, offset_before, noise_peak, NULL, total_length);
+}
+
+static int16_t* test_to_s16(const float* signal, int32_t length) {
+	int16_t* signal_s16 = malloc(sizeof(int16_t) * length);
+	int32_t i;
+	for (i = 0; i < length; i++) {
+		signal_s16[i] = (int16_t)(signal[i] * 32767);
+	}
+	return signal_s16;
+}
+
+/**
+ * Push the samples from cursor to end into the decoder
+ * @param signal_s16 int16 samples pushed with qrtone_push_samples_s16 instead of signal, NULL to push signal
+ * @param window_length Samples per push, 0 for qrtone_get_maximum_length
+ * @return Number of pushes that returned a payload
+ */
+static int32_t test_push_all(qrtone_t* qrtone, float* signal, const int16_t* signal_s16, int32_t cursor, int32_t end, int32_t window_length) {
+	int32_t received = 0;
+	while (cursor < end) {
+		int32_t window_size = MIN(window_length > 0 ? window_length : qrtone_get_maximum_length(qrtone), end - cursor);
+#ifdef QRTONE_FIXED_POINT
+		if (signal_s16 != NULL) {
+			received += qrtone_push_samples_s16(qrtone, signal_s16 + cursor, window_size);
+		} else
+#endif
+		{
+			received += qrtone_push_samples(qrtone, signal + cursor, window_size);
+		}
+		cursor += window_size;
+	}
+	return received;
+}
+
+MU_TEST(testMaximumLengthPushes) {
+	// At 44.1 kHz a push ending an analysis window also holds the first samples of the next word
+	float sample_rate = 44100;
+	int32_t offset_before = (int32_t)(sample_rate * 0.35);
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, NULL, offset_before, 0.003f, &total_length);
+
+	qrtone_t* qrtone_decoder = qrtone_new();
+	qrtone_init(qrtone_decoder, sample_rate);
+	mu_assert_int_eq(1, test_push_all(qrtone_decoder, signal, NULL, 0, total_length, 0));
+	if (qrtone_get_payload(qrtone_decoder) != NULL) {
+		mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), qrtone_get_payload(qrtone_decoder), qrtone_get_payload_length(qrtone_decoder));
+		mu_assert_double_eq(offset_before / sample_rate, qrtone_get_payload_sample_index(qrtone_decoder) / sample_rate, 0.01);
+	}
+	qrtone_free(qrtone_decoder);
+	free(qrtone_decoder);
+	free(signal);
+}
+
 MU_TEST(testReadArduino) {
 
 	qrtone_t* qrtone = qrtone_new();
@@ -781,12 +1158,1150 @@ MU_TEST(testReadArduino) {
 	free(qrtone);
 }
 
+#ifdef QRTONE_FIXED_POINT
+MU_TEST(testReadArduinoS16) {
+	qrtone_t* qrtone = qrtone_new();
+	qrtone_init(qrtone, 16000);
+
+	FILE* f = fopen("ipfs_16khz_16bits_mono.raw", "rb");
+	mu_check(f != NULL);
+
+	int16_t buffer[128];
+	const int32_t number_of_samples = sizeof(buffer) / sizeof(int16_t);
+	size_t res = number_of_samples;
+	while (res == number_of_samples) {
+		res = fread(buffer, sizeof(int16_t), number_of_samples, f);
+		if (qrtone_push_samples_s16(qrtone, buffer, res)) {
+			break;
+		}
+	}
+	fclose(f);
+
+	mu_assert(qrtone_get_payload(qrtone) != NULL, "no decoded message");
+	if (qrtone_get_payload(qrtone) != NULL) {
+		mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), qrtone_get_payload(qrtone), qrtone_get_payload_length(qrtone));
+	}
+
+	qrtone_free(qrtone);
+	free(qrtone);
+}
+
+MU_TEST(testGenerateS16) {
+	float sample_rate = 44100;
+	qrtone_t* qrtone = qrtone_new();
+	qrtone_init(qrtone, sample_rate);
+	int8_t payload[] = {0x48, 0x65, 0x6C, 0x6C, 0x6F, 0x20, 0x77, 0x6F, 0x72, 0x6C, 0x64};
+	int32_t samples_length = qrtone_set_payload(qrtone, payload, sizeof(payload));
+	int32_t offset_before = (int32_t)(sample_rate * 0.35);
+	int32_t total_length = offset_before + samples_length + offset_before;
+	float* signal = calloc(total_length, sizeof(float));
+	qrtone_get_samples(qrtone, signal + offset_before, samples_length, 0.1f);
+	qrtone_generate_pitch(signal, total_length, 0, sample_rate, 125.0f, 0.003f);
+	int16_t* signal_s16 = malloc(sizeof(int16_t) * total_length);
+	int32_t i;
+	for (i = 0; i < total_length; i++) {
+		signal_s16[i] = (int16_t)(signal[i] * 32767 + gaussrand() * 3);
+		signal[i] = signal_s16[i] / 32768.0f;
+	}
+
+	// Decode the same signal with the float and the fixed-point path
+	qrtone_t* decoders[2];
+	int8_t received[2] = {0, 0};
+	int32_t d;
+	for (d = 0; d < 2; d++) {
+		decoders[d] = qrtone_new();
+		qrtone_init(decoders[d], sample_rate);
+		int32_t cursor = 0;
+		while (cursor < total_length && !received[d]) {
+			int32_t window_size = MIN(qrtone_get_maximum_length(decoders[d]), total_length - cursor);
+			if (d == 0) {
+				received[d] = qrtone_push_samples(decoders[d], signal + cursor, window_size);
+			} else {
+				received[d] = qrtone_push_samples_s16(decoders[d], signal_s16 + cursor, window_size);
+			}
+			cursor += window_size;
+		}
+	}
+	mu_check(received[0]);
+	mu_check(received[1]);
+	if (received[1]) {
+		mu_assert_int_array_eq(payload, sizeof(payload), qrtone_get_payload(decoders[1]), qrtone_get_payload_length(decoders[1]));
+		mu_assert_int_eq(qrtone_get_payload_sample_index(decoders[0]), qrtone_get_payload_sample_index(decoders[1]));
+		mu_assert_int_eq(qrtone_get_fixed_errors(decoders[0]), qrtone_get_fixed_errors(decoders[1]));
+	}
+
+	for (d = 0; d < 2; d++) {
+		qrtone_free(decoders[d]);
+		free(decoders[d]);
+	}
+	free(signal_s16);
+	free(signal);
+	qrtone_free(qrtone);
+	free(qrtone);
+}
+
+MU_TEST(testGetSamplesS16) {
+	float sample_rate = 44100;
+	float power = 0.5f;
+	qrtone_t* qrtone = qrtone_new();
+	qrtone_init(qrtone, sample_rate);
+	qrtone_t* qrtone_s16 = qrtone_new();
+	qrtone_init(qrtone_s16, sample_rate);
+	int32_t samples_length = qrtone_set_payload(qrtone, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD));
+	mu_assert_int_eq(samples_length, qrtone_set_payload(qrtone_s16, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD)));
+	float* expected = calloc(samples_length, sizeof(float));
+	int16_t* got = calloc(samples_length, sizeof(int16_t));
+	qrtone_get_samples(qrtone, expected, samples_length, power);
+	int32_t cursor = 0;
+	while (cursor < samples_length) {
+		int32_t window_size = MIN((rand() % 500) + 1, samples_length - cursor);
+		qrtone_get_samples_s16(qrtone_s16, got + cursor, window_size, (int16_t)(power * 32767));
+		cursor += window_size;
+	}
+	// Compare the first gate tone with the exact waveform
+	int32_t gate_length = (int32_t)(sample_rate * 0.12f);
+	double frequency = 1720.0 * pow(1.0472941228206267, 16);
+	double max_error = 0;
+	int32_t i;
+	for (i = 0; i < gate_length; i++) {
+		double hann = 0.5 - 0.5 * cos(2 * M_PI * i / (gate_length - 1));
+		double exact = sin(2 * M_PI * frequency / sample_rate * i) * hann * power * 32767;
+		max_error = MAX(max_error, fabs(exact - got[i]));
+	}
+	mu_check(max_error <= 16);
+	// The float recurrences drift up to 2% of the amplitude
+	max_error = 0;
+	for (i = 0; i < samples_length; i++) {
+		max_error = MAX(max_error, fabs(expected[i] * 32767 - got[i]));
+	}
+	mu_check(max_error <= 0.025 * power * 32767);
+	free(expected);
+	free(got);
+	qrtone_free(qrtone);
+	free(qrtone);
+	qrtone_free(qrtone_s16);
+	free(qrtone_s16);
+}
+#endif
+
+MU_TEST(testArena) {
+	float sample_rate = 16000;
+	size_t required = qrtone_required_memory(sample_rate);
+	void* arena = malloc(required);
+	mu_check(qrtone_init_arena(arena, required - 1, sample_rate) == NULL);
+	qrtone_t* qrtone = qrtone_init_arena(arena, required, sample_rate);
+	mu_check(qrtone != NULL);
+	mu_assert_int_eq(0, qrtone_set_payload(qrtone, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD)));
+
+	FILE* f = fopen("ipfs_16khz_16bits_mono.raw", "rb");
+	mu_check(f != NULL);
+
+	int16_t buffer[128];
+	float window[128];
+	const int32_t number_of_samples = sizeof(buffer) / sizeof(int16_t);
+	size_t res = number_of_samples;
+	while (res == number_of_samples) {
+		res = fread(buffer, sizeof(int16_t), number_of_samples, f);
+		int32_t i;
+		for(i = 0; i < res; i++) {
+			window[i] = buffer[i] / 32767.0f;
+		}
+		if (qrtone_push_samples(qrtone, window, res)) {
+			break;
+		}
+	}
+	fclose(f);
+
+	mu_assert(qrtone_get_payload(qrtone) != NULL, "no decoded message");
+	if (qrtone_get_payload(qrtone) != NULL) {
+		mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), qrtone_get_payload(qrtone), qrtone_get_payload_length(qrtone));
+	}
+
+	qrtone_free(qrtone);
+	free(arena);
+}
+
+typedef struct _counting_allocator_t {
+	int32_t allocations;
+	size_t allocated; // currently allocated bytes
+	int32_t calls; // calls to malloc and free
+} counting_allocator_t;
+
+// block size is stored before the returned memory
+#define COUNTING_PREFIX 16
+
+void* counting_malloc(void* ptr, size_t size) {
+	counting_allocator_t* counter = (counting_allocator_t*)ptr;
+	counter->allocations += 1;
+	counter->allocated += size;
+	counter->calls += 1;
+	uint8_t* memory = malloc(size + COUNTING_PREFIX);
+	*((size_t*)memory) = size;
+	return memory + COUNTING_PREFIX;
+}
+
+void counting_free(void* ptr, void* memory) {
+	counting_allocator_t* counter = (counting_allocator_t*)ptr;
+	uint8_t* block = (uint8_t*)memory - COUNTING_PREFIX;
+	counter->allocations -= 1;
+	counter->allocated -= *((size_t*)block);
+	counter->calls += 1;
+	free(block);
+}
+
+MU_TEST(testCustomAllocator) {
+	counting_allocator_t counter = {0, 0, 0};
+	qrtone_allocator_t allocator = {counting_malloc, counting_free, &counter};
+	qrtone_t* qrtone = qrtone_new();
+	mu_assert_int_eq(1, qrtone_init_allocator(qrtone, 44100, &allocator));
+	mu_check(counter.allocations > 0);
+	mu_assert_int_eq(counter.allocated, qrtone_get_memory_usage(qrtone));
+	mu_check(qrtone_get_memory_peak(qrtone) >= qrtone_get_memory_usage(qrtone));
+	size_t init_usage = qrtone_get_memory_usage(qrtone);
+	// Sending allocate memory with the same allocator
+	mu_check(qrtone_set_payload(qrtone, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD)) > 0);
+	mu_check(qrtone_get_memory_peak(qrtone) > init_usage);
+	qrtone_free(qrtone);
+	mu_assert_int_eq(0, counter.allocations);
+	mu_assert_int_eq(0, counter.allocated);
+	mu_assert_int_eq(0, qrtone_get_memory_usage(qrtone));
+	free(qrtone);
+}
+
+// Allocations beyond the allowed count fail
+typedef struct _limited_allocator_t {
+	counting_allocator_t counter;
+	int32_t remaining;
+} limited_allocator_t;
+
+void* limited_malloc(void* ptr, size_t size) {
+	limited_allocator_t* limited = (limited_allocator_t*)ptr;
+	if (limited->remaining == 0) {
+		return NULL;
+	}
+	limited->remaining -= 1;
+	return counting_malloc(&(limited->counter), size);
+}
+
+void limited_free(void* ptr, void* memory) {
+	counting_free(&(((limited_allocator_t*)ptr)->counter), memory);
+}
+
+MU_TEST(testSetPayloadAllocationFailure) {
+	limited_allocator_t limited = {{0, 0, 0}, -1};
+	qrtone_allocator_t allocator = {limited_malloc, limited_free, &limited};
+	qrtone_t* qrtone = qrtone_new();
+	mu_assert_int_eq(1, qrtone_init_allocator(qrtone, 44100, &allocator));
+	size_t init_usage = limited.counter.allocated;
+	float samples[1024];
+	// symbols, header scratch and payload scratch
+	int32_t allowed;
+	for (allowed = 0; allowed < 3; allowed++) {
+		limited.remaining = allowed;
+		mu_assert_int_eq(0, qrtone_set_payload(qrtone, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD)));
+		mu_assert_int_eq((int32_t)init_usage, (int32_t)limited.counter.allocated);
+		// Nothing to send
+		memset(samples, 0, sizeof(samples));
+		qrtone_get_samples(qrtone, samples, 1024, 0.5f);
+	}
+	limited.remaining = 3;
+	mu_check(qrtone_set_payload(qrtone, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD)) > 0);
+	qrtone_free(qrtone);
+	mu_assert_int_eq(0, limited.counter.allocations);
+	free(qrtone);
+}
+
+MU_TEST(testPushWithoutAllocation) {
+	float sample_rate = 44100;
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, NULL, (int32_t)(sample_rate * 0.35), 0.003f, &total_length);
+
+	counting_allocator_t counter = {0, 0, 0};
+	qrtone_allocator_t allocator = {counting_malloc, counting_free, &counter};
+	qrtone_t* qrtone_decoder = qrtone_new();
+	mu_assert_int_eq(1, qrtone_init_allocator(qrtone_decoder, sample_rate, &allocator));
+	int32_t init_calls = counter.calls;
+	// The whole message is decoded with the buffers allocated by qrtone_init_allocator
+	mu_assert_int_eq(1, test_push_all(qrtone_decoder, signal, NULL, 0, total_length, 441));
+	mu_assert_int_eq(init_calls, counter.calls);
+	qrtone_free(qrtone_decoder);
+	free(qrtone_decoder);
+	free(signal);
+}
+
+MU_TEST(testProfile) {
+	float sample_rate = 16000;
+	qrtone_profile_t* profile = qrtone_profile_new();
+	mu_assert_int_eq(1, qrtone_profile_init(profile, sample_rate));
+	qrtone_t* decoders[2];
+	int32_t d;
+	for (d = 0; d < 2; d++) {
+		decoders[d] = qrtone_new();
+		mu_assert_int_eq(1, qrtone_init_profile(decoders[d], profile, NULL));
+	}
+	// Per stream memory does not contain the profile
+	qrtone_t* standalone = qrtone_new();
+	qrtone_init(standalone, sample_rate);
+	mu_check(qrtone_get_memory_usage(decoders[0]) < qrtone_get_memory_usage(standalone));
+	mu_check(qrtone_required_memory_profile(profile) < qrtone_required_memory(sample_rate));
+
+	FILE* f = fopen("ipfs_16khz_16bits_mono.raw", "rb");
+	mu_check(f != NULL);
+
+	int16_t buffer[128];
+	float window[128];
+	int8_t received[2] = {0, 0};
+	const int32_t number_of_samples = sizeof(buffer) / sizeof(int16_t);
+	size_t res = number_of_samples;
+	while (res == number_of_samples) {
+		res = fread(buffer, sizeof(int16_t), number_of_samples, f);
+		int32_t i;
+		for(i = 0; i < res; i++) {
+			window[i] = buffer[i] / 32767.0f;
+		}
+		for (d = 0; d < 2; d++) {
+			if (!received[d] && qrtone_push_samples(decoders[d], window, res)) {
+				received[d] = 1;
+			}
+		}
+	}
+	fclose(f);
+
+	for (d = 0; d < 2; d++) {
+		mu_assert(qrtone_get_payload(decoders[d]) != NULL, "no decoded message");
+		if (qrtone_get_payload(decoders[d]) != NULL) {
+			mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), qrtone_get_payload(decoders[d]), qrtone_get_payload_length(decoders[d]));
+		}
+	}
+
+	// Encoding with a shared profile produce the same signal
+	int32_t samples_length = qrtone_set_payload(decoders[0], IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD));
+	mu_assert_int_eq(samples_length, qrtone_set_payload(standalone, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD)));
+	float* expected = calloc(samples_length, sizeof(float));
+	float* got = calloc(samples_length, sizeof(float));
+	qrtone_get_samples(standalone, expected, samples_length, 0.5f);
+	qrtone_get_samples(decoders[0], got, samples_length, 0.5f);
+	mu_check(memcmp(expected, got, sizeof(float) * samples_length) == 0);
+	free(expected);
+	free(got);
+
+	for (d = 0; d < 2; d++) {
+		qrtone_free(decoders[d]);
+		free(decoders[d]);
+	}
+	qrtone_free(standalone);
+	free(standalone);
+	qrtone_profile_free(profile);
+	free(profile);
+}
+
+
+MU_TEST(testConfigFast) {
+	float sample_rate = 44100;
+	qrtone_config_t config;
+	// Highest tone is above the Nyquist frequency
+	qrtone_config_audible(&config, 8000);
+	mu_assert_int_eq(0, qrtone_config_check(&config));
+	qrtone_t* invalid = qrtone_new();
+	mu_assert_int_eq(0, qrtone_init_config(invalid, &config, NULL));
+	qrtone_free(invalid);
+	free(invalid);
+
+	qrtone_config_fast(&config, sample_rate);
+	mu_assert_int_eq(1, qrtone_config_check(&config));
+	int32_t offset_before = (int32_t)(sample_rate * 0.35);
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, &config, offset_before, 0.003f, &total_length);
+	int32_t samples_length = total_length - 2 * offset_before;
+	qrtone_config_t audible;
+	qrtone_config_audible(&audible, sample_rate);
+	qrtone_t* qrtone_audible = qrtone_new();
+	qrtone_init_config(qrtone_audible, &audible, NULL);
+	// words are twice shorter, the gates are only a third shorter
+	mu_check(samples_length * 19 <= 10 * qrtone_set_payload(qrtone_audible, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD)));
+	qrtone_free(qrtone_audible);
+	free(qrtone_audible);
+
+	qrtone_t* qrtone_decoder = qrtone_new();
+	mu_assert_int_eq(1, qrtone_init_config(qrtone_decoder, &config, NULL));
+	// Windows as long as allowed overlap two consecutive words
+	mu_assert_int_eq(1, test_push_all(qrtone_decoder, signal, NULL, 0, total_length, 0));
+	mu_assert(qrtone_get_payload(qrtone_decoder) != NULL, "no decoded message");
+	if (qrtone_get_payload(qrtone_decoder) != NULL) {
+		mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), qrtone_get_payload(qrtone_decoder), qrtone_get_payload_length(qrtone_decoder));
+	}
+	mu_assert_int_eq(0, qrtone_get_fixed_errors(qrtone_decoder));
+
+	free(signal);
+	qrtone_free(qrtone_decoder);
+	free(qrtone_decoder);
+}
+
+MU_TEST(testConfigInaudible) {
+	qrtone_config_t config;
+	qrtone_config_inaudible(&config, 16000);
+	mu_assert_int_eq(0, qrtone_config_check(&config));
+	float sample_rate = 48000;
+	qrtone_config_inaudible(&config, sample_rate);
+	mu_assert_int_eq(1, qrtone_config_check(&config));
+	int32_t offset_before = (int32_t)(sample_rate * 0.35);
+	int32_t total_length;
+	// Noise is added after the level measurement
+	float* signal = test_generate_message(sample_rate, &config, offset_before, 0, &total_length);
+	int32_t samples_length = total_length - 2 * offset_before;
+
+	// Tone tapers keep the message energy in the band, speech and music frequencies are left untouched
+	float levels[3];
+	const float frequencies[3] = { 1000.0f, 12000.0f, 19000.0f };
+	int32_t i;
+	for (i = 0; i < 3; i++) {
+		qrtone_goertzel_t* goertzel = qrtone_goertzel_new();
+		qrtone_goertzel_init(goertzel, sample_rate, frequencies[i], samples_length, 1);
+		qrtone_goertzel_process_samples(goertzel, signal + offset_before, samples_length);
+		levels[i] = 20 * log10f(qrtone_goertzel_compute_rms(goertzel));
+		qrtone_goertzel_free(goertzel);
+		free(goertzel);
+	}
+	mu_check(levels[0] < levels[2] - 100);
+	mu_check(levels[1] < levels[2] - 100);
+
+	qrtone_generate_pitch(signal, total_length, 0, sample_rate, 125.0f, 0.003f);
+	qrtone_t* qrtone_decoder = qrtone_new();
+	mu_assert_int_eq(1, qrtone_init_config(qrtone_decoder, &config, NULL));
+	mu_assert_int_eq(1, test_push_all(qrtone_decoder, signal, NULL, 0, total_length, 0));
+	mu_assert(qrtone_get_payload(qrtone_decoder) != NULL, "no decoded message");
+	if (qrtone_get_payload(qrtone_decoder) != NULL) {
+		mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), qrtone_get_payload(qrtone_decoder), qrtone_get_payload_length(qrtone_decoder));
+	}
+	// with the tight spacing the gate filters are one word long, the trigger location is less precise
+	mu_assert_double_eq(offset_before / sample_rate, qrtone_get_payload_sample_index(qrtone_decoder) / sample_rate, 0.015);
+
+	free(signal);
+	qrtone_free(qrtone_decoder);
+	free(qrtone_decoder);
+}
+
+typedef struct _trigger_levels_t {
+	int64_t peak_location;
+	float peak_level;
+} trigger_levels_t;
+
+void peak_level_callback(void* ptr, int64_t location, float first_tone_level, float second_tone_level, int32_t triggered) {
+	trigger_levels_t* levels = (trigger_levels_t*)ptr;
+	if (second_tone_level > levels->peak_level) {
+		levels->peak_level = second_tone_level;
+		levels->peak_location = location;
+	}
+}
+
+MU_TEST(testTriggerSlidingDft) {
+	float sample_rate = 44100;
+	qrtone_config_t config;
+	qrtone_config_audible(&config, sample_rate);
+	config.trigger_hop_ratio = 0.01f;
+	mu_assert_int_eq(0, qrtone_config_check(&config));
+	config.trigger_hop_ratio = 0.125f;
+	mu_assert_int_eq(1, qrtone_config_check(&config));
+
+	int32_t offset_before = (int32_t)(sample_rate * 0.35);
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, &config, offset_before, 0.003f, &total_length);
+
+	// With the same hop the sliding dft levels match the levels of the goertzel passes
+	trigger_levels_t levels[2];
+	int32_t pass;
+	for (pass = 0; pass < 2; pass++) {
+		qrtone_config_audible(&config, sample_rate);
+		config.trigger_hop_ratio = pass == 0 ? 0 : 0.5f;
+		qrtone_t* qrtone_decoder = qrtone_new();
+		mu_assert_int_eq(1, qrtone_init_config(qrtone_decoder, &config, NULL));
+		levels[pass].peak_level = -200.0f;
+		levels[pass].peak_location = -1;
+		qrtone_set_level_callback(qrtone_decoder, levels + pass, peak_level_callback);
+		// Stop before the first gate is complete
+		int32_t cursor = 0;
+		while (cursor < offset_before + (int32_t)(sample_rate * 0.12f)) {
+			int32_t window_size = qrtone_get_maximum_length(qrtone_decoder);
+			qrtone_push_samples(qrtone_decoder, signal + cursor, window_size);
+			cursor += window_size;
+		}
+		qrtone_free(qrtone_decoder);
+		free(qrtone_decoder);
+	}
+	// the goertzel passes are offset by window/2 rounded down, the locations of odd windows drift by a sample every window
+	mu_assert_double_eq(levels[0].peak_location / sample_rate, levels[1].peak_location / sample_rate, 0.001);
+	mu_assert_double_eq(levels[0].peak_level, levels[1].peak_level, 1.5);
+
+	// Finer hop, float and int16 samples
+	config.trigger_hop_ratio = 0.125f;
+	int32_t s16;
+	for (s16 = 0; s16 < 2; s16++) {
+#ifndef QRTONE_FIXED_POINT
+		if (s16) {
+			break;
+		}
+#endif
+		int16_t* signal_s16 = s16 ? test_to_s16(signal, total_length) : NULL;
+		qrtone_t* qrtone_decoder = qrtone_new();
+		mu_assert_int_eq(1, qrtone_init_config(qrtone_decoder, &config, NULL));
+		mu_assert_int_eq(1, test_push_all(qrtone_decoder, signal, signal_s16, 0, total_length, 0));
+		mu_assert(qrtone_get_payload(qrtone_decoder) != NULL, "no decoded message");
+		if (qrtone_get_payload(qrtone_decoder) != NULL) {
+			mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), qrtone_get_payload(qrtone_decoder), qrtone_get_payload_length(qrtone_decoder));
+		}
+		// the gate peak is located within about a hop, a quarter of the error of the goertzel passes
+		mu_assert_double_eq(offset_before / sample_rate, qrtone_get_payload_sample_index(qrtone_decoder) / sample_rate, 0.002);
+		qrtone_free(qrtone_decoder);
+		free(qrtone_decoder);
+		free(signal_s16);
+	}
+
+	free(signal);
+}
+
+MU_TEST(testLinkQuality) {
+	float sample_rate = 44100;
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, NULL, (int32_t)(sample_rate * 0.35), 0.003f, &total_length);
+
+	qrtone_header_t* header = qrtone_header_new();
+	qrtone_header_init(header, sizeof(IPFS_PAYLOAD), 12, 6, 1, QRTONE_ECC_Q);
+	int32_t number_of_symbols = qrtone_header_get_number_of_symbols(header);
+	qrtone_symbol_quality_t* symbols = malloc(sizeof(qrtone_symbol_quality_t) * number_of_symbols);
+	float level[2] = { 0, 0 };
+	float mean_margin[2] = { 0, 0 };
+	int32_t s16;
+	for (s16 = 0; s16 < 2; s16++) {
+#ifndef QRTONE_FIXED_POINT
+		if (s16) {
+			level[1] = level[0];
+			mean_margin[1] = mean_margin[0];
+			break;
+		}
+#endif
+		int16_t* signal_s16 = s16 ? test_to_s16(signal, total_length) : NULL;
+		qrtone_t* qrtone_decoder = qrtone_new();
+		qrtone_init(qrtone_decoder, sample_rate);
+		qrtone_link_quality_t quality;
+		qrtone_get_link_quality(qrtone_decoder, &quality);
+		mu_assert_int_eq(0, quality.symbols_length);
+		mu_assert_int_eq(1, test_push_all(qrtone_decoder, signal, signal_s16, 0, total_length, 0));
+		mu_assert(qrtone_get_payload(qrtone_decoder) != NULL, "no decoded message");
+		qrtone_get_link_quality(qrtone_decoder, &quality);
+		mu_assert_int_eq(number_of_symbols, quality.symbols_length);
+		mu_assert_int_eq(number_of_symbols, qrtone_get_symbols_quality(qrtone_decoder, symbols, number_of_symbols));
+		int32_t j;
+		for (j = 0; j < number_of_symbols; j++) {
+			mu_check(symbols[j].level >= symbols[j].runner_up_level);
+			mu_check(symbols[j].margin >= quality.min_margin);
+			mu_check(symbols[j].runner_up_level > symbols[j].noise_level);
+		}
+		mu_assert_double_eq(-35, quality.level, 3);
+		mu_check(quality.snr > 30);
+		mu_check(quality.min_margin > 6);
+		mu_check(quality.mean_margin < quality.snr);
+		mu_check(fabsf(quality.timing_offset) <= qrtone_get_gate_length(qrtone_decoder));
+		level[s16] = quality.level;
+		mean_margin[s16] = quality.mean_margin;
+		qrtone_free(qrtone_decoder);
+		free(qrtone_decoder);
+		free(signal_s16);
+	}
+	// the noise floor of int16 samples is higher, tones have the same levels
+	mu_assert_double_eq(level[0], level[1], 0.5);
+	mu_assert_double_eq(mean_margin[0], mean_margin[1], 0.5);
+
+	free(symbols);
+	free(signal);
+	free(header);
+}
+
+MU_TEST(testBackToBackMessages) {
+	float sample_rate = 44100;
+	int8_t second_payload[] = { 'h', 'e', 'l', 'l', 'o' };
+	int8_t* payloads[2] = { IPFS_PAYLOAD, second_payload };
+	int32_t payloads_length[2] = { sizeof(IPFS_PAYLOAD), sizeof(second_payload) };
+	int32_t offsets[2];
+	int32_t total_length;
+	// No gap between the two messages
+	float* signal = test_generate_messages(sample_rate, NULL, payloads, payloads_length, 2, (int32_t)(sample_rate * 0.35), 0.003f, offsets, &total_length);
+
+	test_messages_t messages;
+	messages.length = 0;
+	qrtone_t* qrtone_decoder = qrtone_new();
+	qrtone_init(qrtone_decoder, sample_rate);
+	qrtone_set_payload_callback(qrtone_decoder, &messages, test_payload_callback);
+	// Pushes end after the last tone of the first message
+	mu_assert_int_eq(2, test_push_all(qrtone_decoder, signal, NULL, 0, total_length, 4410));
+	mu_assert_int_eq(2, messages.length);
+	int32_t id_message;
+	for (id_message = 0; id_message < 2 && id_message < messages.length; id_message++) {
+		mu_assert_int_array_eq(payloads[id_message], payloads_length[id_message], messages.payload[id_message], messages.payload_length[id_message]);
+		mu_assert_double_eq(offsets[id_message] / sample_rate, messages.sample_index[id_message] / sample_rate, 0.01);
+	}
+
+	free(signal);
+	qrtone_free(qrtone_decoder);
+	free(qrtone_decoder);
+}
+
+MU_TEST(testFalseTriggerWhileParsing) {
+	float sample_rate = 44100;
+	qrtone_t* qrtone = qrtone_new();
+	qrtone_init(qrtone, sample_rate);
+	// The gates and the header of a long message are cut, the parser then decodes a bogus payload
+	int32_t cut_length = qrtone_set_payload(qrtone, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD));
+	float* cut = calloc(cut_length, sizeof(float));
+	qrtone_get_samples(qrtone, cut, cut_length, 0.1f);
+	cut_length = 2 * qrtone_get_gate_length(qrtone) + (int32_t)(sample_rate * 0.3);
+	qrtone_free(qrtone);
+	free(qrtone);
+	int8_t payload[] = { 'h', 'e', 'l', 'l', 'o' };
+	int8_t* payloads[1] = { payload };
+	int32_t payloads_length[1] = { sizeof(payload) };
+	int32_t offset_before = (int32_t)(sample_rate * 0.35);
+	// The message starts while the payload of the cut message is parsed
+	int32_t message_offset = offset_before + cut_length;
+	int32_t total_length;
+	float* signal = test_generate_messages(sample_rate, NULL, payloads, payloads_length, 1, message_offset, 0.003f, NULL, &total_length);
+	int32_t i;
+	for (i = 0; i < cut_length; i++) {
+		signal[offset_before + i] += cut[i];
+	}
+
+	qrtone_config_t config;
+	qrtone_config_audible(&config, sample_rate);
+	int32_t parsers;
+	for (parsers = 1; parsers <= 2; parsers++) {
+		config.parsers = parsers;
+		test_messages_t messages;
+		messages.length = 0;
+		qrtone_t* qrtone_decoder = qrtone_new();
+		mu_assert_int_eq(1, qrtone_init_config(qrtone_decoder, &config, NULL));
+		qrtone_set_payload_callback(qrtone_decoder, &messages, test_payload_callback);
+		test_push_all(qrtone_decoder, signal, NULL, 0, total_length, 0);
+		// A single parser is busy with the cut message when the message starts
+		mu_assert_int_eq(parsers - 1, messages.length);
+		if (messages.length == 1) {
+			mu_assert_int_array_eq(payload, sizeof(payload), messages.payload[0], messages.payload_length[0]);
+			mu_assert_double_eq(message_offset / sample_rate, messages.sample_index[0] / sample_rate, 0.01);
+		}
+		qrtone_free(qrtone_decoder);
+		free(qrtone_decoder);
+	}
+	free(cut);
+	free(signal);
+}
+
+MU_TEST(testPushAnySize) {
+	float sample_rate = 44100;
+	int8_t hello[] = { 'h', 'e', 'l', 'l', 'o' };
+	int8_t world[] = { 'w', 'o', 'r', 'l', 'd', '!' };
+	int8_t* payloads[3] = { hello, IPFS_PAYLOAD, world };
+	int32_t payloads_length[3] = { sizeof(hello), sizeof(IPFS_PAYLOAD), sizeof(world) };
+	int32_t offsets[3];
+	int32_t total_length;
+	float* signal = test_generate_messages(sample_rate, NULL, payloads, payloads_length, 3, (int32_t)(sample_rate * 0.35), 0.003f, offsets, &total_length);
+
+	// The whole signal in one push, then pushes of odd sizes
+	int32_t push_sizes[2] = { total_length, 333 };
+	int32_t id_push;
+	for (id_push = 0; id_push < 2; id_push++) {
+		test_messages_t messages;
+		messages.length = 0;
+		qrtone_t* qrtone_decoder = qrtone_new();
+		qrtone_init(qrtone_decoder, sample_rate);
+		qrtone_set_payload_callback(qrtone_decoder, &messages, test_payload_callback);
+		test_push_all(qrtone_decoder, signal, NULL, 0, total_length, push_sizes[id_push]);
+		mu_assert_int_eq(3, messages.length);
+		int32_t id_message;
+		for (id_message = 0; id_message < 3 && id_message < messages.length; id_message++) {
+			mu_assert_int_array_eq(payloads[id_message], payloads_length[id_message], messages.payload[id_message], messages.payload_length[id_message]);
+			mu_assert_double_eq(offsets[id_message] / sample_rate, messages.sample_index[id_message] / sample_rate, 0.01);
+		}
+		qrtone_free(qrtone_decoder);
+		free(qrtone_decoder);
+	}
+	free(signal);
+}
+
+typedef struct _test_owned_messages_t {
+	qrtone_t* qrtone;
+	int32_t length;
+	int8_t buffers[3][QRTONE_MAX_PAYLOAD_LENGTH];
+	int8_t* payload[2];
+	int32_t payload_length[2];
+	int32_t fixed_errors[2];
+	float mean_margin[2];
+} test_owned_messages_t;
+
+void test_owned_payload_callback(void* ptr, const qrtone_message_t* message) {
+	test_owned_messages_t* messages = (test_owned_messages_t*)ptr;
+	if (messages->length < 2) {
+		// Keep the payload buffer, the next payload is decoded into a new one
+		messages->payload[messages->length] = message->payload;
+		messages->payload_length[messages->length] = message->payload_length;
+		messages->fixed_errors[messages->length] = qrtone_get_fixed_errors(messages->qrtone) == message->quality.fixed_errors ? message->quality.fixed_errors : -1;
+		messages->mean_margin[messages->length] = message->quality.mean_margin;
+		qrtone_set_payload_buffer(messages->qrtone, messages->buffers[messages->length + 1]);
+	}
+	messages->length++;
+}
+
+MU_TEST(testPayloadBufferOwnership) {
+	float sample_rate = 44100;
+	int8_t hello[] = { 'h', 'e', 'l', 'l', 'o' };
+	int8_t* payloads[2] = { IPFS_PAYLOAD, hello };
+	int32_t payloads_length[2] = { sizeof(IPFS_PAYLOAD), sizeof(hello) };
+	int32_t total_length;
+	float* signal = test_generate_messages(sample_rate, NULL, payloads, payloads_length, 2, (int32_t)(sample_rate * 0.35), 0.003f, NULL, &total_length);
+
+	test_owned_messages_t messages;
+	messages.length = 0;
+	messages.qrtone = qrtone_new();
+	qrtone_init(messages.qrtone, sample_rate);
+	qrtone_set_payload_buffer(messages.qrtone, messages.buffers[0]);
+	qrtone_set_payload_callback(messages.qrtone, &messages, test_owned_payload_callback);
+	test_push_all(messages.qrtone, signal, NULL, 0, total_length, 1024);
+	mu_assert_int_eq(2, messages.length);
+	int32_t id_message;
+	for (id_message = 0; id_message < 2 && id_message < messages.length; id_message++) {
+		// Payloads are decoded in place into the caller buffers, without copy
+		mu_assert(messages.payload[id_message] == messages.buffers[id_message], "payload not decoded into the caller buffer");
+		mu_assert_int_array_eq(payloads[id_message], payloads_length[id_message], messages.payload[id_message], messages.payload_length[id_message]);
+		mu_assert_int_eq(0, messages.fixed_errors[id_message]);
+		mu_check(messages.mean_margin[id_message] > 0);
+	}
+	// Back to the internal buffer
+	qrtone_set_payload_buffer(messages.qrtone, NULL);
+	qrtone_free(messages.qrtone);
+	free(messages.qrtone);
+	free(signal);
+}
+
+MU_TEST(testSnapshotRestore) {
+	float sample_rate = 44100;
+	qrtone_t* qrtone = qrtone_new();
+	qrtone_init(qrtone, sample_rate);
+	int32_t offset_before = (int32_t)(sample_rate * 0.55);
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, NULL, offset_before, 0.003f, &total_length);
+	int32_t samples_length = total_length - 2 * offset_before;
+	size_t snapshot_capacity = 16384;
+	uint8_t* snapshot = malloc(snapshot_capacity);
+	// Move the stream before the message, in the gates and in the payload
+	int32_t cuts[3] = { offset_before / 2, offset_before + qrtone_get_gate_length(qrtone) + 50, offset_before + samples_length / 2 };
+	int32_t id_cut;
+	for (id_cut = 0; id_cut < 3; id_cut++) {
+		test_messages_t messages;
+		messages.length = 0;
+		qrtone_t* source = qrtone_new();
+		qrtone_init(source, sample_rate);
+		test_push_all(source, signal, NULL, 0, cuts[id_cut], 1024);
+		size_t snapshot_length = qrtone_snapshot(source, NULL, 0);
+		mu_check(snapshot_length <= snapshot_capacity);
+		mu_assert_int_eq((int32_t)snapshot_length, (int32_t)qrtone_snapshot(source, snapshot, snapshot_capacity));
+		qrtone_free(source);
+		free(source);
+
+		qrtone_t* destination = qrtone_new();
+		qrtone_init(destination, sample_rate);
+		qrtone_set_payload_callback(destination, &messages, test_payload_callback);
+		mu_check(qrtone_restore(destination, snapshot, snapshot_length));
+		test_push_all(destination, signal, NULL, cuts[id_cut], total_length, 1024);
+		mu_assert_int_eq(1, messages.length);
+		mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), messages.payload[0], messages.payload_length[0]);
+		mu_assert_double_eq(offset_before / sample_rate, messages.sample_index[0] / sample_rate, 0.01);
+		qrtone_free(destination);
+		free(destination);
+	}
+	// The snapshot is rejected by a decoder of another configuration, or if it is corrupted
+	qrtone_config_t config;
+	qrtone_config_fast(&config, sample_rate);
+	qrtone_t* other = qrtone_new();
+	qrtone_init_config(other, &config, NULL);
+	size_t snapshot_length = qrtone_snapshot(qrtone, snapshot, snapshot_capacity);
+	mu_check(!qrtone_restore(other, snapshot, snapshot_length));
+	qrtone_free(other);
+	free(other);
+	mu_check(qrtone_restore(qrtone, snapshot, snapshot_length));
+	snapshot[snapshot_length / 2] ^= 0x10;
+	mu_check(!qrtone_restore(qrtone, snapshot, snapshot_length));
+	mu_check(!qrtone_restore(qrtone, snapshot, snapshot_length - 1));
+	free(snapshot);
+	free(signal);
+	qrtone_free(qrtone);
+	free(qrtone);
+}
+
+/**
+ * Write the crc16 of a modified snapshot
+ */
+static void test_snapshot_sign(uint8_t* snapshot, size_t snapshot_length) {
+	qrtone_crc16_t* crc = qrtone_crc16_new();
+	qrtone_crc16_init(crc);
+	qrtone_crc16_add_array(crc, (int8_t*)snapshot, (int32_t)snapshot_length - 2);
+	int32_t value = qrtone_crc16_get(crc);
+	snapshot[snapshot_length - 2] = (uint8_t)(value & 0xFF);
+	snapshot[snapshot_length - 1] = (uint8_t)((value >> 8) & 0xFF);
+	free(crc);
+}
+
+MU_TEST(testSnapshotInvalidHeader) {
+	float sample_rate = 44100;
+	int32_t offset_before = (int32_t)(sample_rate * 0.55);
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, NULL, offset_before, 0.003f, &total_length);
+	qrtone_t* qrtone = qrtone_new();
+	qrtone_init(qrtone, sample_rate);
+	// Stop in the payload, the header of the message is decoded
+	test_push_all(qrtone, signal, NULL, 0, total_length / 2, 1024);
+	size_t snapshot_capacity = 16384;
+	uint8_t* snapshot = malloc(snapshot_capacity);
+	size_t snapshot_length = qrtone_snapshot(qrtone, snapshot, snapshot_capacity);
+	mu_check(snapshot_length <= snapshot_capacity);
+	// length, crc and ecc level of the header
+	uint8_t header[3] = { sizeof(IPFS_PAYLOAD), 1, QRTONE_ECC_Q };
+	size_t ecc_level_index = 0;
+	int32_t found = 0;
+	size_t i;
+	for (i = 0; i + 3 <= snapshot_length; i++) {
+		if (memcmp(snapshot + i, header, 3) == 0) {
+			ecc_level_index = i + 2;
+			found++;
+		}
+	}
+	mu_assert_int_eq(1, found);
+	qrtone_t* destination = qrtone_new();
+	qrtone_init(destination, sample_rate);
+	mu_check(qrtone_restore(destination, snapshot, snapshot_length));
+	// Out of range ecc level, and a valid level that does not match the length of the symbols
+	const uint8_t ecc_levels[2] = { 100, QRTONE_ECC_M };
+	int32_t id_level;
+	for (id_level = 0; id_level < 2; id_level++) {
+		snapshot[ecc_level_index] = ecc_levels[id_level];
+		test_snapshot_sign(snapshot, snapshot_length);
+		mu_assert_int_eq(0, qrtone_restore(destination, snapshot, snapshot_length));
+	}
+	free(snapshot);
+	free(signal);
+	qrtone_free(destination);
+	free(destination);
+	qrtone_free(qrtone);
+	free(qrtone);
+}
+
+MU_TEST(testDecimation) {
+	float sample_rate = 48000;
+	qrtone_config_t config;
+	qrtone_config_audible(&config, sample_rate);
+	// The highest tone of the band is above the Nyquist frequency of the decimated samples
+	config.decimation = 4;
+	mu_assert_int_eq(0, qrtone_config_check(&config));
+	config.decimation = 0;
+	mu_assert_int_eq(1, qrtone_config_check(&config));
+	int32_t offset_before = (int32_t)(sample_rate * 0.55);
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, NULL, offset_before, 0.003f, &total_length);
+	int32_t samples_length = total_length - 2 * offset_before;
+	size_t snapshot_capacity = 16384;
+	uint8_t* snapshot = malloc(snapshot_capacity);
+	// Samples indices are still expressed at the input sample rate, with or without a snapshot in the payload
+	int32_t cuts[2] = { 0, offset_before + samples_length / 2 };
+#ifdef QRTONE_FIXED_POINT
+	// The int16 samples go through the fixed point decimator
+	int16_t* signal_s16 = test_to_s16(signal, total_length);
+#else
+	int16_t* signal_s16 = NULL;
+#endif
+	int32_t s16;
+	for (s16 = 0; s16 < 2; s16++) {
+		if (s16 && signal_s16 == NULL) {
+			break;
+		}
+		int16_t* pushed_s16 = s16 ? signal_s16 : NULL;
+		int32_t id_cut;
+		for (id_cut = 0; id_cut < 2; id_cut++) {
+			test_messages_t messages;
+			messages.length = 0;
+			qrtone_t* qrtone_decoder = qrtone_new();
+			mu_assert_int_eq(1, qrtone_init_config(qrtone_decoder, &config, NULL));
+			test_push_all(qrtone_decoder, signal, pushed_s16, 0, cuts[id_cut], 1000);
+			if (cuts[id_cut] > 0) {
+				size_t snapshot_length = qrtone_snapshot(qrtone_decoder, snapshot, snapshot_capacity);
+				mu_check(snapshot_length <= snapshot_capacity);
+				qrtone_free(qrtone_decoder);
+				qrtone_init_config(qrtone_decoder, &config, NULL);
+				mu_check(qrtone_restore(qrtone_decoder, snapshot, snapshot_length));
+			}
+			qrtone_set_payload_callback(qrtone_decoder, &messages, test_payload_callback);
+			test_push_all(qrtone_decoder, signal, pushed_s16, cuts[id_cut], total_length, 1000);
+			mu_assert_int_eq(1, messages.length);
+			mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), messages.payload[0], messages.payload_length[0]);
+			mu_assert_double_eq(offset_before / sample_rate, messages.sample_index[0] / sample_rate, 0.01);
+			qrtone_free(qrtone_decoder);
+			free(qrtone_decoder);
+		}
+	}
+	free(signal_s16);
+	free(snapshot);
+	free(signal);
+}
+
+#ifdef QRTONE_FIXED_POINT
+MU_TEST(testDecimatorFixedPoint) {
+	// The Q15 filter of int16 samples must follow the float filter within a few least significant bits
+	float sample_rate = 48000;
+	qrtone_config_t config;
+	qrtone_config_audible(&config, sample_rate);
+	config.decimation = 0;
+	qrtone_profile_t* profile = qrtone_profile_new();
+	mu_assert_int_eq(1, qrtone_profile_init_config(profile, &config));
+	int32_t window_length = 4096;
+	float* window = malloc(sizeof(float) * window_length);
+	int16_t* window_s16 = malloc(sizeof(int16_t) * window_length);
+	int32_t i;
+	srand(1);
+	for (i = 0; i < window_length; i++) {
+		window[i] = (float)rand() / (float)RAND_MAX - 0.5f;
+	}
+	// full scale square wave at the end, the sum of the taps must not overflow
+	for (i = window_length / 2; i < window_length; i++) {
+		window[i] = (i / 3) % 2 == 0 ? 32767.0f / 32768.0f : -1.0f;
+	}
+	for (i = 0; i < window_length; i++) {
+		window_s16[i] = (int16_t)floorf(window[i] * 32768.0f + 0.5f);
+		window[i] = window_s16[i] / 32768.0f;
+	}
+	for (i = 0; i < window_length / 2; i += 97) {
+		float expected = qrtone_decimator_filter(profile, window + i) * 32768.0f;
+		if (expected > 32767.0f) {
+			expected = 32767.0f;
+		} else if (expected < -32768.0f) {
+			expected = -32768.0f;
+		}
+		mu_assert_double_eq(expected, qrtone_decimator_filter_s16(profile, window_s16 + i), 2.0);
+	}
+	free(window_s16);
+	free(window);
+	qrtone_profile_free(profile);
+	free(profile);
+}
+#endif
+
+MU_TEST(testTriggerDigitalSilence) {
+	// The gate windows of digital silence have no energy, their level must stay finite
+	float sample_rate = 44100;
+	int32_t offset_before = (int32_t)(sample_rate * 2);
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, NULL, offset_before, 0, &total_length);
+	qrtone_t* qrtone_decoder = qrtone_new();
+	qrtone_init(qrtone_decoder, sample_rate);
+	mu_assert_int_eq(1, test_push_all(qrtone_decoder, signal, NULL, 0, total_length, 1000));
+	if (qrtone_get_payload(qrtone_decoder) != NULL) {
+		mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), qrtone_get_payload(qrtone_decoder), qrtone_get_payload_length(qrtone_decoder));
+		mu_assert_double_eq(offset_before / sample_rate, qrtone_get_payload_sample_index(qrtone_decoder) / sample_rate, 0.01);
+	}
+	qrtone_free(qrtone_decoder);
+	free(qrtone_decoder);
+	free(signal);
+}
+
+MU_TEST(testTriggerSlidingDftDigitalSilence) {
+	// The sliding dft levels of digital silence must stay finite too
+	float sample_rate = 44100;
+	int32_t offset_before = (int32_t)(sample_rate * 2);
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, NULL, offset_before, 0, &total_length);
+	float hop_ratios[2] = { 0.5f, 0.125f };
+	int32_t id_hop;
+	for (id_hop = 0; id_hop < 2; id_hop++) {
+		int32_t s16;
+		for (s16 = 0; s16 < 2; s16++) {
+#ifndef QRTONE_FIXED_POINT
+			if (s16) {
+				break;
+			}
+#endif
+			int16_t* signal_s16 = s16 ? test_to_s16(signal, total_length) : NULL;
+			qrtone_config_t config;
+			qrtone_config_audible(&config, sample_rate);
+			config.trigger_hop_ratio = hop_ratios[id_hop];
+			qrtone_t* qrtone_decoder = qrtone_new();
+			mu_assert_int_eq(1, qrtone_init_config(qrtone_decoder, &config, NULL));
+			mu_assert_int_eq(1, test_push_all(qrtone_decoder, signal, signal_s16, 0, total_length, 1000));
+			if (qrtone_get_payload(qrtone_decoder) != NULL) {
+				mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), qrtone_get_payload(qrtone_decoder), qrtone_get_payload_length(qrtone_decoder));
+				mu_assert_double_eq(offset_before / sample_rate, qrtone_get_payload_sample_index(qrtone_decoder) / sample_rate, 0.01);
+			}
+			qrtone_free(qrtone_decoder);
+			free(qrtone_decoder);
+			free(signal_s16);
+		}
+	}
+	free(signal);
+}
+
+MU_TEST(testTriggerIdleLevel) {
+	float sample_rate = 44100;
+	qrtone_config_t config;
+	qrtone_config_audible(&config, sample_rate);
+	config.trigger_idle_level = 10;
+	mu_assert_int_eq(0, qrtone_config_check(&config));
+	config.trigger_idle_level = -70;
+	mu_assert_int_eq(1, qrtone_config_check(&config));
+	// The message is surrounded by digital silence, the gate windows are skipped
+	int32_t offset_before = (int32_t)(sample_rate * 2);
+	int32_t total_length;
+	float* signal = test_generate_message(sample_rate, NULL, offset_before, 0, &total_length);
+	// Without and with the idle level the trigger sees the same levels at the same locations
+	int32_t s16;
+	for (s16 = 0; s16 < 2; s16++) {
+#ifndef QRTONE_FIXED_POINT
+		if (s16) {
+			break;
+		}
+#endif
+		int16_t* signal_s16 = s16 ? test_to_s16(signal, total_length) : NULL;
+		int64_t sample_index[2];
+		trigger_levels_t levels[2];
+		int32_t pass;
+		for (pass = 0; pass < 2; pass++) {
+			config.trigger_idle_level = pass == 0 ? 0 : -70;
+			test_messages_t messages;
+			messages.length = 0;
+			qrtone_t* qrtone_decoder = qrtone_new();
+			mu_assert_int_eq(1, qrtone_init_config(qrtone_decoder, &config, NULL));
+			qrtone_set_payload_callback(qrtone_decoder, &messages, test_payload_callback);
+			levels[pass].peak_level = -200.0f;
+			levels[pass].peak_location = -1;
+			qrtone_set_level_callback(qrtone_decoder, levels + pass, peak_level_callback);
+			test_push_all(qrtone_decoder, signal, signal_s16, 0, total_length, 1000);
+			mu_assert_int_eq(1, messages.length);
+			mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), messages.payload[0], messages.payload_length[0]);
+			mu_assert_double_eq(offset_before / sample_rate, messages.sample_index[0] / sample_rate, 0.01);
+			sample_index[pass] = messages.sample_index[0];
+			qrtone_free(qrtone_decoder);
+			free(qrtone_decoder);
+		}
+		mu_assert_int_eq((int32_t)sample_index[0], (int32_t)sample_index[1]);
+		mu_check(levels[0].peak_location >= 0);
+		mu_assert_int_eq((int32_t)levels[0].peak_location, (int32_t)levels[1].peak_location);
+		free(signal_s16);
+	}
+	free(signal);
+}
+
+MU_TEST(testRing) {
+	float buffer[8];
+	qrtone_ring_t ring;
+	mu_check(!qrtone_ring_init(&ring, buffer, 6));
+	mu_check(qrtone_ring_init(&ring, buffer, 8));
+	float samples[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+	int32_t length;
+	qrtone_ring_read_region(&ring, &length);
+	mu_assert_int_eq(0, length);
+	mu_assert_int_eq(5, qrtone_ring_write(&ring, samples, 5));
+	float* region = qrtone_ring_read_region(&ring, &length);
+	mu_assert_int_eq(5, length);
+	mu_assert_double_eq(0, region[0], 1e-6);
+	qrtone_ring_release(&ring, 3);
+	// 3 samples at the end of the buffer, 3 samples at the start, 1 sample dropped
+	mu_assert_int_eq(6, qrtone_ring_write(&ring, samples + 5, 7));
+	qrtone_ring_stats_t stats;
+	qrtone_ring_get_stats(&ring, &stats);
+	mu_assert_int_eq(8, stats.available);
+	mu_assert_int_eq(8, stats.peak_fill);
+	mu_assert_int_eq(1, (int32_t)stats.overruns);
+	mu_assert_int_eq(1, (int32_t)stats.dropped_samples);
+	// contiguous regions
+	region = qrtone_ring_read_region(&ring, &length);
+	mu_assert_int_eq(5, length);
+	float expected_end[5] = { 3, 4, 5, 6, 7 };
+	int32_t i;
+	for (i = 0; i < length; i++) {
+		mu_assert_double_eq(expected_end[i], region[i], 1e-6);
+	}
+	qrtone_ring_release(&ring, length);
+	region = qrtone_ring_read_region(&ring, &length);
+	mu_assert_int_eq(3, length);
+	float expected_start[3] = { 8, 9, 10 };
+	for (i = 0; i < length; i++) {
+		mu_assert_double_eq(expected_start[i], region[i], 1e-6);
+	}
+	mu_check(region == buffer);
+	qrtone_ring_release(&ring, length);
+	// zero copy write, int16 right channel of stereo frames
+	float* write_region = qrtone_ring_write_region(&ring, &length);
+	mu_assert_int_eq(5, length);
+	write_region[0] = 0.5f;
+	qrtone_ring_commit(&ring, 1, 0);
+	int16_t stereo[6] = { 1, 16384, 2, -16384, 3, 8192 };
+	mu_assert_int_eq(3, qrtone_ring_write_s16(&ring, stereo + 1, 3, 2));
+	float expected_s16[4] = { 0.5f, 0.5f, -0.5f, 0.25f };
+	region = qrtone_ring_read_region(&ring, &length);
+	mu_assert_int_eq(4, length);
+	for (i = 0; i < length; i++) {
+		mu_assert_double_eq(expected_s16[i], region[i], 1e-6);
+	}
+	qrtone_ring_release(&ring, length);
+	qrtone_ring_get_stats(&ring, &stats);
+	mu_assert_int_eq(0, stats.available);
+	mu_assert_int_eq(1, (int32_t)stats.overruns);
+}
+
+MU_TEST(testRingDrain) {
+	float sample_rate = 44100;
+	int32_t offset = (int32_t)(sample_rate * 0.35);
+	int32_t total_length;
+	float* samples = test_generate_message(sample_rate, NULL, offset, 0, &total_length);
+	int16_t* signal = test_to_s16(samples, total_length);
+	free(samples);
+
+	// Capture callbacks of 128 samples, decoded after each second callback as in the examples
+	test_messages_t messages;
+	messages.length = 0;
+	qrtone_t* qrtone_decoder = qrtone_new();
+	qrtone_init(qrtone_decoder, sample_rate);
+	qrtone_set_payload_callback(qrtone_decoder, &messages, test_payload_callback);
+	float buffer[512];
+	qrtone_ring_t ring;
+	mu_check(qrtone_ring_init(&ring, buffer, 512));
+	int32_t cursor = 0;
+	int32_t received = 0;
+	int32_t callbacks = 0;
+	while (cursor < total_length) {
+		int32_t window_size = MIN(128, total_length - cursor);
+		mu_assert_int_eq(window_size, qrtone_ring_write_s16(&ring, signal + cursor, window_size, 1));
+		cursor += window_size;
+		if (++callbacks % 2 == 0) {
+			received += qrtone_ring_drain(&ring, qrtone_decoder);
+		}
+	}
+	received += qrtone_ring_drain(&ring, qrtone_decoder);
+	mu_assert_int_eq(1, received);
+	mu_assert_int_eq(1, messages.length);
+	mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), messages.payload[0], messages.payload_length[0]);
+	mu_assert_double_eq(offset / sample_rate, messages.sample_index[0] / sample_rate, 0.01);
+	qrtone_ring_stats_t stats;
+	qrtone_ring_get_stats(&ring, &stats);
+	mu_assert_int_eq(0, stats.available);
+	mu_assert_int_eq(256, stats.peak_fill);
+	mu_assert_int_eq(0, (int32_t)stats.overruns);
+	qrtone_free(qrtone_decoder);
+	free(qrtone_decoder);
+	free(signal);
+}
 
 MU_TEST_SUITE(test_suite) {
 	MU_RUN_TEST(testCRC8);
 	MU_RUN_TEST(testCRC16);
 	MU_RUN_TEST(test1khz);
 	MU_RUN_TEST(test1khzIterative);
+	MU_RUN_TEST(testGoertzelBank);
+#ifdef QRTONE_FIXED_POINT
+	MU_RUN_TEST(testGoertzelBankFixed);
+#endif
 	MU_RUN_TEST(testPercentile);
 	MU_RUN_TEST(testCircularArray);
 	MU_RUN_TEST(testPeakFinder1);
@@ -796,11 +2311,43 @@ MU_TEST_SUITE(test_suite) {
 	MU_RUN_TEST(testPeakFinding);
 	MU_RUN_TEST(testSymbolsInterleaving);
     MU_RUN_TEST(testGenerate);
+	MU_RUN_TEST(testMaximumLengthPushes);
 	//MU_RUN_TEST(testWriteSignal);
 	MU_RUN_TEST(testHeaderEncodeDecode);
 	MU_RUN_TEST(testSymbolsEncodingDecoding);
 	MU_RUN_TEST(testSymbolsEncodingDecodingWithError);
+	MU_RUN_TEST(testSymbolsDecodingWithErasures);
+	MU_RUN_TEST(testSymbolsSoftDecision);
 	MU_RUN_TEST(testReadArduino);
+#ifdef QRTONE_FIXED_POINT
+	MU_RUN_TEST(testReadArduinoS16);
+	MU_RUN_TEST(testGenerateS16);
+	MU_RUN_TEST(testGetSamplesS16);
+#endif
+	MU_RUN_TEST(testArena);
+	MU_RUN_TEST(testCustomAllocator);
+	MU_RUN_TEST(testSetPayloadAllocationFailure);
+	MU_RUN_TEST(testPushWithoutAllocation);
+	MU_RUN_TEST(testProfile);
+	MU_RUN_TEST(testConfigFast);
+	MU_RUN_TEST(testConfigInaudible);
+	MU_RUN_TEST(testTriggerSlidingDft);
+	MU_RUN_TEST(testLinkQuality);
+	MU_RUN_TEST(testBackToBackMessages);
+	MU_RUN_TEST(testFalseTriggerWhileParsing);
+	MU_RUN_TEST(testPushAnySize);
+	MU_RUN_TEST(testPayloadBufferOwnership);
+	MU_RUN_TEST(testSnapshotRestore);
+	MU_RUN_TEST(testSnapshotInvalidHeader);
+	MU_RUN_TEST(testDecimation);
+#ifdef QRTONE_FIXED_POINT
+	MU_RUN_TEST(testDecimatorFixedPoint);
+#endif
+	MU_RUN_TEST(testTriggerDigitalSilence);
+	MU_RUN_TEST(testTriggerSlidingDftDigitalSilence);
+	MU_RUN_TEST(testTriggerIdleLevel);
+	MU_RUN_TEST(testRing);
+	MU_RUN_TEST(testRingDrain);
 }
 
 int main(int argc, char** argv) {
@@ -0,0 +1,199 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) Unité Mixte de Recherche en Acoustique Environnementale (univ-gustave-eiffel)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *  Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ *  Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "qrtone.h"
+#include "qrtone_scanner.h"
+#include "minunit.h"
+
+#define SCAN_SAMPLE_RATE 16000
+#define SCAN_MESSAGES 4
+
+int8_t IPFS_PAYLOAD[] = { 18, 32, -117, -93, -50, 2, 52, 26, -117, 93, 119, -109, 39, 46, 108, 4, 31, 36, -100, 95, -9, -70, -82, -93, -75, -32, -63, 42, -44, -100, 50, 83, -118, 114 };
+
+// Message start in seconds. With 16 kHz and 34 bytes payloads chunks are 28.2 s long every 21.2 s:
+// the third message crosses the end of the first chunk, the last one is found in two chunks
+static const float MESSAGES_TIME[SCAN_MESSAGES] = { 0.5f, 20.0f, 27.0f, 43.0f };
+
+static uint32_t noise_state = 1;
+
+// Deterministic noise in [-1, 1]
+static float scan_noise(void) {
+	noise_state = noise_state * 1664525u + 1013904223u;
+	return ((int32_t)(noise_state >> 8) - (1 << 23)) / (float)(1 << 23);
+}
+
+static int16_t* scan_generate_recording(int64_t* samples_length, int32_t channels) {
+	*samples_length = (int64_t)(SCAN_SAMPLE_RATE * 55);
+	float* signal = calloc((size_t)*samples_length, sizeof(float));
+	qrtone_t* qrtone = qrtone_new();
+	qrtone_init(qrtone, SCAN_SAMPLE_RATE);
+	int32_t i;
+	for (i = 0; i < SCAN_MESSAGES; i++) {
+		IPFS_PAYLOAD[0] = (int8_t)i;
+		int32_t message_length = qrtone_set_payload_ext(qrtone, IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), QRTONE_ECC_Q, 1);
+		qrtone_get_samples(qrtone, signal + (int64_t)(MESSAGES_TIME[i] * SCAN_SAMPLE_RATE), message_length, 0.1f);
+	}
+	qrtone_free(qrtone);
+	free(qrtone);
+	int16_t* recording = malloc(sizeof(int16_t) * (size_t)(*samples_length * channels));
+	int64_t s;
+	for (s = 0; s < *samples_length; s++) {
+		int32_t c;
+		for (c = 0; c < channels; c++) {
+			recording[s * channels + c] = (int16_t)((c == 0 ? signal[s] * 32767 : 0) + scan_noise() * 3);
+		}
+	}
+	free(signal);
+	return recording;
+}
+
+static void scan_check_messages(qrtone_scan_message_t* messages, int32_t messages_length) {
+	mu_assert_int_eq(SCAN_MESSAGES, messages_length);
+	int32_t m;
+	for (m = 0; m < SCAN_MESSAGES && m < messages_length; m++) {
+		IPFS_PAYLOAD[0] = (int8_t)m;
+		mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), messages[m].payload, messages[m].payload_length);
+		mu_check(llabs(messages[m].sample_index - (int64_t)(MESSAGES_TIME[m] * SCAN_SAMPLE_RATE)) < SCAN_SAMPLE_RATE / 100);
+	}
+}
+
+MU_TEST(testScanSamples) {
+	int64_t samples_length;
+	int16_t* recording = scan_generate_recording(&samples_length, 1);
+	qrtone_scan_options_t options;
+	qrtone_scan_options_init(&options);
+	options.threads = 4;
+	options.max_payload_length = sizeof(IPFS_PAYLOAD);
+	qrtone_scan_message_t* messages;
+	int32_t messages_length = qrtone_scan_samples(recording, samples_length, 1, SCAN_SAMPLE_RATE, &options, &messages);
+	scan_check_messages(messages, messages_length);
+
+	// Same messages with a single thread
+	options.threads = 1;
+	qrtone_scan_message_t* single_messages;
+	int32_t single_messages_length = qrtone_scan_samples(recording, samples_length, 1, SCAN_SAMPLE_RATE, &options, &single_messages);
+	mu_assert_int_eq(messages_length, single_messages_length);
+	if (messages_length == single_messages_length && messages_length > 0) {
+		mu_check(memcmp(messages, single_messages, sizeof(qrtone_scan_message_t) * messages_length) == 0);
+	}
+	free(single_messages);
+	free(messages);
+
+	// No decoder at a sample rate too low for the tones
+	mu_assert_int_eq(-1, qrtone_scan_samples(recording, samples_length, 1, 1000, &options, &messages));
+	mu_check(messages == NULL);
+	free(recording);
+}
+
+static void scan_write_u32(FILE* f, uint32_t v) {
+	uint8_t data[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+	fwrite(data, 1, 4, f);
+}
+
+static void scan_write_u16(FILE* f, uint16_t v) {
+	uint8_t data[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+	fwrite(data, 1, 2, f);
+}
+
+MU_TEST(testScanWav) {
+	const int32_t channels = 2;
+	int64_t samples_length;
+	int16_t* recording = scan_generate_recording(&samples_length, channels);
+	uint32_t data_length = (uint32_t)(samples_length * channels * sizeof(int16_t));
+	FILE* f = fopen("scan_stereo.wav", "wb");
+	mu_check(f != NULL);
+	fwrite("RIFF", 1, 4, f);
+	scan_write_u32(f, 4 + 8 + 16 + 8 + 4 + 8 + data_length);
+	fwrite("WAVE", 1, 4, f);
+	fwrite("fmt ", 1, 4, f);
+	scan_write_u32(f, 16);
+	scan_write_u16(f, 1);
+	scan_write_u16(f, (uint16_t)channels);
+	scan_write_u32(f, SCAN_SAMPLE_RATE);
+	scan_write_u32(f, SCAN_SAMPLE_RATE * channels * 2);
+	scan_write_u16(f, (uint16_t)(channels * 2));
+	scan_write_u16(f, 16);
+	// chunk that must be skipped
+	fwrite("LIST", 1, 4, f);
+	scan_write_u32(f, 4);
+	fwrite("INFO", 1, 4, f);
+	fwrite("data", 1, 4, f);
+	scan_write_u32(f, data_length);
+	fwrite(recording, sizeof(int16_t), (size_t)(samples_length * channels), f);
+	fclose(f);
+	free(recording);
+
+	qrtone_scan_file_t file;
+	mu_check(qrtone_scan_file_open(&file, "scan_stereo.wav", 44100));
+	mu_assert_int_eq(channels, file.channels);
+	mu_check(file.sample_rate == SCAN_SAMPLE_RATE);
+	mu_check(file.samples_length == samples_length);
+	qrtone_scan_message_t* messages;
+	int32_t messages_length = qrtone_scan_samples(file.samples, file.samples_length, file.channels, file.sample_rate, NULL, &messages);
+	scan_check_messages(messages, messages_length);
+	free(messages);
+	qrtone_scan_file_close(&file);
+	remove("scan_stereo.wav");
+}
+
+MU_TEST(testScanRaw) {
+	qrtone_scan_file_t file;
+	mu_check(qrtone_scan_file_open(&file, "ipfs_16khz_16bits_mono.raw", 16000));
+	qrtone_scan_message_t* messages;
+	int32_t messages_length = qrtone_scan_samples(file.samples, file.samples_length, file.channels, file.sample_rate, NULL, &messages);
+	mu_assert_int_eq(1, messages_length);
+	if (messages_length == 1) {
+		IPFS_PAYLOAD[0] = 18;
+		mu_assert_int_array_eq(IPFS_PAYLOAD, sizeof(IPFS_PAYLOAD), messages[0].payload, messages[0].payload_length);
+	}
+	free(messages);
+	qrtone_scan_file_close(&file);
+}
+
+MU_TEST_SUITE(test_suite) {
+	MU_RUN_TEST(testScanSamples);
+	MU_RUN_TEST(testScanWav);
+	MU_RUN_TEST(testScanRaw);
+}
+
+int main(int argc, char** argv) {
+	MU_RUN_SUITE(test_suite);
+	MU_REPORT();
+	return minunit_status == 1 || minunit_fail > 0 ? -1 : 0;
+}
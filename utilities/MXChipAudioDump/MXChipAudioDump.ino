@@ -109,18 +109,17 @@ void loop(void)
       last_color = 2;
     }
     int sample_to_read = scaled_input_buffer_feed_cursor - scaled_input_buffer_consume_cursor;
-    int max_window_length = qrtone_get_maximum_length(qrtone);
     int sample_index = 0;
     while(sample_index < sample_to_read) {
       int32_t position_in_buffer = ((scaled_input_buffer_consume_cursor + sample_index) % MAX_AUDIO_WINDOW_SIZE);
-      int32_t window_length = min(max_window_length, min(sample_to_read - sample_index, MAX_AUDIO_WINDOW_SIZE - position_in_buffer % MAX_AUDIO_WINDOW_SIZE));
+      // Push all samples up to the end of the circular buffer
+      int32_t window_length = min(sample_to_read - sample_index, MAX_AUDIO_WINDOW_SIZE - position_in_buffer);
       if(qrtone_push_samples(qrtone, scaled_input_buffer + position_in_buffer, window_length)) {
         // Got a message
         rgbLed.setColor(0, 0, RGB_LED_BRIGHTNESS);
         Serial.write((const char *) qrtone_get_payload(qrtone), qrtone_get_payload_length(qrtone));
       }
       sample_index += window_length;
-      max_window_length = qrtone_get_maximum_length(qrtone);      
     }
     scaled_input_buffer_consume_cursor += sample_index;
   }